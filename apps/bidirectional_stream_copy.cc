@@ -4,6 +4,7 @@
 #include "eventloop.hh"
 
 #include <algorithm>
+#include <functional>
 #include <iostream>
 #include <unistd.h>
 
@@ -16,8 +17,8 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
   EventLoop _eventloop {};
   FileDescriptor _input { STDIN_FILENO };
   FileDescriptor _output { STDOUT_FILENO };
-  ByteStream _outbound { buffer_size };
-  ByteStream _inbound { buffer_size };
+  ByteStream _outbound { buffer_size, ByteStream::Storage::Mapped };
+  ByteStream _inbound { buffer_size, ByteStream::Storage::Mapped };
   bool _outbound_shutdown { false };
   bool _inbound_shutdown { false };
 
@@ -25,107 +26,123 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
   _input.set_blocking( false );
   _output.set_blocking( false );
 
+  // Each rule is armed while it can make progress. Instead of the EventLoop asking every rule about that on every
+  // iteration, a rule re-arms itself after running, and the streams' watermark callbacks re-arm the rules on the
+  // other end of a stream when it becomes readable or writable.
+  function<void()> update_outbound_rules;
+  function<void()> update_inbound_rules;
+
+  // an error on either stream stops both directions
+  auto set_errors = [&] {
+    _outbound.set_error();
+    _inbound.set_error();
+    update_outbound_rules();
+    update_inbound_rules();
+  };
+
   // rule 1: read from stdin into outbound byte stream
-  _eventloop.add_rule(
+  auto rule1 = _eventloop.add_rule(
     "read from stdin into outbound byte stream",
     _input,
     Direction::In,
     [&] {
-      string data;
-      data.resize( _outbound.writer().available_capacity() );
-      _input.read( data );
-      _outbound.writer().push( move( data ) );
+      _outbound.writer().read_from( _input );
       if ( _input.eof() ) {
         _outbound.writer().close();
       }
+      update_outbound_rules();
     },
-    [&] {
-      return !_outbound.has_error() and !_inbound.has_error() and ( _outbound.writer().available_capacity() > 0 )
-             and !_outbound.writer().is_closed();
-    },
+    nullptr,
     [&] { _outbound.writer().close(); },
     [&] {
       cerr << "DEBUG: Outbound stream had error from source.\n";
-      _outbound.set_error();
-      _inbound.set_error();
+      set_errors();
     } );
 
   // rule 2: read from outbound byte stream into socket
-  _eventloop.add_rule(
+  auto rule2 = _eventloop.add_rule(
     "read from outbound byte stream into socket",
     socket,
     Direction::Out,
     [&] {
-      if ( _outbound.reader().bytes_buffered() ) {
-        _outbound.reader().pop( socket.write( _outbound.reader().peek() ) );
-      }
+      _outbound.reader().write_to( socket );
       if ( _outbound.reader().is_finished() ) {
         socket.shutdown( SHUT_WR );
         _outbound_shutdown = true;
         cerr << "DEBUG: Outbound stream to " << peer_name << " finished.\n";
       }
+      update_outbound_rules();
     },
-    [&] {
-      return _outbound.reader().bytes_buffered() or ( _outbound.reader().is_finished() and not _outbound_shutdown );
-    },
+    nullptr,
     [&] { _outbound.writer().close(); },
     [&] {
       cerr << "DEBUG: Outbound stream had error from destination.\n";
-      _outbound.set_error();
-      _inbound.set_error();
+      set_errors();
     } );
 
   // rule 3: read from socket into inbound byte stream
-  _eventloop.add_rule(
+  auto rule3 = _eventloop.add_rule(
     "read from socket into inbound byte stream",
     socket,
     Direction::In,
     [&] {
-      string data;
-      data.resize( _inbound.writer().available_capacity() );
-      socket.read( data );
-      _inbound.writer().push( move( data ) );
+      _inbound.writer().read_from( socket );
       if ( socket.eof() ) {
         _inbound.writer().close();
       }
+      update_inbound_rules();
     },
-    [&] {
-      return !_inbound.has_error() and !_outbound.has_error() and ( _inbound.writer().available_capacity() > 0 )
-             and !_inbound.writer().is_closed();
-    },
+    nullptr,
     [&] { _inbound.writer().close(); },
     [&] {
       cerr << "DEBUG: Inbound stream had error from source.\n";
-      _outbound.set_error();
-      _inbound.set_error();
+      set_errors();
     } );
 
   // rule 4: read from inbound byte stream into stdout
-  _eventloop.add_rule(
+  auto rule4 = _eventloop.add_rule(
     "read from inbound byte stream into stdout",
     _output,
     Direction::Out,
     [&] {
-      if ( _inbound.reader().bytes_buffered() ) {
-        _inbound.reader().pop( _output.write( _inbound.reader().peek() ) );
-      }
+      _inbound.reader().write_to( _output );
       if ( _inbound.reader().is_finished() ) {
         _output.close();
         _inbound_shutdown = true;
         cerr << "DEBUG: Inbound stream from " << peer_name << " finished"
              << ( _inbound.has_error() ? " uncleanly.\n" : ".\n" );
       }
+      update_inbound_rules();
     },
-    [&] {
-      return _inbound.reader().bytes_buffered() or ( _inbound.reader().is_finished() and not _inbound_shutdown );
-    },
+    nullptr,
     [&] { _inbound.writer().close(); },
     [&] {
       cerr << "DEBUG: Inbound stream had error from destination.\n";
-      _outbound.set_error();
-      _inbound.set_error();
+      set_errors();
     } );
 
+  update_outbound_rules = [&] {
+    const bool any_errors = _outbound.has_error() or _inbound.has_error();
+    rule1.set_armed( not any_errors and _outbound.writer().available_capacity() > 0
+                     and not _outbound.writer().is_closed() );
+    rule2.set_armed( _outbound.reader().bytes_buffered()
+                     or ( _outbound.reader().is_finished() and not _outbound_shutdown ) );
+  };
+  update_inbound_rules = [&] {
+    const bool any_errors = _outbound.has_error() or _inbound.has_error();
+    rule3.set_armed( not any_errors and _inbound.writer().available_capacity() > 0
+                     and not _inbound.writer().is_closed() );
+    rule4.set_armed( _inbound.reader().bytes_buffered()
+                     or ( _inbound.reader().is_finished() and not _inbound_shutdown ) );
+  };
+
+  _outbound.on_readable( update_outbound_rules );
+  _outbound.on_writable( update_outbound_rules );
+  _inbound.on_readable( update_inbound_rules );
+  _inbound.on_writable( update_inbound_rules );
+  update_outbound_rules();
+  update_inbound_rules();
+
   // loop until completion
   while ( true ) {
     if ( EventLoop::Result::Exit == _eventloop.wait_next_event( -1 ) ) {
@@ -130,9 +130,13 @@ public:
 
     InternetDatagram dgram = move( _interface.datagrams_received().front() );
     _interface.datagrams_received().pop();
-    return unwrap_tcp_in_ip( dgram );
+    return unwrap_tcp_in_ip( move( dgram ) );
+  }
+  void write( const TCPMessage& msg )
+  {
+    wrap_tcp_in_datagrams( msg,
+                           [&]( const InternetDatagram& dgram ) { _interface.send_datagram( dgram, _next_hop ); } );
   }
-  void write( const TCPMessage& msg ) { _interface.send_datagram( wrap_tcp_in_ip( msg ), _next_hop ); }
   void tick( const size_t ms_since_last_tick ) { _interface.tick( ms_since_last_tick ); }
   NetworkInterface& interface() { return _interface; }
 
@@ -35,6 +35,8 @@ void show_usage( const char* argv0, const char* msg )
 
        << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n\n"
 
+       << "   -c <algo>       Congestion control: none, newreno or cubic      newreno\n\n"
+
        << "   -d <tundev>     Connect to tun <tundev>                         " << TUN_DFLT << "\n\n"
 
        << "   -Lu <loss>      Set uplink loss to <rate> (float in 0..1)       (no loss)\n"
@@ -96,6 +98,21 @@ tuple<TCPConfig, FdAdapterConfig, bool, const char*> get_config( const span<char
       c_fsm.rt_timeout = strtol( args[curr + 1], nullptr, 0 );
       curr += 2;
 
+    } else if ( strncmp( "-c", args[curr], 3 ) == 0 ) {
+      check_argc( args, curr, "ERROR: -c requires one argument." );
+      const string algorithm = args[curr + 1];
+      if ( algorithm == "none" ) {
+        c_fsm.congestion_control = CongestionControl::Algorithm::None;
+      } else if ( algorithm == "newreno" ) {
+        c_fsm.congestion_control = CongestionControl::Algorithm::NewReno;
+      } else if ( algorithm == "cubic" ) {
+        c_fsm.congestion_control = CongestionControl::Algorithm::Cubic;
+      } else {
+        show_usage( args[0], ( "ERROR: unknown congestion control " + algorithm ).c_str() );
+        exit( 1 );
+      }
+      curr += 2;
+
     } else if ( strncmp( "-d", args[curr], 3 ) == 0 ) {
       check_argc( args, curr, "ERROR: -t requires one argument." );
       tundev = args[curr + 1];
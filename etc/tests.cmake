@@ -23,6 +23,15 @@ ttest(byte_stream_one_write)
 ttest(byte_stream_two_writes)
 ttest(byte_stream_many_writes)
 ttest(byte_stream_stress_test)
+ttest(byte_stream_wrap)
+ttest(byte_stream_chunked)
+ttest(byte_stream_reserve)
+ttest(byte_stream_watermarks)
+ttest(byte_stream_spill)
+ttest(spsc_byte_stream)
+ttest(spsc_socket_handoff)
+ttest(buffer_pool)
+ttest(buffer)
 
 ttest(reassembler_single)
 ttest(reassembler_cap)
@@ -31,6 +40,7 @@ ttest(reassembler_dup)
 ttest(reassembler_holes)
 ttest(reassembler_overlapping)
 ttest(reassembler_win)
+ttest(reassembler_in_place)
 
 ttest(wrapping_integers_cmp)
 ttest(wrapping_integers_wrap)
@@ -45,6 +55,10 @@ ttest(recv_reorder)
 ttest(recv_reorder_more)
 ttest(recv_close)
 ttest(recv_special)
+ttest(recv_sack)
+ttest(recv_delayed_ack)
+ttest(recv_window_scale)
+ttest(recv_timestamps)
 
 ttest(send_connect)
 ttest(send_transmit)
@@ -53,6 +67,17 @@ ttest(send_window)
 ttest(send_ack)
 ttest(send_close)
 ttest(send_extra)
+ttest(send_congestion)
+ttest(send_rto)
+ttest(send_fast_retx)
+ttest(send_sack)
+ttest(send_rack_tlp)
+ttest(send_window_scale)
+ttest(send_timestamps)
+ttest(send_mss)
+ttest(send_pacing)
+ttest(send_gso)
+ttest(send_lossy_link)
 
 ttest(net_interface)
 
@@ -76,6 +101,10 @@ add_custom_target (check6 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --s
 
 add_custom_target (speed COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --timeout 12 -R '_speed_test')
 
+add_custom_target (benchmark COMMAND "${CMAKE_BINARY_DIR}/tests/byte_stream_benchmark" --format json
+                   COMMAND "${CMAKE_BINARY_DIR}/tests/reassembler_benchmark" --format json
+                   DEPENDS byte_stream_benchmark reassembler_benchmark)
+
 set(compile_name_opt "compile with optimization")
 add_test(NAME ${compile_name_opt}
   COMMAND "${CMAKE_COMMAND}" --build "${CMAKE_BINARY_DIR}" -t speed_testing)
@@ -89,4 +118,12 @@ set_property(TEST ${compile_name_opt} PROPERTY TIMEOUT 0)
 set_tests_properties(${compile_name_opt} PROPERTIES FIXTURES_SETUP compile_opt)
 
 stest(byte_stream_speed_test)
+stest(spsc_byte_stream_speed_test)
 stest(reassembler_speed_test)
+stest(tcp_peer_memory_test)
+
+add_test(NAME byte_stream_benchmark_quick COMMAND byte_stream_benchmark --quick)
+set_property(TEST byte_stream_benchmark_quick PROPERTY FIXTURES_REQUIRED compile_opt)
+
+add_test(NAME reassembler_benchmark_quick COMMAND reassembler_benchmark --quick)
+set_property(TEST reassembler_benchmark_quick PROPERTY FIXTURES_REQUIRED compile_opt)
@@ -1,14 +1,113 @@
 #include "byte_stream.hh"
 
+#include <algorithm>
+#include <cstring>
+
 using namespace std;
 
-ByteStream::ByteStream( uint64_t capacity ) : capacity_( capacity ), content_( capacity_ + 1, ' ' )
+ByteStream::ByteStream( uint64_t capacity, Storage storage, BufferPool* pool )
+  : capacity_( capacity ), storage_( storage ), content_()
+{
+  if ( storage_ == Storage::Mapped ) {
+    mapped_.emplace( capacity_ );
+  }
+  if ( storage_ == Storage::Pooled ) {
+    pool_ = pool ? pool : &BufferPool::global();
+  }
+}
+
+void ByteStream::grow_ring( uint64_t len )
+{
+  const uint64_t buffered = pushed_cnt_ - popped_cnt_;
+  if ( mapped_ or buffered + len <= content_.size() ) {
+    return;
+  }
+  const uint64_t kept = buffered + max( staged_, ring_reserved_ ); // staged and reserved bytes move along
+
+  // at least double, so a stream that fills up slowly is copied only a few times
+  uint64_t size = max( buffered + len, 2 * static_cast<uint64_t>( content_.size() ) );
+  size = min( capacity_, ( size + kPageSize - 1 ) / kPageSize * kPageSize );
+
+  string grown( size, 0 );
+  const uint64_t first_part = min( kept, content_.size() - begin_ );
+  memcpy( grown.data(), content_.data() + begin_, first_part );
+  memcpy( grown.data() + first_part, content_.data(), kept - first_part );
+  content_ = move( grown );
+  begin_ = 0;
+}
+
+void ByteStream::release_buffer()
+{
+  if ( pushed_cnt_ != popped_cnt_ or staged_ ) {
+    return;
+  }
+
+  begin_ = 0;
+  ring_reserved_ = 0;
+  string().swap( content_ );
+  string().swap( reserved_ );
+  chunks_.shrink_to_fit();
+  pages_.clear();
+  pages_.shrink_to_fit();
+  if ( mapped_ ) {
+    mapped_->page_out( 0, mapped_->size() );
+    spilled_cnt_ = pushed_cnt_;
+  }
+}
+
+void ByteStream::set_error()
+{
+  error_ = true;
+  notify_watermarks();
+}
+
+void ByteStream::on_readable( function<void()> callback, uint64_t low_watermark )
+{
+  readable_callback_ = move( callback );
+  low_watermark_ = low_watermark;
+  was_readable_ = is_readable();
+}
+
+void ByteStream::on_writable( function<void()> callback, uint64_t free_watermark )
 {
-  if ( capacity_ + 1 == 0 ) {
-    std::cerr << "to big capacity" << std::endl;
-    error_ = true;
+  writable_callback_ = move( callback );
+  free_watermark_ = free_watermark;
+  was_writable_ = is_writable();
+}
+
+void ByteStream::notify_watermarks()
+{
+  // update the state before calling back, which may well push or pop again
+  if ( readable_callback_ and is_readable() != was_readable_ ) {
+    was_readable_ = not was_readable_;
+    if ( was_readable_ ) {
+      readable_callback_();
+    }
+  }
+  if ( writable_callback_ and is_writable() != was_writable_ ) {
+    was_writable_ = not was_writable_;
+    if ( was_writable_ ) {
+      writable_callback_();
+    }
+  }
+}
+
+void ByteStream::spill()
+{
+  if ( pushed_cnt_ < kMappedWindow ) {
     return;
   }
+  const uint64_t first = max( spilled_cnt_, popped_cnt_ + kMappedWindow );
+  const uint64_t last = pushed_cnt_ - kMappedWindow;
+  if ( first >= last or last - first < kMappedWindow / 4 ) {
+    return; // not worth a syscall yet
+  }
+
+  const uint64_t start = ring_index( first - popped_cnt_ );
+  const uint64_t first_part = min( last - first, capacity_ - start );
+  mapped_->page_out( start, first_part );
+  mapped_->page_out( 0, last - first - first_part );
+  spilled_cnt_ = last;
 }
 
 bool Writer::is_closed() const
@@ -24,36 +123,161 @@ void Writer::push( string data )
     return;
   }
 
-  // check if need to move begin to head
-  if ( end_ + data.size() > capacity_ ) { // direct copy
-    // move begin to head
-    content_.replace( 0, end_ - begin_, content_, begin_, end_ - begin_ );
-    end_ = end_ - begin_;
-    begin_ = 0;
+  const uint64_t len = min( static_cast<uint64_t>( data.size() ), available_capacity() );
+  if ( len == 0 ) {
+    return;
+  }
+
+  if ( storage_ == Storage::Chunked ) {
+    data.resize( len );
+    pushed_cnt_ += len;
+    if ( not chunks_.empty() and chunks_.back().append_in_place( data ) ) {
+      // fits in the spare room of the last chunk, which does not reallocate
+    } else if ( data.capacity() / 2 > len ) {
+      chunks_.emplace_back( string( data ) ); // don't let a mostly-empty allocation stay alive for a few bytes
+    } else {
+      chunks_.emplace_back( move( data ) );
+    }
+    notify_watermarks();
+    return;
+  }
+
+  push_bytes( string_view( data ).substr( 0, len ) );
+}
+
+void Writer::push( Buffer data )
+{
+  if ( is_closed_ ) {
+    return;
+  }
+
+  const uint64_t len = min( static_cast<uint64_t>( data.size() ), available_capacity() );
+  if ( len == 0 ) {
+    return;
   }
 
-  if ( end_ + data.size() <= capacity_ ) { // copy all data
-    content_.replace( end_, data.size(), data );
-    pushed_cnt_ += data.size();
-    end_ += data.size();
+  if ( storage_ == Storage::Chunked ) {
+    data.remove_suffix( data.size() - len );
+    pushed_cnt_ += len;
+    if ( not chunks_.empty() and chunks_.back().append_in_place( data ) ) {
+      // fits in the spare room of the last chunk, which does not reallocate
+    } else if ( data.footprint() / 2 > len ) {
+      chunks_.emplace_back( string( data ) ); // don't keep a mostly-unused string alive for a small slice of it
+    } else {
+      chunks_.push_back( move( data ) );
+    }
+    notify_watermarks();
+    return;
+  }
+
+  push_bytes( string_view( data ).substr( 0, len ) );
+}
+
+void Writer::push_bytes( string_view data )
+{
+  const uint64_t len = data.size();
+  if ( storage_ == Storage::Pooled ) {
+    const uint64_t page_size = pool_->page_size();
+    for ( uint64_t written = 0; written < len; ) {
+      // offset of the end of the buffered bytes, from the start of the front page
+      const uint64_t end = begin_ + ( pushed_cnt_ - popped_cnt_ );
+      if ( end == pages_.size() * page_size ) {
+        pages_.push_back( pool_->get() );
+      }
+      const uint64_t in_page = end - ( pages_.size() - 1 ) * page_size;
+      const uint64_t part = min( len - written, page_size - in_page );
+      memcpy( pages_.back().data() + in_page, data.data() + written, part );
+      written += part;
+      pushed_cnt_ += part;
+    }
   } else {
-    content_.replace( end_, capacity_ - end_, data, 0, capacity_ - end_ );
-    pushed_cnt_ += ( capacity_ - end_ );
-    end_ = capacity_;
+    // the buffered bytes never move (unless the ring grows): copy behind them, wrapping around the end of the ring
+    staged_ = 0;
+    ring_reserved_ = 0;
+    grow_ring( len );
+    const uint64_t tail = ring_index( pushed_cnt_ - popped_cnt_ );
+    const uint64_t first_part = min( len, ring_size() - tail );
+    memcpy( ring() + tail, data.data(), first_part );
+    memcpy( ring(), data.data() + first_part, len - first_part );
+    pushed_cnt_ += len;
+
+    if ( storage_ == Storage::Mapped ) {
+      spill();
+    }
+  }
+
+  notify_watermarks();
+}
+
+array<span<char>, 2> Writer::reserve( uint64_t len )
+{
+  if ( is_closed_ ) {
+    return {};
+  }
+  len = min( len, available_capacity() );
+
+  if ( storage_ == Storage::Chunked or storage_ == Storage::Pooled ) {
+    reserved_.resize( len );
+    return { span<char>( reserved_ ), span<char>() };
   }
+
+  staged_ = 0;
+  ring_reserved_ = 0;
+  grow_ring( len );
+  ring_reserved_ = len;
+  const uint64_t tail = ring_index( pushed_cnt_ - popped_cnt_ );
+  const uint64_t first_part = min( len, ring_size() - tail );
+  return { span<char>( ring() + tail, first_part ), span<char>( ring(), len - first_part ) };
+}
+
+void Writer::stage( uint64_t offset, string_view data )
+{
+  if ( is_closed_ or offset >= available_capacity() ) {
+    return;
+  }
+  data = data.substr( 0, available_capacity() - offset );
+
+  grow_ring( max( staged_, offset + data.size() ) );
+  const uint64_t start = ring_index( pushed_cnt_ - popped_cnt_ + offset );
+  const uint64_t first_part = min( static_cast<uint64_t>( data.size() ), ring_size() - start );
+  memcpy( ring() + start, data.data(), first_part );
+  memcpy( ring(), data.data() + first_part, data.size() - first_part );
+  staged_ = max( staged_, offset + data.size() );
+}
+
+void Writer::commit( uint64_t len )
+{
+  if ( storage_ == Storage::Chunked or storage_ == Storage::Pooled ) {
+    reserved_.resize( min( len, static_cast<uint64_t>( reserved_.size() ) ) );
+    push( move( reserved_ ) );
+    reserved_.clear();
+    return;
+  }
+
+  if ( not is_closed_ ) {
+    len = min( len, max( ring_reserved_, staged_ ) ); // only what the ring has room for
+    pushed_cnt_ += len;
+    staged_ = staged_ > len ? staged_ - len : 0;
+    ring_reserved_ = 0;
+  }
+  if ( storage_ == Storage::Mapped ) {
+    spill();
+  }
+  notify_watermarks();
 }
 
 void Writer::close()
 {
   // Your code here.
   is_closed_ = true;
+  notify_watermarks();
 }
 
 // How many bytes can be pushed to the stream right now?
 uint64_t Writer::available_capacity() const
 {
   // Your code here.
-  return capacity_ - ( end_ - begin_ );
+  return capacity_ - ( pushed_cnt_ - popped_cnt_ );
 }
 
 uint64_t Writer::bytes_pushed() const
@@ -65,7 +289,7 @@ uint64_t Writer::bytes_pushed() const
 bool Reader::is_finished() const
 {
   // Your code here.
-  return is_closed_ && ( begin_ == end_ );
+  return is_closed_ && ( pushed_cnt_ == popped_cnt_ );
 }
 
 uint64_t Reader::bytes_popped() const
@@ -77,25 +301,136 @@ uint64_t Reader::bytes_popped() const
 string_view Reader::peek() const
 {
   // Your code here.
-  return string_view( content_.data() + begin_, end_ - begin_ );
+  // only the part before the wrap point is contiguous, the rest is seen after popping it
+  return peek_spans()[0];
+}
+
+array<string_view, 2> Reader::peek_spans() const
+{
+  if ( storage_ == Storage::Chunked ) {
+    array<string_view, 2> spans {};
+    if ( not chunks_.empty() ) {
+      spans[0] = string_view( chunks_.front() ).substr( begin_ );
+    }
+    if ( chunks_.size() > 1 ) {
+      spans[1] = chunks_[1];
+    }
+    return spans;
+  }
+
+  if ( storage_ == Storage::Pooled ) {
+    const uint64_t page_size = pool_->page_size();
+    const uint64_t buffered = bytes_buffered();
+    const uint64_t first_part = min( buffered, page_size - begin_ );
+    if ( first_part == 0 ) {
+      return {};
+    }
+    return { string_view( pages_[0].data() + begin_, first_part ),
+             string_view( pages_.size() > 1 ? pages_[1].data() : nullptr,
+                          min( buffered - first_part, page_size ) ) };
+  }
+
+  const uint64_t buffered = bytes_buffered();
+  const uint64_t first_part = min( buffered, ring_size() - begin_ );
+  return { string_view( ring() + begin_, first_part ), string_view( ring(), buffered - first_part ) };
+}
+
+Buffer Reader::slice( uint64_t offset, uint64_t len ) const
+{
+  const uint64_t buffered = bytes_buffered();
+  offset = min( offset, buffered );
+  len = min( len, buffered - offset );
+  if ( len == 0 ) {
+    return {};
+  }
+
+  string out;
+  if ( storage_ == Storage::Chunked ) {
+    // find the chunk, starting from the last slice's (a sender slices its way forward through the stream)
+    const uint64_t index = popped_cnt_ + offset;
+    if ( slice_chunk_ < popped_chunks_ or index < slice_start_ ) {
+      slice_chunk_ = popped_chunks_;
+      slice_start_ = popped_cnt_ - begin_;
+    }
+    while ( index >= slice_start_ + chunks_[slice_chunk_ - popped_chunks_].size() ) {
+      slice_start_ += chunks_[slice_chunk_ - popped_chunks_].size();
+      ++slice_chunk_;
+    }
+
+    uint64_t skip = index - slice_start_;
+    if ( skip + len <= chunks_[slice_chunk_ - popped_chunks_].size() ) {
+      return chunks_[slice_chunk_ - popped_chunks_].substr( skip, len );
+    }
+    out.reserve( len );
+    for ( uint64_t i = slice_chunk_ - popped_chunks_; out.size() < len; ++i, skip = 0 ) {
+      out.append( string_view( chunks_[i] ).substr( skip, len - out.size() ) );
+    }
+    return out;
+  }
+
+  out.reserve( len );
+  if ( storage_ == Storage::Pooled ) {
+    const uint64_t page_size = pool_->page_size();
+    for ( uint64_t pos = begin_ + offset; out.size() < len; ) {
+      const uint64_t in_page = min( len - out.size(), page_size - pos % page_size );
+      out.append( pages_[pos / page_size].data() + pos % page_size, in_page );
+      pos += in_page;
+    }
+    return out;
+  }
+
+  const uint64_t start = ring_index( offset );
+  const uint64_t first_part = min( len, ring_size() - start );
+  out.append( ring() + start, first_part );
+  out.append( ring(), len - first_part );
+  return out;
 }
 
 // Remove `len` bytes from the buffer
 void Reader::pop( uint64_t len )
 {
   // Your code here.
-  if ( begin_ + len <= end_ ) {
+  if ( len > bytes_buffered() ) {
+    std::cerr << "pop len greater than size" << std::endl;
+    len = bytes_buffered();
+  }
+
+  popped_cnt_ += len;
+
+  if ( storage_ == Storage::Chunked ) {
+    // free every chunk that is now fully popped
+    while ( len > 0 ) {
+      const uint64_t in_front = min( len, chunks_.front().size() - begin_ );
+      begin_ += in_front;
+      len -= in_front;
+      if ( begin_ == chunks_.front().size() ) {
+        chunks_.pop_front();
+        ++popped_chunks_;
+        begin_ = 0;
+      }
+    }
+  } else if ( storage_ == Storage::Pooled ) {
+    // give back every page that is now fully popped (a vector, unlike a deque, costs nothing while empty)
     begin_ += len;
-    popped_cnt_ += len;
+    const uint64_t popped_pages = begin_ / pool_->page_size();
+    pages_.erase( pages_.begin(), pages_.begin() + static_cast<ptrdiff_t>( popped_pages ) );
+    begin_ -= popped_pages * pool_->page_size();
+    if ( popped_cnt_ == pushed_cnt_ ) {
+      pages_.clear();
+      begin_ = 0;
+    }
   } else {
-    std::cerr << "pop len greater than size" << std::endl;
-    begin_ = end_;
-    popped_cnt_ += ( end_ - begin_ );
+    begin_ = ring_index( len );
+    if ( popped_cnt_ == pushed_cnt_ and not staged_ and not ring_reserved_ ) {
+      begin_ = 0; // keep the next pushes contiguous for as long as possible (staged or reserved bytes stay put)
+    }
   }
+
+  notify_watermarks();
 }
 
 uint64_t Reader::bytes_buffered() const
 {
   // Your code here.
-  return end_ - begin_;
+  return pushed_cnt_ - popped_cnt_;
 }
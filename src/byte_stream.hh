@@ -1,20 +1,46 @@
 #pragma once
 
+#include "buffer.hh"
+#include "buffer_pool.hh"
+#include "mapped_file.hh"
+
+#include <array>
 #include <cstdint>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <optional>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 using std::cerr;
 using std::endl;
 using std::string;
 class Reader;
 class Writer;
+class FileDescriptor;
 
 class ByteStream
 {
 public:
-  explicit ByteStream( uint64_t capacity );
+  // How the buffered bytes are stored
+  enum class Storage : uint8_t
+  {
+    Ring,    // copied into a ring that is allocated on first use and grows in whole pages up to `capacity` bytes
+    Chunked, // pushed strings and Buffers are adopted as-is and queued, so push and pop never copy bytes
+    Mapped,  // like Ring, but the ring is a memory-mapped temporary file: only about `kMappedWindow` bytes at each
+             // end of the buffered bytes stay in memory, the ones in between are spilled to the file
+    Pooled   // copied into a queue of fixed-size pages borrowed from a BufferPool, and returned as they are popped
+  };
+
+  // Mapped: how many bytes next to the reader and next to the writer are kept in memory
+  static constexpr uint64_t kMappedWindow = 256 * 1024;
+
+  // Pooled storage borrows from `pool` (by default the global pool of BufferPool::kDefaultPageSize pages), which
+  // must outlive the stream
+  explicit ByteStream( uint64_t capacity, Storage storage = Storage::Ring, BufferPool* pool = nullptr );
 
   // Helper functions (provided) to access the ByteStream's Reader and Writer interfaces
   Reader& reader();
@@ -22,30 +48,114 @@ public:
   Writer& writer();
   const Writer& writer() const;
 
-  void set_error() { error_ = true; };       // Signal that the stream suffered an error.
+  void set_error();                          // Signal that the stream suffered an error.
   bool has_error() const { return error_; }; // Has the stream had an error?
+  Storage storage() const { return storage_; }
+
+  // Watermark notifications, so whoever waits on the stream (e.g. an EventLoop rule) can be woken up when its state
+  // changes instead of checking it over and over. A callback fires once per transition into its state, never for
+  // the state at the time it is set, and may push or pop itself. Setting a callback replaces the previous one.
+  //   readable: at least `low_watermark` bytes are buffered, or the stream is closed or had an error
+  //   writable: at least `free_watermark` bytes of capacity are available, or the stream had an error
+  void on_readable( std::function<void()> callback, uint64_t low_watermark = 1 );
+  void on_writable( std::function<void()> callback, uint64_t free_watermark = 1 );
+
+  // Copying a Pooled stream borrows new pages from the same pool
+  ByteStream( const ByteStream& other ) = default;
+  ByteStream& operator=( const ByteStream& other ) = default;
+  ByteStream( ByteStream&& other ) = default;
+  ByteStream& operator=( ByteStream&& other ) = default;
+  ~ByteStream() = default;
+
+  // Give the buffer memory back if the stream is empty and nothing is staged (it is allocated again by the next
+  // push). Discards any reservation from Writer::reserve().
+  void release_buffer();
 
 protected:
   // Please add any additional state to the ByteStream here, and not to the Writer and Reader interfaces.
   uint64_t capacity_;
+  Storage storage_;
   bool error_ { false };
-  uint64_t begin_ { 0 };
-  uint64_t end_ { 0 };
-  string content_;
-  uint64_t pushed_cnt_ { 0 }; //
+  uint64_t begin_ { 0 };                   // Ring, Mapped: offset of the first buffered byte in the ring
+  string content_;                         // Ring: the ring itself (empty until the first push)
+  std::optional<MappedFile> mapped_ {};    // Mapped: the ring itself
+  uint64_t spilled_cnt_ { 0 };             // Mapped: the buffered bytes before this stream index are paged out
+  std::deque<Buffer> chunks_ {};           // Chunked: adopted slices; the front one starts at offset `begin_`
+  uint64_t popped_chunks_ { 0 };           // Chunked: how many chunks were popped altogether
+  mutable uint64_t slice_chunk_ { 0 };     // Chunked: the chunk that the last slice began in (counting popped ones)
+  mutable uint64_t slice_start_ { 0 };     // Chunked: the stream index of that chunk's first byte
+  BufferPool* pool_ {};                    // Pooled: where the pages come from
+  std::vector<BufferPool::Page> pages_ {}; // Pooled: the pages; the front one starts at offset `begin_`
+  string reserved_ {};                     // Chunked, Pooled: space handed out by Writer::reserve(), not committed
+  uint64_t staged_ { 0 };                  // Ring, Mapped: free space written by Writer::stage(), not committed
+  uint64_t ring_reserved_ { 0 };           // Ring, Mapped: space handed out by Writer::reserve(), not committed
+  uint64_t pushed_cnt_ { 0 };
   uint64_t popped_cnt_ { 0 };
   bool is_closed_ { false };
+
+  std::function<void()> readable_callback_ {};
+  std::function<void()> writable_callback_ {};
+  uint64_t low_watermark_ { 1 };
+  uint64_t free_watermark_ { 1 };
+  bool was_readable_ { false };
+  bool was_writable_ { false };
+
+  bool is_readable() const { return pushed_cnt_ - popped_cnt_ >= low_watermark_ or is_closed_ or error_; }
+  bool is_writable() const
+  {
+    return ( not is_closed_ and capacity_ - ( pushed_cnt_ - popped_cnt_ ) >= free_watermark_ ) or error_;
+  }
+  void notify_watermarks(); // fire the callbacks whose state was just entered
+
+  static constexpr uint64_t kPageSize = 4096;
+
+  // Ring and Mapped: the start and the size of the ring
+  char* ring() { return mapped_ ? mapped_->data() : content_.data(); }
+  const char* ring() const { return mapped_ ? mapped_->data() : content_.data(); }
+  uint64_t ring_size() const { return mapped_ ? capacity_ : content_.size(); }
+
+  // Ring: make room in the ring for `len` more bytes (within the capacity)
+  void grow_ring( uint64_t len );
+
+  // Mapped: page out the buffered bytes that are now far from both the reader and the writer
+  void spill();
+
+  // offset in the ring of the byte `offset` bytes past the first buffered one
+  uint64_t ring_index( uint64_t offset ) const
+  {
+    const uint64_t idx = begin_ + offset;
+    return idx >= ring_size() ? idx - ring_size() : idx;
+  }
 };
 
 class Writer : public ByteStream
 {
 public:
   void push( std::string data ); // Push data to stream, but only as much as available capacity allows.
+  void push( Buffer data );      // Same, and with Chunked storage the stream shares `data` rather than copying it
   void close();                  // Signal that the stream has reached its ending. Nothing more will be written.
 
+  // Get writable space for up to `len` bytes (capped by the available capacity) right behind the buffered ones,
+  // as up to two spans. The bytes written there are only pushed by a later commit(); a push or another reserve()
+  // discards the reservation.
+  std::array<std::span<char>, 2> reserve( uint64_t len );
+  void commit( uint64_t len ); // Push the first `len` bytes of the reserved (or staged) space
+
+  // Ring and Mapped storage: write `data` into the free space, `offset` bytes behind the buffered ones (capped by
+  // the available capacity), without pushing it. Unlike a reservation, the staged bytes are kept across pops and
+  // other stage() calls until commit() pushes them; a push or a reserve() discards them.
+  void stage( uint64_t offset, std::string_view data );
+
+  // Read from `fd` straight into the stream's free space; returns the number of bytes read
+  uint64_t read_from( FileDescriptor& fd );
+
   bool is_closed() const;              // Has the stream been closed?
   uint64_t available_capacity() const; // How many bytes can be pushed to the stream right now?
   uint64_t bytes_pushed() const;       // Total number of bytes cumulatively pushed to the stream
+
+private:
+  // Ring, Mapped, Pooled: copy `data` (which fits) behind the buffered bytes
+  void push_bytes( std::string_view data );
 };
 
 class Reader : public ByteStream
@@ -54,6 +164,17 @@ public:
   std::string_view peek() const; // Peek at the next bytes in the buffer
   void pop( uint64_t len );      // Remove `len` bytes from the buffer
 
+  // Peek at the next bytes as up to two spans (the second may be empty). With Ring and Mapped storage
+  // this is every buffered byte; with Chunked and Pooled storage it is the first two chunks or pages.
+  std::array<std::string_view, 2> peek_spans() const;
+
+  // Up to `len` of the buffered bytes, starting `offset` bytes past the next one, without popping them. With
+  // Chunked storage they share the chunk they are in, if they are all in one; otherwise they are copied.
+  Buffer slice( uint64_t offset, uint64_t len ) const;
+
+  // Write the buffered bytes to `fd` and pop what was written; returns the number of bytes written
+  uint64_t write_to( FileDescriptor& fd );
+
   bool is_finished() const;        // Is the stream finished (closed and fully popped)?
   uint64_t bytes_buffered() const; // Number of bytes currently buffered (pushed and not popped)
   uint64_t bytes_popped() const;   // Total number of bytes cumulatively popped from stream
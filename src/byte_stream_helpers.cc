@@ -1,7 +1,24 @@
 #include "byte_stream.hh"
+#include "file_descriptor.hh"
 
+#include <algorithm>
 #include <cstdint>
+#include <optional>
 #include <stdexcept>
+#include <sys/ioctl.h>
+
+// Chunked and Pooled streams read into a fresh string, so don't allocate the whole capacity for every read
+static constexpr uint64_t kChunkedReadSize = 16384;
+
+// how many bytes `fd` has ready to read, if it can tell (sockets and pipes can)
+static std::optional<uint64_t> bytes_ready( const FileDescriptor& fd )
+{
+  int ready = 0;
+  if ( ::ioctl( fd.fd_num(), FIONREAD, &ready ) < 0 or ready < 0 ) { // NOLINT(*-vararg)
+    return std::nullopt;
+  }
+  return ready;
+}
 
 /*
  * read: A helper function thats peeks and pops up to `len` bytes
@@ -24,6 +41,33 @@ void read( Reader& reader, uint64_t len, std::string& out )
   }
 }
 
+uint64_t Writer::read_from( FileDescriptor& fd )
+{
+  uint64_t len = available_capacity();
+  if ( storage_ == Storage::Chunked or storage_ == Storage::Pooled ) {
+    // a string sized to the read is adopted as it is; a larger one would be copied by commit() after all
+    // (a read of 1 byte still tells EOF)
+    len = std::min( len, std::max<uint64_t>( bytes_ready( fd ).value_or( kChunkedReadSize ), 1 ) );
+  }
+
+  const auto regions = reserve( len );
+  const uint64_t bytes_read = fd.read( regions[0], regions[1] );
+  commit( bytes_read );
+  return bytes_read;
+}
+
+uint64_t Reader::write_to( FileDescriptor& fd )
+{
+  if ( bytes_buffered() == 0 ) {
+    return 0;
+  }
+
+  const auto spans = peek_spans();
+  const uint64_t bytes_written = fd.write( spans[0], spans[1] );
+  pop( bytes_written );
+  return bytes_written;
+}
+
 Reader& ByteStream::reader()
 {
   static_assert( sizeof( Reader ) == sizeof( ByteStream ),
@@ -0,0 +1,148 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+static constexpr double kCubicC = 0.4;    // scales the cubic function (segments / second^3)
+static constexpr double kCubicBeta = 0.7; // the window is multiplied by this on loss
+
+CongestionControl::CongestionControl( Algorithm algorithm, uint64_t mss )
+  : algorithm_( algorithm ), mss_( mss ), cwnd_( kUnlimited )
+{
+  if ( algorithm_ != Algorithm::None ) {
+    cwnd_ = initial_window( mss_ );
+  }
+}
+
+uint64_t CongestionControl::initial_window( uint64_t mss )
+{
+  return min( 4 * mss, max( 2 * mss, uint64_t { 4380 } ) ); // RFC 5681
+}
+
+void CongestionControl::set_mss( uint64_t mss )
+{
+  // the peer's MSS arrives with its SYN, before any data: the initial window is in segments of that size
+  if ( algorithm_ != Algorithm::None and cwnd_ == initial_window( mss_ ) and ssthresh_ == kUnlimited ) {
+    cwnd_ = initial_window( mss );
+  }
+  mss_ = mss;
+  cwnd_ = max( cwnd_, mss_ ); // a window smaller than one segment would never let a whole one go
+}
+
+void CongestionControl::tick( uint64_t ms_since_last_tick )
+{
+  now_ms_ += ms_since_last_tick;
+}
+
+void CongestionControl::on_ack( uint64_t acked )
+{
+  if ( algorithm_ == Algorithm::None or acked == 0 ) {
+    return;
+  }
+
+  if ( in_slow_start() ) {
+    cwnd_ += min( acked, mss_ );
+    return;
+  }
+
+  if ( algorithm_ == Algorithm::Cubic ) {
+    cubic_ack( acked );
+    return;
+  }
+
+  // one more segment each time a whole window has been acknowledged (RFC 3465 byte counting)
+  acked_since_growth_ += acked;
+  if ( acked_since_growth_ >= cwnd_ ) {
+    acked_since_growth_ -= cwnd_;
+    cwnd_ += mss_;
+  }
+}
+
+void CongestionControl::on_loss( uint64_t in_flight )
+{
+  if ( algorithm_ == Algorithm::None ) {
+    return;
+  }
+  back_off( in_flight );
+  cwnd_ = ssthresh_;
+}
+
+void CongestionControl::on_timeout( uint64_t in_flight )
+{
+  if ( algorithm_ == Algorithm::None ) {
+    return;
+  }
+  back_off( in_flight );
+  cwnd_ = mss_; // the loss window: start over from slow start
+}
+
+void CongestionControl::inflate( uint64_t segments )
+{
+  if ( algorithm_ == Algorithm::None ) {
+    return;
+  }
+  cwnd_ += segments * mss_;
+}
+
+void CongestionControl::on_partial_ack( uint64_t acked )
+{
+  if ( algorithm_ == Algorithm::None ) {
+    return;
+  }
+  // those bytes left the network; let one new segment go if it was a whole one (RFC 6582)
+  cwnd_ -= min( acked, cwnd_ > mss_ ? cwnd_ - mss_ : 0 );
+  if ( acked >= mss_ ) {
+    cwnd_ += mss_;
+  }
+}
+
+void CongestionControl::on_recovery_end()
+{
+  if ( algorithm_ == Algorithm::None ) {
+    return;
+  }
+  cwnd_ = ssthresh_;
+}
+
+void CongestionControl::back_off( uint64_t in_flight )
+{
+  acked_since_growth_ = 0;
+  if ( algorithm_ == Algorithm::NewReno ) {
+    ssthresh_ = max( in_flight / 2, 2 * mss_ );
+    return;
+  }
+
+  // CUBIC: remember the window at the loss, or a little less if it is lower than last time (fast convergence)
+  const double cwnd = static_cast<double>( cwnd_ ) / static_cast<double>( mss_ );
+  w_max_ = cwnd < w_max_ ? cwnd * ( 1 + kCubicBeta ) / 2 : cwnd;
+  ssthresh_ = max( static_cast<uint64_t>( static_cast<double>( cwnd_ ) * kCubicBeta ), 2 * mss_ );
+  in_epoch_ = false;
+}
+
+void CongestionControl::cubic_ack( uint64_t acked )
+{
+  const double mss = static_cast<double>( mss_ );
+  const double cwnd = static_cast<double>( cwnd_ ) / mss;
+  if ( not in_epoch_ ) {
+    in_epoch_ = true;
+    epoch_start_ = now_ms_;
+    w_max_ = max( w_max_, cwnd );
+    k_ = cbrt( ( w_max_ - cwnd ) / kCubicC );
+    w_est_ = cwnd;
+  }
+
+  const double t = static_cast<double>( now_ms_ - epoch_start_ ) / 1000;
+  const double rtt = static_cast<double>( rtt_ms_ ) / 1000;
+
+  // where the window should be one RTT from now, growing by at most half of it per RTT
+  const double target = clamp( kCubicC * pow( t + rtt - k_, 3 ) + w_max_, cwnd, 1.5 * cwnd );
+
+  // the window NewReno would have, with CUBIC's smaller decrease
+  const double acked_segments = static_cast<double>( acked ) / mss;
+  w_est_ += 3 * ( 1 - kCubicBeta ) / ( 1 + kCubicBeta ) * acked_segments / cwnd;
+
+  const double next = w_est_ > target ? w_est_ : cwnd + ( target - cwnd ) / cwnd * acked_segments;
+  cwnd_ = max( cwnd_, static_cast<uint64_t>( next * mss ) );
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+// The congestion window of a TCPSender: how many sequence numbers it may have in flight, on top of the receiver's
+// window, so that it neither floods a shared bottleneck nor waits for the peer alone to slow it down.
+// The sender reports what happens to its segments and asks for the window; the algorithm decides the rest.
+class CongestionControl
+{
+public:
+  enum class Algorithm : uint8_t
+  {
+    None,    // no congestion window: only the receiver's window limits the sender
+    NewReno, // RFC 5681: slow start, then one segment more per window acknowledged; halve on loss
+    Cubic    // RFC 9438: grow as a cubic function of the time since the last loss, back off by 30% on loss
+  };
+
+  static constexpr uint64_t kUnlimited = std::numeric_limits<uint64_t>::max();
+  static constexpr uint64_t kDefaultRTT = 100; // in milliseconds, until the sender measures one
+
+  // `mss` is the largest payload the sender puts in a segment
+  CongestionControl( Algorithm algorithm, uint64_t mss );
+
+  void on_ack( uint64_t acked );         // `acked` sequence numbers were newly acknowledged
+  void on_loss( uint64_t in_flight );    // a segment was lost, but the later ones arrived (fast retransmit)
+  void on_timeout( uint64_t in_flight ); // the retransmission timer expired
+
+  // fast recovery, after on_loss()
+  void inflate( uint64_t segments );     // that many more segments have left the network (duplicate acks)
+  void on_partial_ack( uint64_t acked ); // an ack covered some, but not all, of what was sent before the loss
+  void on_recovery_end();                // all of it is acknowledged: deflate the window to ssthresh
+  void tick( uint64_t ms_since_last_tick );
+  void set_rtt( uint64_t rtt_ms ) { rtt_ms_ = rtt_ms; } // the current round-trip time estimate
+  void set_mss( uint64_t mss );                         // the sender's segments changed size
+
+  Algorithm algorithm() const { return algorithm_; }
+  uint64_t cwnd() const { return cwnd_; }
+  uint64_t ssthresh() const { return ssthresh_; }
+  bool in_slow_start() const { return cwnd_ < ssthresh_; }
+
+private:
+  Algorithm algorithm_;
+  uint64_t mss_;
+  uint64_t cwnd_;
+  uint64_t ssthresh_ { kUnlimited };
+  uint64_t acked_since_growth_ { 0 }; // NewReno: acknowledged in congestion avoidance since cwnd last grew
+
+  // CUBIC, in segments and seconds
+  uint64_t now_ms_ { 0 };
+  uint64_t rtt_ms_ { kDefaultRTT };
+  bool in_epoch_ { false };   // has congestion avoidance started since the last loss?
+  uint64_t epoch_start_ { 0 }; // when it started
+  double w_max_ { 0 };        // the window just before the last loss
+  double k_ { 0 };            // how long the cubic function takes to grow back to `w_max_`
+  double w_est_ { 0 };        // what NewReno's window would be, which CUBIC never falls behind
+
+  static uint64_t initial_window( uint64_t mss );
+  void back_off( uint64_t in_flight ); // reduce ssthresh after a loss
+  void cubic_ack( uint64_t acked );
+};
@@ -8,14 +8,17 @@ using namespace std;
 
 //! \param[in] ethernet_address Ethernet (what ARP calls "hardware") address of the interface
 //! \param[in] ip_address IP (what ARP calls "protocol") address of the interface
+//! \param[in] mtu the largest datagram that the link carries (EthernetHeader::JUMBO_MTU with jumbo frames)
 NetworkInterface::NetworkInterface( string_view name,
                                     shared_ptr<OutputPort> port,
                                     const EthernetAddress& ethernet_address,
-                                    const Address& ip_address )
+                                    const Address& ip_address,
+                                    size_t mtu )
   : name_( name )
   , port_( notnull( "OutputPort", move( port ) ) )
   , ethernet_address_( ethernet_address )
   , ip_address_( ip_address )
+  , mtu_( mtu )
 {
   cerr << "DEBUG: Network interface has Ethernet address " << to_string( ethernet_address ) << " and IP address "
        << ip_address.ip() << "\n";
@@ -31,6 +34,11 @@ void NetworkInterface::send_datagram( const InternetDatagram& dgram, const Addre
   auto dst_ip = next_hop.ipv4_numeric();
   debug_print( name_ << " send datagram to ip: " << next_hop.to_string() );
 
+  if ( dgram.header.len > mtu_ ) {
+    debug_print( "datagram of " << dgram.header.len << " bytes does not fit the MTU of " << mtu_ );
+    return;
+  }
+
   // search next_hop in rtable_
   // if found, send
   // else queue and sent arp
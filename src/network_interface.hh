@@ -53,15 +53,17 @@ public:
   };
 
   // Construct a network interface with given Ethernet (network-access-layer) and IP (internet-layer)
-  // addresses
+  // addresses (and the largest datagram its link carries in one frame)
   NetworkInterface( std::string_view name,
                     std::shared_ptr<OutputPort> port,
                     const EthernetAddress& ethernet_address,
-                    const Address& ip_address );
+                    const Address& ip_address,
+                    size_t mtu = EthernetHeader::MTU );
 
   // Sends an Internet datagram, encapsulated in an Ethernet frame (if it knows the Ethernet destination
   // address). Will need to use [ARP](\ref rfc::rfc826) to look up the Ethernet destination address for the next
   // hop. Sending is accomplished by calling `transmit()` (a member variable) on the frame.
+  // A datagram longer than the MTU is dropped: nothing fragments it, so senders must find the path MTU themselves.
   void send_datagram( const InternetDatagram& dgram, const Address& next_hop );
 
   // Receives an Ethernet frame and responds appropriately.
@@ -75,6 +77,7 @@ public:
 
   // Accessors
   const std::string& name() const { return name_; }
+  size_t mtu() const { return mtu_; }
   const OutputPort& output() const { return *port_; }
   OutputPort& output() { return *port_; }
   std::queue<InternetDatagram>& datagrams_received() { return datagrams_received_; }
@@ -104,6 +107,9 @@ private:
   // IP (known as internet-layer or network-layer) address of the interface
   Address ip_address_;
 
+  // The largest datagram that fits in a frame of the link
+  size_t mtu_;
+
   // Datagrams that have been received
   std::queue<InternetDatagram> datagrams_received_ {};
 
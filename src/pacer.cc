@@ -0,0 +1,53 @@
+#include "pacer.hh"
+#include "congestion_control.hh"
+#include "tcp_config.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+Pacer::Pacer( uint64_t fixed_rate )
+  : fixed_rate_( fixed_rate )
+  , rate_( fixed_rate )
+  , burst_( kBurstSegments * TCPConfig::MAX_PAYLOAD_SIZE * 1000 )
+  , credit_( static_cast<int64_t>( burst_ ) )
+{}
+
+void Pacer::update( uint64_t cwnd, bool slow_start, bool has_rtt, double srtt_ms, uint64_t mss )
+{
+  burst_ = kBurstSegments * mss * 1000;
+  if ( fixed_rate_ > 0 ) {
+    return;
+  }
+  if ( not has_rtt or cwnd == CongestionControl::kUnlimited ) {
+    rate_ = 0;
+    return;
+  }
+  const double per_second = static_cast<double>( cwnd ) * 1000 / max( srtt_ms, 1.0 );
+  rate_ = static_cast<uint64_t>( per_second * static_cast<double>( slow_start ? kSlowStartGain : kGain ) / 100 );
+}
+
+void Pacer::tick( uint64_t ms_since_last_tick, bool waiting )
+{
+  if ( rate_ == 0 ) {
+    credit_ = static_cast<int64_t>( burst_ );
+    return;
+  }
+  const uint64_t added = rate_ * ms_since_last_tick;
+  const auto limit = static_cast<int64_t>( waiting ? max( burst_, added ) : burst_ );
+  credit_ = min( credit_ + static_cast<int64_t>( added ), limit );
+}
+
+void Pacer::consume( uint64_t bytes )
+{
+  credit_ -= static_cast<int64_t>( bytes * 1000 );
+}
+
+uint64_t Pacer::wait_us() const
+{
+  if ( ready() ) {
+    return 0;
+  }
+  const auto owed = static_cast<uint64_t>( 1 - credit_ ); // until the bucket holds a thousandth of a byte
+  return ( owed * 1000 + rate_ - 1 ) / rate_;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+// Paces a TCPSender's new segments: a token bucket that fills at the pacing rate, so that what the windows allow
+// goes out spread over the round trip instead of in one burst behind each ack.
+// The bucket counts thousandths of a byte, so that a tick of any length adds exactly rate x time: the rate is not
+// rounded to whole bytes per millisecond. A segment may go while the bucket holds anything at all, and takes it
+// below zero by its size; the debt is paid off before the next one goes.
+class Pacer
+{
+public:
+  static constexpr uint64_t kBurstSegments = 2;   // the most the bucket holds, in full segments
+  static constexpr uint64_t kSlowStartGain = 200; // percent of cwnd / SRTT, while the window doubles each RTT
+  static constexpr uint64_t kGain = 120;          // percent of cwnd / SRTT otherwise (as Linux has it)
+
+  // `fixed_rate` in bytes per second, or 0 to follow the congestion window
+  explicit Pacer( uint64_t fixed_rate = 0 );
+
+  // The window, round trip and segment size have changed, perhaps: derive the rate from them, unless it is fixed.
+  // With no round trip measured yet, or no congestion window, nothing is paced.
+  void update( uint64_t cwnd, bool slow_start, bool has_rtt, double srtt_ms, uint64_t mss );
+
+  // Fill the bucket. While segments wait, a long tick may fill it past a burst: what the rate allows in that
+  // time is due by now, and not a tick later.
+  void tick( uint64_t ms_since_last_tick, bool waiting );
+  bool ready() const { return rate_ == 0 or credit_ > 0; }
+  void consume( uint64_t bytes ); // a segment of that many bytes went out
+  void hold() { ++holds_; }       // a segment had to wait
+
+  uint64_t rate() const { return rate_; }           // bytes per second, 0 if not pacing
+  int64_t tokens() const { return credit_ / 1000; } // bytes in the bucket (negative: owed)
+  uint64_t wait_us() const;                         // until the next segment may go
+  uint64_t holds() const { return holds_; }         // how many times a segment had to wait
+
+private:
+  uint64_t fixed_rate_;
+  uint64_t rate_;
+  uint64_t burst_; // the most the bucket holds, in thousandths of a byte
+  int64_t credit_; // in thousandths of a byte
+  uint64_t holds_ { 0 };
+};
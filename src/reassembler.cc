@@ -1,125 +1,232 @@
 #include "reassembler.hh"
 
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
 using namespace std;
 
-void Reassembler::insert( uint64_t first_index, string data, bool is_last_substring )
+Reassembler::Reassembler( ByteStream&& output, Mode mode, BufferPool* pool )
+  : Reassembler( std::move( output ), pool )
 {
-  // Your code here.
+  in_place_ = mode == Mode::InPlace
+              and ( output_.storage() == ByteStream::Storage::Ring
+                    or output_.storage() == ByteStream::Storage::Mapped );
+}
 
+void Reassembler::insert( uint64_t first_index, Buffer data, bool is_last_substring )
+{
   // there is one case: insert an empty end string, just like insert an EOF char
   if ( is_last_substring ) {
     last_ = first_index + data.size();
     has_last_ = true;
   }
 
-  uint64_t avail_cap_ = output_.writer().available_capacity();
+  // only the bytes in [next_, next_ + available capacity) are of any use
+  const uint64_t begin = max( first_index, next_ );
+  const uint64_t end = min( first_index + data.size(), next_ + output_.writer().available_capacity() );
 
-  if ( first_index < next_ ) {
-    // buf:       |-------|
-    // data: |--|
-    if ( first_index + data.size() <= next_ ) { // already written to ByteStream, discard
-      return;
-    }
-    // cover buffer but too big, leave we need
-    // buf :      |--------|
-    // data:   |--------------|
-    else if ( data.size() + first_index >= next_ + avail_cap_ ) {
-      output_.writer().push( string( data.data() + next_ - first_index, avail_cap_ ) );
-      next_ += avail_cap_;
-      segs_.clear();
-    }
-    // buf:     |-----------|
-    // data: |--------|
-    else {
-      output_.writer().push( string( data.data() + next_ - first_index, data.size() - ( next_ - first_index ) ) );
-      next_ = first_index + data.size();
-    }
-  } else if ( first_index == next_ ) {
-    if ( data.size() <= avail_cap_ ) {
-      output_.writer().push( data );
-      next_ += data.size();
-    } else {
-      output_.writer().push( data );
-      next_ += avail_cap_;
-      segs_.clear();
-    }
+  if ( begin < end and in_place_ ) {
+    place( first_index, data, begin, end );
+  } else if ( begin < end and begin == next_ ) {
+    output_.writer().push( data.substr( begin - first_index, end - begin ) );
+    next_ = end;
+    flush();
+  } else if ( begin < end ) {
+    store( first_index, data, begin, end );
   }
-  // buf: |-------|
-  // seg:     |
-  else if ( first_index < next_ + avail_cap_ ) {
-    // buf:    |-----------|
-    // seg:        |------------|
-    if ( next_ + avail_cap_ < first_index + data.size() ) {
-      segs_.emplace( std::move( data ), first_index, next_ + avail_cap_, 0 );
+
+  if ( has_last_ && next_ == last_ ) {
+    output_.writer().close();
+  }
+}
+
+vector<pair<uint64_t, uint64_t>> Reassembler::pending_ranges() const
+{
+  vector<pair<uint64_t, uint64_t>> ranges;
+  const auto add = [&ranges]( uint64_t begin, uint64_t end ) {
+    if ( not ranges.empty() and ranges.back().second == begin ) {
+      ranges.back().second = end;
     } else {
-      segs_.emplace( first_index, std::move( data ) );
+      ranges.emplace_back( begin, end );
+    }
+  };
+
+  if ( not in_place_ ) {
+    for ( const auto& [first, interval] : pending_ ) {
+      add( first, interval.end );
     }
-  } else {
-    return;
+    return ranges;
   }
 
-  for ( auto it = segs_.begin(); it != segs_.end(); ) {
-    // next:  |
-    // seg:        |--------|
-    if ( next_ < it->begin_ ) {
-      break;
+  // in place: the runs of set bits after next_, until all the pending bytes are found
+  const uint64_t capacity = output_capacity();
+  uint64_t found = 0;
+  for ( uint64_t index = next_; found < pending_bytes_; ) {
+    const uint64_t pos = index % capacity;
+    const uint64_t bit = pos % 64;
+    const uint64_t word = present_[pos / 64] >> bit;
+    const uint64_t limit = min( 64 - bit, capacity - pos );
+    const uint64_t len = min<uint64_t>( word & 1 ? countr_one( word ) : countr_zero( word ), limit );
+    if ( word & 1 ) {
+      add( index, index + len );
+      found += len;
     }
+    index += len;
+  }
+  return ranges;
+}
+
+uint64_t Reassembler::pending_footprint() const
+{
+  if ( in_place_ ) {
+    return 0; // the pending bytes are in the output's free space
+  }
+  if ( pool_ ) {
+    return pages_.size() * pool_->page_size();
+  }
+  uint64_t total = 0;
+  for ( const auto& [first, interval] : pending_ ) {
+    total += interval.data.footprint();
+  }
+  return total;
+}
+
+void Reassembler::store( uint64_t first_index, const Buffer& data, uint64_t begin, uint64_t end )
+{
+  // start from the interval that covers `begin`, if any
+  auto it = pending_.upper_bound( begin );
+  if ( it != pending_.begin() and prev( it )->second.end > begin ) {
+    --it;
+  }
 
-    // next:        |
-    // seg:  |---|
-    if ( next_ >= it->end_ ) {
-      it = segs_.erase( it );
+  // fill each gap between the intervals that are already pending
+  for ( uint64_t pos = begin; pos < end; ) {
+    if ( it != pending_.end() and it->first <= pos ) {
+      pos = max( pos, it->second.end );
+      ++it;
       continue;
     }
 
-    // next:  |
-    // seg: |----|
-    if ( next_ >= it->begin_ ) { // we can promise next_ < seg.end_
-      if ( next_ == it->begin_ && it->index_ == 0 ) {
-        output_.writer().push( it->data_ );
-      } else {
-        output_.writer().push( string( it->data_.data() + ( next_ - it->begin_ ) + it->index_, it->end_ - next_ ) );
+    const uint64_t gap_end = it == pending_.end() ? end : min( end, it->first );
+    if ( pool_ ) {
+      store_pending( pos, string_view( data ).substr( pos - first_index, gap_end - pos ) );
+      pending_.emplace_hint( it, pos, Pending { gap_end, {} } );
+    } else {
+      Buffer slice = data.substr( pos - first_index, gap_end - pos );
+      if ( slice.footprint() / 2 > slice.size() ) {
+        slice = string( slice ); // don't keep a mostly-unused string alive for a small slice of it
       }
+      pending_.emplace_hint( it, pos, Pending { gap_end, std::move( slice ) } );
+    }
+    pending_bytes_ += gap_end - pos;
+    pos = gap_end;
+  }
+}
+
+void Reassembler::flush()
+{
+  while ( not pending_.empty() and pending_.begin()->first <= next_ ) {
+    auto node = pending_.extract( pending_.begin() );
+    const uint64_t first = node.key();
+    Pending& interval = node.mapped();
+    pending_bytes_ -= interval.end - first;
 
-      next_ = it->end_;
-      it = segs_.erase( it );
+    if ( interval.end <= next_ ) {
+      continue; // already written
     }
+    if ( pool_ ) {
+      push_pending( interval.end );
+    } else {
+      interval.data.remove_prefix( next_ - first );
+      output_.writer().push( std::move( interval.data ) );
+    }
+    next_ = interval.end;
   }
 
-  if ( has_last_ && next_ == last_ ) {
-    output_.writer().close();
+  // give back the pages that are now entirely written
+  if ( pool_ ) {
+    pages_.erase( pages_.begin(), pages_.lower_bound( next_ / pool_->page_size() ) );
   }
 }
 
-uint64_t Reassembler::bytes_pending() const
+void Reassembler::place( uint64_t first_index, string_view data, uint64_t begin, uint64_t end )
 {
-  // Your code here.
-  if ( segs_.empty() ) {
-    return 0;
+  output_.writer().stage( begin - next_, data.substr( begin - first_index, end - begin ) );
+
+  uint64_t run = end - begin;
+  if ( begin != next_ or pending_bytes_ ) {
+    pending_bytes_ += mark( begin, end );
+    run = take_run();
+    pending_bytes_ -= run;
+  }
+  if ( run ) {
+    output_.writer().commit( run );
+    next_ += run;
   }
+}
 
-  set<seg>::iterator it = segs_.begin();
-  uint64_t res = it->end_ - it->begin_;
-  uint64_t end = it->end_;
-  ++it;
+uint64_t Reassembler::mark( uint64_t begin, uint64_t end )
+{
+  const uint64_t capacity = output_capacity();
+  if ( present_.empty() ) {
+    present_.resize( ( capacity + 63 ) / 64 ); // allocated for the first out-of-order bytes only
+  }
 
-  while ( it != segs_.end() ) {
-    if ( it->end_ <= end ) {
-      ++it;
-      continue;
-    } else {
-      // end:   |
-      // seg: |----|
-      if ( it->begin_ <= end ) {
-        res += ( it->end_ - end );
-      } else {
-        // end:   |
-        // seg:      |----|
-        res += ( it->end_ - it->begin_ );
-      }
-      end = it->end_;
-      ++it;
+  uint64_t added = 0;
+  for ( uint64_t pos = begin % capacity, left = end - begin; left; ) {
+    const uint64_t bit = pos % 64;
+    const uint64_t len = min( { left, 64 - bit, capacity - pos } );
+    const uint64_t mask = ( len == 64 ? ~uint64_t {} : ( ( uint64_t { 1 } << len ) - 1 ) ) << bit;
+    uint64_t& word = present_[pos / 64];
+    added += popcount( mask & ~word );
+    word |= mask;
+    left -= len;
+    pos = pos + len == capacity ? 0 : pos + len;
+  }
+  return added;
+}
+
+uint64_t Reassembler::take_run()
+{
+  const uint64_t capacity = output_capacity();
+  uint64_t run = 0;
+  for ( uint64_t pos = next_ % capacity; run < pending_bytes_; ) {
+    const uint64_t bit = pos % 64;
+    const uint64_t len = min<uint64_t>( countr_one( present_[pos / 64] >> bit ), capacity - pos );
+    if ( len == 0 ) {
+      break;
+    }
+    present_[pos / 64] &= ~( ( len == 64 ? ~uint64_t {} : ( ( uint64_t { 1 } << len ) - 1 ) ) << bit );
+    run += len;
+    pos = pos + len == capacity ? 0 : pos + len;
+  }
+  return run;
+}
+
+void Reassembler::store_pending( uint64_t first_index, string_view data )
+{
+  const uint64_t page_size = pool_->page_size();
+  while ( not data.empty() ) {
+    auto& page = pages_[first_index / page_size];
+    if ( not page.data() ) {
+      page = pool_->get();
     }
+    const uint64_t in_page = first_index % page_size;
+    const uint64_t part = min( static_cast<uint64_t>( data.size() ), page_size - in_page );
+    memcpy( page.data() + in_page, data.data(), part );
+    first_index += part;
+    data.remove_prefix( part );
+  }
+}
+
+void Reassembler::push_pending( uint64_t end )
+{
+  const uint64_t page_size = pool_->page_size();
+  for ( uint64_t index = next_; index < end; ) {
+    const uint64_t in_page = index % page_size;
+    const uint64_t part = min( end - index, page_size - in_page );
+    output_.writer().push( string( pages_.at( index / page_size ).data() + in_page, part ) );
+    index += part;
   }
-  return res;
 }
@@ -1,17 +1,32 @@
 #pragma once
 
+#include "buffer_pool.hh"
 #include "byte_stream.hh"
 #include <list>
-#include <set>
+#include <map>
+#include <vector>
 #include <string_view>
+#include <utility>
 using std::list;
 using std::string_view;
 
 class Reassembler
 {
 public:
+  // Where the bytes that arrive before the ones preceding them are kept
+  enum class Mode : uint8_t
+  {
+    Intervals, // in their own strings (or pages), copied into the output once the gap before them is filled
+    InPlace    // written once, straight into the output's free space, which is then committed as it is: needs
+               // Ring or Mapped storage (with any other storage, this falls back to Intervals)
+  };
+
   // Construct Reassembler to write into given ByteStream.
-  explicit Reassembler( ByteStream&& output ) : output_( std::move( output ) ) {}
+  // With a `pool`, the pending bytes are copied into pages borrowed from it rather than kept in their own strings.
+  explicit Reassembler( ByteStream&& output, BufferPool* pool = nullptr )
+    : output_( std::move( output ) ), pool_( pool )
+  {}
+  Reassembler( ByteStream&& output, Mode mode, BufferPool* pool = nullptr );
 
   /*
    * Insert a new substring to be reassembled into a ByteStream.
@@ -32,11 +47,23 @@ public:
    * (i.e., bytes that couldn't be written even if earlier gaps get filled in).
    *
    * The Reassembler should close the stream after writing the last byte.
+   *
+   * The bytes are not copied until they reach the stream: pending ones are kept as slices of `data`.
    */
-  void insert( uint64_t first_index, std::string data, bool is_last_substring );
+  void insert( uint64_t first_index, Buffer data, bool is_last_substring );
+  void insert( uint64_t first_index, std::string data, bool is_last_substring )
+  {
+    insert( first_index, Buffer( std::move( data ) ), is_last_substring );
+  }
 
   // How many bytes are stored in the Reassembler itself?
-  uint64_t bytes_pending() const;
+  uint64_t bytes_pending() const { return pending_bytes_; }
+
+  // How many bytes of memory the stored bytes keep alive (a string shared by several intervals counts for each)
+  uint64_t pending_footprint() const;
+
+  // The ranges [first index, end) of the stored bytes, in order, each as long as it can be
+  std::vector<std::pair<uint64_t, uint64_t>> pending_ranges() const;
 
   // Access output stream reader
   Reader& reader() { return output_.reader(); }
@@ -45,51 +72,52 @@ public:
   // Access output stream writer, but const-only (can't write from outside)
   const Writer& writer() const { return output_.writer(); }
 
+  Reassembler( const Reassembler& other ) = default;
+  Reassembler& operator=( const Reassembler& other ) = default;
+  Reassembler( Reassembler&& other ) = default;
+  Reassembler& operator=( Reassembler&& other ) = default;
+  ~Reassembler() = default;
+
   uint64_t next() const { return next_; }
   uint64_t avail_cap() const { return output_.writer().available_capacity(); }
   bool has_error() const {return output_.has_error();}
   void set_error() {output_.set_error();}
-  class seg
+
+private:
+  // Bytes that arrived before the ones preceding them. The intervals never overlap: an insert only stores the
+  // parts of its data that are not pending yet.
+  struct Pending
   {
-  public:
-    // string view
-    // seg( uint64_t begin, string_view const& sv ) :begin_(begin){
-    //     data_ = string(sv);
-    //     end_ = begin_ + data_.size();
-    // }
-
-    // whole s is data
-    seg( uint64_t begin, string&& s ) : begin_( begin )
-    {
-      data_ = std::move( s );
-      end_ = begin_ + data_.size();
-    }
-
-    // part of s is data
-    seg( string&& s, uint64_t begin, uint64_t end, uint64_t index ) : begin_( begin ), end_( end ), index_( index )
-    {
-      data_ = std::move( s );
-    }
-    uint64_t begin_ { 0 };
-    uint64_t end_ { 0 };
-    string data_ { "" };
-    uint64_t index_ { 0 };                   // begin from data[index]
-    bool operator<( const seg& other ) const // head first, size second
-    {
-      if ( begin_ < other.begin_ ) {
-        return true;
-      } else if ( begin_ > other.begin_ ) {
-        return false;
-      } else {
-        return end_ > other.end_;
-      }
-    }
+    uint64_t end;
+    Buffer data; // empty with a pool: the bytes are in `pages_`
   };
 
-private:
   ByteStream output_; // the Reassembler writes to this ByteStream
-  std::set<seg> segs_ {};
-  uint64_t next_ { 0 }; // BS need to receive index
+  BufferPool* pool_;
+  std::map<uint64_t, BufferPool::Page> pages_ {}; // with a pool: page number (index / page size) -> pending bytes
+  std::map<uint64_t, Pending> pending_ {};        // first index -> the interval starting there
+  uint64_t pending_bytes_ { 0 };                  // total size of the intervals in `pending_`
+  uint64_t next_ { 0 };                           // BS need to receive index
   uint64_t last_ { 0 };
   bool has_last_ { false };
+  bool in_place_ { false };
+  std::vector<uint64_t> present_ {}; // in place: bit (index % capacity) is set if byte `index` is staged
+
+  // in place: stage the bytes of `data` (which starts at `first_index`) in [begin, end), and commit the ones now
+  // contiguous with next_
+  void place( uint64_t first_index, string_view data, uint64_t begin, uint64_t end );
+  uint64_t mark( uint64_t begin, uint64_t end ); // set the bits of [begin, end), return how many were not set
+  uint64_t take_run();                           // clear the set bits from next_ on, return how many there were
+  uint64_t output_capacity() const
+  {
+    return output_.writer().available_capacity() + output_.reader().bytes_buffered();
+  }
+
+  // store the bytes of `data` (which starts at `first_index`) in [begin, end) that are not pending yet
+  void store( uint64_t first_index, const Buffer& data, uint64_t begin, uint64_t end );
+  // push the pending intervals that the bytes up to next_ have made contiguous, and forget the ones covered
+  void flush();
+
+  void store_pending( uint64_t first_index, string_view data ); // copy `data` into `pages_`
+  void push_pending( uint64_t end );                            // push the bytes in `pages_` from next_ to `end`
 };
@@ -0,0 +1,39 @@
+#include "rtt_estimator.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+static constexpr double kAlpha = 1.0 / 8;      // weight of a new sample in SRTT
+static constexpr double kBeta = 1.0 / 4;       // weight of a new deviation in RTTVAR
+static constexpr double kClockGranularity = 1; // ms: the timer can't tell apart round trips closer than this
+
+RTTEstimator::RTTEstimator( uint64_t initial_RTO_ms )
+  : RTTEstimator( initial_RTO_ms, initial_RTO_ms, initial_RTO_ms )
+{}
+
+RTTEstimator::RTTEstimator( uint64_t initial_RTO_ms, uint64_t min_RTO_ms, uint64_t max_RTO_ms )
+  : min_RTO_ms_( min_RTO_ms ), max_RTO_ms_( max_RTO_ms ), rto_ms_( initial_RTO_ms )
+{
+  if ( min_RTO_ms_ > max_RTO_ms_ ) {
+    throw runtime_error( "RTTEstimator: minimum RTO is above the maximum" );
+  }
+}
+
+void RTTEstimator::sample( uint64_t rtt_ms )
+{
+  const double r = static_cast<double>( rtt_ms );
+  if ( not has_sample_ ) {
+    has_sample_ = true;
+    srtt_ms_ = r;
+    rttvar_ms_ = r / 2;
+  } else {
+    rttvar_ms_ = ( 1 - kBeta ) * rttvar_ms_ + kBeta * abs( srtt_ms_ - r ); // before SRTT moves
+    srtt_ms_ = ( 1 - kAlpha ) * srtt_ms_ + kAlpha * r;
+  }
+
+  const auto rto = static_cast<uint64_t>( ceil( srtt_ms_ + max( kClockGranularity, 4 * rttvar_ms_ ) ) );
+  rto_ms_ = clamp( rto, min_RTO_ms_, max_RTO_ms_ );
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+// The sender's round-trip time estimate and the retransmission timeout derived from it (RFC 6298).
+// Each sample is the time from sending a segment to its acknowledgment; Karn's rule (only segments that were
+// never retransmitted) is up to the sender.
+class RTTEstimator
+{
+public:
+  // A fixed timeout: round trips are still measured, but the RTO stays at `initial_RTO_ms`
+  explicit RTTEstimator( uint64_t initial_RTO_ms );
+
+  // An adaptive timeout, starting at `initial_RTO_ms` and kept within [`min_RTO_ms`, `max_RTO_ms`]
+  RTTEstimator( uint64_t initial_RTO_ms, uint64_t min_RTO_ms, uint64_t max_RTO_ms );
+
+  void sample( uint64_t rtt_ms );
+
+  bool has_sample() const { return has_sample_; }
+  double srtt_ms() const { return srtt_ms_; }     // smoothed round-trip time
+  double rttvar_ms() const { return rttvar_ms_; } // round-trip time variation
+  uint64_t rto_ms() const { return rto_ms_; }     // retransmission timeout, before any back-off
+
+private:
+  uint64_t min_RTO_ms_;
+  uint64_t max_RTO_ms_;
+  uint64_t rto_ms_;
+  bool has_sample_ { false };
+  double srtt_ms_ { 0 };
+  double rttvar_ms_ { 0 };
+};
@@ -0,0 +1,186 @@
+#include "spsc_byte_stream.hh"
+
+#include "exception.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <poll.h>
+#include <string>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+SPSCByteStream::Wakeup::Wakeup()
+  : fd_( CheckSystemCall( "eventfd", ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) ) // NOLINT(*-signed-bitwise)
+{}
+
+void SPSCByteStream::Wakeup::arm()
+{
+  armed_.store( true, memory_order_relaxed );
+  // pairs with the fence in notify(): either the other side sees `armed_`, or the caller's re-check that follows
+  // sees the other side's update
+  atomic_thread_fence( memory_order_seq_cst );
+}
+
+void SPSCByteStream::Wakeup::notify()
+{
+  atomic_thread_fence( memory_order_seq_cst );
+  if ( armed_.load( memory_order_relaxed ) and armed_.exchange( false, memory_order_relaxed ) ) {
+    // either thread may get here, so bypass FileDescriptor's (unsynchronized) write bookkeeping
+    const uint64_t one = 1;
+    CheckSystemCall( "write", static_cast<int>( ::write( fd_.fd_num(), &one, sizeof( one ) ) ) );
+  }
+}
+
+void SPSCByteStream::Wakeup::clear()
+{
+  string counter( sizeof( uint64_t ), 0 );
+  fd_.read( counter );
+}
+
+SPSCByteStream::SPSCByteStream( uint64_t capacity )
+  : capacity_( capacity ), buffer_( make_unique<char[]>( capacity ) ) // NOLINT(*-avoid-c-arrays)
+{}
+
+uint64_t SPSCByteStream::push( string_view data )
+{
+  if ( closed_.load( memory_order_relaxed ) ) {
+    return 0;
+  }
+
+  const uint64_t pushed = pushed_.load( memory_order_relaxed );
+  const uint64_t buffered = pushed - popped_.load( memory_order_acquire );
+  const uint64_t len = min( static_cast<uint64_t>( data.size() ), capacity_ - buffered );
+  if ( len == 0 ) {
+    return 0; // (always, with a capacity of 0)
+  }
+
+  const uint64_t tail = pushed % capacity_;
+  const uint64_t first_part = min( len, capacity_ - tail );
+  memcpy( buffer_.get() + tail, data.data(), first_part );
+  memcpy( buffer_.get(), data.data() + first_part, len - first_part );
+  pushed_.store( pushed + len, memory_order_release );
+
+  reader_wakeup_.notify();
+  return len;
+}
+
+void SPSCByteStream::close()
+{
+  closed_.store( true, memory_order_release );
+  reader_wakeup_.notify();
+}
+
+bool SPSCByteStream::is_closed() const
+{
+  return closed_.load( memory_order_acquire );
+}
+
+uint64_t SPSCByteStream::available_capacity() const
+{
+  return capacity_ - ( pushed_.load( memory_order_acquire ) - popped_.load( memory_order_acquire ) );
+}
+
+uint64_t SPSCByteStream::bytes_pushed() const
+{
+  return pushed_.load( memory_order_acquire );
+}
+
+array<string_view, 2> SPSCByteStream::peek_spans() const
+{
+  const uint64_t popped = popped_.load( memory_order_relaxed );
+  const uint64_t buffered = pushed_.load( memory_order_acquire ) - popped;
+  if ( buffered == 0 ) {
+    return {}; // (also the only case with a capacity of 0)
+  }
+  const uint64_t head = popped % capacity_;
+  const uint64_t first_part = min( buffered, capacity_ - head );
+  return { string_view( buffer_.get() + head, first_part ), string_view( buffer_.get(), buffered - first_part ) };
+}
+
+string_view SPSCByteStream::peek() const
+{
+  return peek_spans()[0];
+}
+
+void SPSCByteStream::pop( uint64_t len )
+{
+  const uint64_t popped = popped_.load( memory_order_relaxed );
+  len = min( len, pushed_.load( memory_order_acquire ) - popped );
+  if ( len == 0 ) {
+    return;
+  }
+
+  popped_.store( popped + len, memory_order_release );
+  writer_wakeup_.notify();
+}
+
+bool SPSCByteStream::is_finished() const
+{
+  // load `closed_` first: once it is set, `pushed_` is final
+  return is_closed() and bytes_buffered() == 0;
+}
+
+uint64_t SPSCByteStream::bytes_buffered() const
+{
+  return pushed_.load( memory_order_acquire ) - popped_.load( memory_order_acquire );
+}
+
+uint64_t SPSCByteStream::bytes_popped() const
+{
+  return popped_.load( memory_order_acquire );
+}
+
+void SPSCByteStream::set_error()
+{
+  error_.store( true, memory_order_release );
+  reader_wakeup_.notify();
+  writer_wakeup_.notify();
+}
+
+bool SPSCByteStream::has_error() const
+{
+  return error_.load( memory_order_acquire );
+}
+
+void SPSCByteStream::arm_reader_wakeup()
+{
+  reader_wakeup_.arm();
+  if ( reader_can_progress() ) {
+    reader_wakeup_.notify();
+  }
+}
+
+void SPSCByteStream::arm_writer_wakeup()
+{
+  writer_wakeup_.arm();
+  if ( writer_can_progress() ) {
+    writer_wakeup_.notify();
+  }
+}
+
+// block until `fd` is readable
+static void wait_for( const FileDescriptor& fd )
+{
+  pollfd pfd { fd.fd_num(), POLLIN, 0 };
+  CheckSystemCall( "poll", ::poll( &pfd, 1, -1 ) );
+}
+
+void SPSCByteStream::wait_until_readable()
+{
+  while ( not reader_can_progress() ) {
+    arm_reader_wakeup();
+    wait_for( reader_wakeup() );
+    clear_reader_wakeup();
+  }
+}
+
+void SPSCByteStream::wait_until_writable()
+{
+  while ( not writer_can_progress() ) {
+    arm_writer_wakeup();
+    wait_for( writer_wakeup() );
+    clear_writer_wakeup();
+  }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "file_descriptor.hh"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+/*
+ * SPSCByteStream: a fixed-capacity byte stream that one writer thread and one reader thread can use at the same
+ * time without locks. Every method is meant for exactly one side (writer or reader), except the error flag.
+ *
+ * Each side can block without spinning: it "arms" its wakeup and then sleeps polling the wakeup's fd, which the
+ * other side signals (through an eventfd) only when it was armed. A side that never sleeps costs no syscalls.
+ */
+class SPSCByteStream
+{
+public:
+  explicit SPSCByteStream( uint64_t capacity );
+
+  // Writer side
+  uint64_t push( std::string_view data ); // Push as much of `data` as fits; returns the number of bytes pushed
+  void close();                           // Signal that nothing more will be pushed
+  bool is_closed() const;
+  uint64_t available_capacity() const;
+  uint64_t bytes_pushed() const;
+  void wait_until_writable(); // Block until there is available capacity (or the stream had an error)
+
+  // Reader side
+  std::array<std::string_view, 2> peek_spans() const; // All buffered bytes, as up to two spans
+  std::string_view peek() const;                      // The buffered bytes up to the wrap point
+  void pop( uint64_t len );
+  bool is_finished() const;
+  uint64_t bytes_buffered() const;
+  uint64_t bytes_popped() const;
+  void wait_until_readable(); // Block until there are bytes to pop, or the stream is finished or had an error
+
+  // Either side
+  void set_error();
+  bool has_error() const;
+
+  // Wakeups for a side that sleeps in its own poll loop (e.g. an EventLoop): call arm_*() right before polling
+  // *_wakeup(), and clear_*() once it is readable. arm_*() signals the fd itself if that side can already make
+  // progress, so a push, pop or close that raced with arming is never missed.
+  FileDescriptor& reader_wakeup() { return reader_wakeup_.fd(); }
+  void arm_reader_wakeup();
+  void clear_reader_wakeup() { reader_wakeup_.clear(); }
+
+  FileDescriptor& writer_wakeup() { return writer_wakeup_.fd(); }
+  void arm_writer_wakeup();
+  void clear_writer_wakeup() { writer_wakeup_.clear(); }
+
+  // An SPSCByteStream is shared by two threads in place: it cannot be copied or moved
+  SPSCByteStream( const SPSCByteStream& other ) = delete;
+  SPSCByteStream& operator=( const SPSCByteStream& other ) = delete;
+  SPSCByteStream( SPSCByteStream&& other ) = delete;
+  SPSCByteStream& operator=( SPSCByteStream&& other ) = delete;
+  ~SPSCByteStream() = default;
+
+private:
+  static constexpr size_t kCacheLine = 64;
+
+  // An eventfd that the signalling side only writes to while the sleeping side has armed it
+  class Wakeup
+  {
+  public:
+    Wakeup();
+    FileDescriptor& fd() { return fd_; }
+    void arm();
+    void notify();
+    void clear();
+
+  private:
+    FileDescriptor fd_;
+    std::atomic<bool> armed_ { false };
+  };
+
+  bool reader_can_progress() const { return bytes_buffered() > 0 or is_closed() or has_error(); }
+  bool writer_can_progress() const { return available_capacity() > 0 or has_error(); }
+
+  const uint64_t capacity_;
+  std::unique_ptr<char[]> buffer_;
+
+  // Each counter is written by one side only, and lives on its own cache line so the two sides don't contend.
+  alignas( kCacheLine ) std::atomic<uint64_t> pushed_ { 0 };
+  alignas( kCacheLine ) std::atomic<uint64_t> popped_ { 0 };
+  alignas( kCacheLine ) std::atomic<bool> closed_ { false };
+  std::atomic<bool> error_ { false };
+
+  alignas( kCacheLine ) Wakeup reader_wakeup_ {};
+  alignas( kCacheLine ) Wakeup writer_wakeup_ {};
+};
@@ -1,5 +1,7 @@
 #include "tcp_receiver.hh"
 
+#include <algorithm>
+
 using namespace std;
 
 void TCPReceiver::receive( TCPSenderMessage message )
@@ -16,13 +18,30 @@ void TCPReceiver::receive( TCPSenderMessage message )
 
   if ( message.SYN ) {
     is_init_ = true;
+    peer_sack_ = message.SACK_permitted;
+    peer_window_scale_ = message.window_scale.has_value();
+    peer_timestamps_ = timestamps_ && message.timestamp.has_value();
+    ts_recent_ = message.timestamp.value_or( 0 );
+    last_ack_sent_.reset();
+    last_index_ = 0;
     has_fin_ = message.FIN; // reset fin
     has_rst_ = message.RST;
     this->isn_ = message.seqno;
     this->max_abs_seqno = 0;
-    reassembler_.insert( 0, message.payload, message.FIN );
+    reassembler_.insert( 0, std::move( message.payload ), message.FIN );
     return;
   }
+  if ( peer_timestamps_ && message.timestamp.has_value() ) {
+    // PAWS (RFC 7323): a timestamp older than the latest marks an old duplicate, whatever its seqno unwraps to
+    // (an RST never gets here: it is taken whatever its timestamp)
+    if ( static_cast<int32_t>( *message.timestamp - ts_recent_ ) < 0 ) {
+      return;
+    }
+    // with delayed acks, echo the earliest segment that the next ack covers, so the sender times the whole delay
+    if ( message.seqno.unwrap( isn_, max_abs_seqno ) <= last_ack_sent_.value_or( reassembler_.next() + 1 ) ) {
+      ts_recent_ = *message.timestamp;
+    }
+  }
   if ( message.FIN ) {
     has_fin_ = true;
   }
@@ -30,10 +49,18 @@ void TCPReceiver::receive( TCPSenderMessage message )
     has_rst_ = true;
   }
   max_abs_seqno = message.seqno.unwrap( isn_, max_abs_seqno );
-  reassembler_.insert( max_abs_seqno - 1, message.payload, message.FIN );
+  last_index_ = max_abs_seqno - 1;
+  reassembler_.insert( max_abs_seqno - 1, std::move( message.payload ), message.FIN );
 }
 
-TCPReceiverMessage TCPReceiver::send() const
+void TCPReceiver::ack_sent( const TCPReceiverMessage& msg )
+{
+  if ( msg.ackno.has_value() ) {
+    last_ack_sent_ = msg.ackno->unwrap( isn_, reassembler_.next() + 1 );
+  }
+}
+
+TCPReceiverMessage TCPReceiver::send( bool on_syn ) const
 {
   // Your code here.
 
@@ -52,7 +79,28 @@ TCPReceiverMessage TCPReceiver::send() const
   }
 
   decltype( msg.window_size ) max_win_size = -1;
-  msg.window_size = reassembler_.avail_cap() > max_win_size ? max_win_size : reassembler_.avail_cap();
+  const bool scaled = peer_window_scale_ && syn_sent_ && !on_syn;
+  const uint64_t window = reassembler_.avail_cap() >> ( scaled ? window_shift_.value_or( 0 ) : 0 );
+  msg.window_size = window > max_win_size ? max_win_size : window;
   msg.RST = has_rst_ | reassembler_.has_error();
+  if ( peer_timestamps_ && is_init_ ) {
+    msg.timestamp_echo = ts_recent_;
+  }
+
+  if ( sack_ && peer_sack_ && is_init_ && reassembler_.bytes_pending() ) {
+    // the block with the last segment received goes first (RFC 2018), then the others in order
+    auto ranges = reassembler_.pending_ranges();
+    const auto last = find_if( ranges.begin(), ranges.end(), [&]( const auto& r ) {
+      return r.first <= last_index_ && last_index_ < r.second;
+    } );
+    if ( last != ranges.end() ) {
+      rotate( ranges.begin(), last, last + 1 );
+    }
+    const size_t room = TCPReceiverMessage::MAX_SACK_BLOCKS - msg.timestamp_echo.has_value(); // one less with TS
+    ranges.resize( min( ranges.size(), room ) );
+    for ( const auto& [begin, end] : ranges ) {
+      msg.sack.emplace_back( Wrap32::wrap( begin + 1, isn_ ), Wrap32::wrap( end + 1, isn_ ) );
+    }
+  }
   return msg;
 }
@@ -8,7 +8,18 @@ class TCPReceiver
 {
 public:
   // Construct with given Reassembler
-  explicit TCPReceiver( Reassembler&& reassembler ) : reassembler_( std::move( reassembler ) ) {}
+  // (and with `sack`, tell the sender which bytes past the ackno arrived, if its SYN permits it;
+  //  with `window_shift`, advertise windows shifted right by that many bits, if its SYN offers a window scale;
+  //  with `timestamps`, echo the sender's timestamps and drop segments older than the latest, if its SYN has one)
+  explicit TCPReceiver( Reassembler&& reassembler,
+                        bool sack = false,
+                        std::optional<uint8_t> window_shift = std::nullopt,
+                        bool timestamps = false )
+    : reassembler_( std::move( reassembler ) )
+    , sack_( sack )
+    , window_shift_( window_shift )
+    , timestamps_( timestamps )
+  {}
 
   /*
    * The TCPReceiver receives TCPSenderMessages, inserting their payload into the Reassembler
@@ -17,7 +28,15 @@ public:
   void receive( TCPSenderMessage message );
 
   // The TCPReceiver sends TCPReceiverMessages to the peer's TCPSender.
-  TCPReceiverMessage send() const;
+  // (`on_syn`: the message goes out with our own SYN, whose window is never scaled)
+  TCPReceiverMessage send( bool on_syn = false ) const;
+
+  // Our own SYN has gone out: the windows sent from now on are scaled, if both SYNs offered a window scale
+  void syn_sent() { syn_sent_ = true; }
+
+  // A message from send() has gone out: only the segments that its ackno covers update the timestamp to echo
+  // (until the first one, the ackno counts as sent as soon as it advances)
+  void ack_sent( const TCPReceiverMessage& msg );
 
   // Access the output (only Reader is accessible non-const)
   const Reassembler& reassembler() const { return reassembler_; }
@@ -32,4 +51,14 @@ private:
   bool is_init_ {false};
   bool has_fin_{false};
   bool has_rst_ {false};
+  bool sack_ { false };                      // send SACK blocks...
+  bool peer_sack_ { false };                 // ...if the sender's SYN had the SACK-permitted option
+  uint64_t last_index_ { 0 };                // stream index of the last segment received
+  std::optional<uint8_t> window_shift_ {};   // the window scale our own SYN offers...
+  bool peer_window_scale_ { false };         // ...in use if the sender's SYN offered one too...
+  bool syn_sent_ { false };                  // ...once our SYN has gone out (RFC 7323)
+  bool timestamps_ { false };                // echo timestamps...
+  bool peer_timestamps_ { false };           // ...if the sender's SYN had one
+  uint32_t ts_recent_ { 0 };                 // the timestamp to echo: of the latest segment that arrived in order
+  std::optional<uint64_t> last_ack_sent_ {}; // absolute seqno: the ackno of the last message that went out
 };
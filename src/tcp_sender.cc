@@ -1,8 +1,39 @@
 #include "tcp_sender.hh"
 #include "tcp_config.hh"
 
+#include <algorithm>
+
 using namespace std;
 
+TCPSender::TCPSender( ByteStream&& input,
+                      Wrap32 isn,
+                      uint64_t initial_RTO_ms,
+                      CongestionControl::Algorithm congestion_control )
+  : input_( std::move( input ) )
+  , isn_( isn )
+  , rtt_( initial_RTO_ms )
+  , cur_RTO_ms_( initial_RTO_ms )
+  , cc_( congestion_control, TCPConfig::MAX_PAYLOAD_SIZE )
+{}
+
+TCPSender::TCPSender( ByteStream&& input, const TCPConfig& config )
+  : input_( std::move( input ) )
+  , isn_( config.isn )
+  , rtt_( config.rt_timeout, config.rt_timeout_min, config.rt_timeout_max )
+  , cur_RTO_ms_( config.rt_timeout )
+  , window_shift_offer_( config.window_shift() )
+  , timestamps_( config.timestamps )
+  , cc_( config.congestion_control, TCPConfig::MAX_PAYLOAD_SIZE )
+  , fast_retransmit_( config.fast_retransmit )
+  , sack_( config.sack )
+  , rack_tlp_( config.rack_tlp )
+  , mss_offer_( config.mss() )
+  , mtu_probing_( config.mtu_probing )
+  , pacing_( config.pacing )
+  , pacer_( config.pacing_rate )
+  , gso_( config.gso )
+{}
+
 uint64_t TCPSender::sequence_numbers_in_flight() const
 {
   // Your code here.
@@ -21,8 +52,16 @@ void TCPSender::push( const TransmitFunction& transmit )
   if ( is_FIN_acked ) {
     return;
   }
+  paced_out_ = false;
+  if ( pacing_ ) {
+    update_pacing_rate();
+  }
+
+  if ( retransmit_pending_ ) { // fast retransmit, whatever the window
+    retransmit_next_hole( transmit );
+  }
 
-  auto remain_wnd_size = wnd_size_ == 0 ? 1 : wnd_size_;
+  auto remain_wnd_size = min( wnd_size_ == 0 ? 1 : wnd_size_, cc_.cwnd() + probe_allowance_ );
 
   bool has_SYN_sent = false;
 
@@ -38,16 +77,35 @@ void TCPSender::push( const TransmitFunction& transmit )
   }
 
   bool is_input_finished = input_.writer().is_closed();
-  uint64_t remain_data_size = ( !has_SYN_sent & ( abs_cur_seqno == 0 ) ) + input_.reader().bytes_buffered()
+  uint64_t remain_data_size = ( !has_SYN_sent & ( abs_cur_seqno == 0 ) ) + bytes_unsent()
                               + ( is_input_finished & !has_FIN_sent_ );
 
+  // with GSO, a run of full-sized segments goes out as one segment, for the adapter to cut apart
+  Outstanding run { 0, 0, false, false, 0, false, false, false }; // none, while its length is 0
+  uint64_t run_segments = 0;
+  bool run_open = false; // may the next segment join the run?
+  const auto send_run = [&] {
+    if ( run.length == 0 ) {
+      return;
+    }
+    TCPSenderMessage msg = make_segment( run.seqno, run.payload_size(), run.SYN, run.FIN );
+    if ( run_segments > 1 ) {
+      msg.gso_size = static_cast<uint16_t>( mss_ );
+    }
+    transmit( msg );
+    run.length = 0;
+  };
+
   while ( remain_data_size > 0 && remain_wnd_size > 0 ) {
-    TCPSenderMessage cur_msg;
-    cur_msg.seqno = Wrap32::wrap( abs_cur_seqno, isn_ );
+    if ( pacing_ && probe_allowance_ == 0 && !pacer_.ready() ) {
+      pacer_.hold();
+      paced_out_ = true; // tick() sends it once the bucket fills
+      break;
+    }
+    Outstanding seg { abs_cur_seqno, 0, false, false, now_ms_, false, false, false };
 
     if ( abs_cur_seqno == 0 && !has_SYN_sent ) {
-      cur_msg.SYN = true;
-      cur_msg.seqno = isn_;
+      seg.SYN = true;
       remain_data_size -= 1;
       remain_wnd_size -= 1;
       has_SYN_sent = true;
@@ -55,41 +113,84 @@ void TCPSender::push( const TransmitFunction& transmit )
 
     // put into payload
     // u can't put payload and FIN into message
+    uint64_t payload_size = 0;
     if ( remain_wnd_size == 0 ) {
       // pass
     }
     // we have window size
     else {
-      // extract min(Max_Payload_Size, wnd_size) from bs
-      auto bytes_buffered = input_.reader().bytes_buffered();
-
-      read( input_.reader(),
-            std::min( { bytes_buffered, remain_wnd_size, TCPConfig::MAX_PAYLOAD_SIZE } ),
-            cur_msg.payload );
-      // std::cout << "remain window size:" << remain_wnd_size << std::endl;
-      // std::cout << "payload:" << cur_msg.payload << std::endl;
-      remain_wnd_size -= cur_msg.payload.size();
-      remain_data_size -= cur_msg.payload.size();
-
-      if ( remain_wnd_size > 0 && input_.reader().is_finished() ) {
+      // take min(segment size, wnd_size) of the bytes not sent yet; they stay in the stream until acknowledged
+      const uint64_t segment_size = next_segment_size( remain_wnd_size );
+      if ( segment_size == 0 && !seg.SYN ) {
+        break; // waiting for room for a path MTU probe
+      }
+
+      payload_size = std::min( { bytes_unsent(), remain_wnd_size, segment_size } );
+      remain_wnd_size -= payload_size;
+      remain_data_size -= payload_size;
+
+      if ( remain_wnd_size > 0 && is_input_finished && bytes_unsent() == payload_size ) {
         remain_wnd_size -= 1;
-        cur_msg.FIN = true;
+        seg.FIN = true;
         remain_data_size = 0;
-        has_FIN_sent_ = true;
       }
     }
 
-    cur_msg.RST = input_.has_error();
-
-    transmit( cur_msg );
-    ost_segs_.insert( { abs_cur_seqno, cur_msg } );
-    abs_exp_ackno_ += cur_msg.sequence_length();
-    abs_cur_seqno += cur_msg.sequence_length();
+    seg.length = seg.SYN + payload_size + seg.FIN;
+    if ( run_open && payload_size <= mss_ && run.payload_size() + payload_size <= TCPConfig::GSO_MAX_SIZE ) {
+      run.length += seg.length;
+      run.FIN = seg.FIN;
+      run_segments++;
+    } else {
+      send_run();
+      run = seg;
+      run_segments = 1;
+    }
+    run_open = gso_ && !seg.SYN && !seg.FIN && payload_size == mss_;
+    if ( !run_open ) {
+      send_run();
+    }
+    if ( pacing_ ) {
+      pacer_.consume( seg.length );
+    }
+    if ( payload_size > mss_ ) {
+      mtu_probe_seqno_ = abs_cur_seqno;
+      mtu_probe_size_ = payload_size;
+    }
+    if ( first_seg_ > 0 && ost_segs_.size() == ost_segs_.capacity() ) {
+      // make room at the back from the acknowledged segments at the front, rather than reallocate
+      ost_segs_.erase( ost_segs_.begin(), ost_segs_.begin() + static_cast<ptrdiff_t>( first_seg_ ) );
+      first_seg_ = 0;
+    }
+    ost_segs_.push_back( seg );
+    has_FIN_sent_ |= seg.FIN;
+    abs_exp_ackno_ += seg.length;
+    abs_cur_seqno += seg.length;
     if ( !timer_.is_running_ ) {
       timer_.reset( cur_RTO_ms_ );
     }
-    cur_msg.reset();
   }
+  send_run();
+  arm_probe(); // new data went out: the tail moved
+}
+
+TCPSenderMessage TCPSender::make_segment( uint64_t seqno, uint64_t payload_size, bool SYN, bool FIN ) const
+{
+  TCPSenderMessage msg;
+  msg.seqno = Wrap32::wrap( seqno, isn_ );
+  msg.SYN = SYN;
+  msg.FIN = FIN;
+  if ( payload_size > 0 ) {
+    msg.payload = input_.reader().slice( seqno + SYN - 1 - input_.reader().bytes_popped(), payload_size );
+  }
+  if ( SYN ) {
+    msg.SACK_permitted = sack_;
+    msg.window_scale = window_shift_offer_;
+    msg.mss = mss_offer_;
+  }
+  msg.RST = input_.has_error();
+  stamp( msg );
+  return msg;
 }
 
 TCPSenderMessage TCPSender::make_empty_message() const
@@ -97,6 +198,7 @@ TCPSenderMessage TCPSender::make_empty_message() const
   TCPSenderMessage msg;
   msg.seqno = Wrap32::wrap( abs_exp_ackno_, isn_ );
   msg.RST = input_.has_error();
+  stamp( msg );
   return msg;
 }
 
@@ -109,12 +211,15 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
   }
 
   uint64_t abs_rcv_ackno = 0;
+  const uint64_t window = uint64_t { msg.window_size } << peer_window_shift_;
 
   if ( !msg.ackno.has_value() ) {
     abs_last_ackno_ = abs_exp_ackno_ = 0;
     abs_rcv_ackno = 0;
-    wnd_size_ = msg.window_size;
+    wnd_size_ = window;
     ost_segs_.clear();
+    first_seg_ = 0;
+    mtu_probe_seqno_.reset();
   } else {
     abs_rcv_ackno = msg.ackno.value().unwrap( isn_, abs_last_ackno_ );
   }
@@ -126,42 +231,445 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
 
   // rcv_ackno + ack_wnd = last_ackno + wnd
   // wnd = rcv_ackno + ack_wnd - last_ackno
+  if ( sack_ ) {
+    mark_sacked( msg, abs_rcv_ackno );
+  }
+
   is_FIN_acked = has_FIN_sent_ & ( abs_rcv_ackno == abs_exp_ackno_ );
   bool has_new_data_acked = abs_rcv_ackno > abs_last_ackno_;
   //
   if ( abs_rcv_ackno <= abs_last_ackno_ ) {
-    wnd_size_ = ( abs_rcv_ackno + msg.window_size > abs_last_ackno_ )
-                  ? abs_rcv_ackno + msg.window_size - abs_last_ackno_
-                  : 0;
+    // the same ack and window again, while segments are outstanding: one more of them has arrived out of order
+    if ( fast_retransmit_ && msg.ackno.has_value() && abs_rcv_ackno == abs_last_ackno_ && !outstanding().empty()
+         && window == wnd_size_ ) {
+      on_duplicate_ack();
+    }
+    wnd_size_ = ( abs_rcv_ackno + window > abs_last_ackno_ ) ? abs_rcv_ackno + window - abs_last_ackno_ : 0;
   } else // if (abs_rcv_ackno > abs_last_ackno_) // new segment get acked
   {
-    cur_RTO_ms_ = initial_RTO_ms_;
+    const uint64_t acked = abs_rcv_ackno - max( abs_last_ackno_, uint64_t { 1 } ); // the SYN does not open cwnd
+    dup_acks_ = 0;
+    if ( probe_end_ && abs_rcv_ackno >= probe_end_ ) {
+      // without DSACK to tell that the original arrived too, a retransmitted probe repaired a loss (RFC 8985)
+      if ( probe_retransmitted_ && !in_recovery_ ) {
+        cc_.on_loss( cc_.cwnd() );
+      }
+      probe_end_ = 0;
+    }
+    if ( in_recovery_ && abs_rcv_ackno < recover_ ) {
+      cc_.on_partial_ack( acked );
+      retransmit_pending_ = true; // NewReno: the next segment was lost too
+    } else if ( in_recovery_ ) {
+      in_recovery_ = false;
+      cc_.on_recovery_end();
+    } else {
+      cc_.on_ack( acked );
+    }
     retx_cnt_ = 0;
     is_con_retx_ = false;
     abs_last_ackno_ = abs_rcv_ackno;
-    wnd_size_ = msg.window_size;
-    auto it = ost_segs_.begin();
-    while ( it != ost_segs_.end() ) {
-      if ( it->first + it->second.sequence_length() <= abs_rcv_ackno ) {
-        it = ost_segs_.erase( it );
-      } else {
+    wnd_size_ = window;
+    optional<uint64_t> rtt_sample;
+    const uint64_t oldest_sent_ms = outstanding().empty() ? now_ms_ : outstanding().front().sent_ms;
+    for ( const auto& seg : outstanding() ) {
+      if ( seg.end() > abs_rcv_ackno ) {
         break;
       }
+      if ( not seg.retransmitted ) {
+        rtt_sample = now_ms_ - seg.sent_ms; // the latest segment acknowledged gives the freshest sample
+      }
+      if ( rack_tlp_ && !seg.sacked ) {
+        rack_delivered( seg, seg.end() );
+      }
+      if ( seg.seqno == mtu_probe_seqno_ ) {
+        mtu_probe_delivered();
+      }
+      first_seg_++;
     }
+    if ( outstanding().empty() ) {
+      ost_segs_.clear(); // keeps its capacity
+      first_seg_ = 0;
+    }
+    // the bytes of the segments acknowledged in full are no longer needed for retransmission: make room for more
+    const uint64_t acked_bytes
+      = outstanding().empty() ? bytes_sent() : max( outstanding().front().seqno, uint64_t { 1 } ) - 1;
+    if ( acked_bytes > input_.reader().bytes_popped() ) {
+      input_.reader().pop( acked_bytes - input_.reader().bytes_popped() );
+    }
+    if ( timestamps_ && peer_timestamps_ && msg.timestamp_echo.has_value() ) {
+      // the echo tells which transmission is acknowledged, so retransmissions give samples too (RFC 7323); one
+      // from the future, or from before the oldest segment this ack covers was sent, is not ours to trust
+      const auto age = static_cast<int32_t>( static_cast<uint32_t>( now_ms_ ) - *msg.timestamp_echo );
+      const auto after_sent = static_cast<int32_t>( *msg.timestamp_echo - static_cast<uint32_t>( oldest_sent_ms ) );
+      if ( age >= 0 && after_sent >= 0 ) {
+        rtt_sample = age;
+      }
+    }
+    if ( rtt_sample.has_value() ) {
+      rtt_.sample( *rtt_sample );
+      cc_.set_rtt( static_cast<uint64_t>( rtt_.srtt_ms() ) );
+    }
+    cur_RTO_ms_ = rtt_.rto_ms();
   }
 
-  if ( ost_segs_.empty() ) {
+  if ( outstanding().empty() ) {
     timer_.turnoff();
   } else {
     if ( has_new_data_acked ) {
       timer_.reset( cur_RTO_ms_ );
     }
   }
+
+  if ( rack_tlp_ ) {
+    rack_fack_ = max( { rack_fack_, high_sacked_, abs_last_ackno_ } );
+    rack_detect_loss();
+    arm_probe();
+  }
+}
+
+void TCPSender::set_peer_window_scale( optional<uint8_t> shift )
+{
+  if ( window_shift_offer_.has_value() && shift.has_value() ) {
+    peer_window_shift_ = min( *shift, TCPConfig::MAX_WINDOW_SHIFT );
+  } else {
+    peer_window_shift_ = 0;
+  }
+}
+
+void TCPSender::set_peer_timestamps( bool timestamps )
+{
+  peer_timestamps_ = timestamps;
+}
+
+void TCPSender::set_peer_mss( optional<uint16_t> mss )
+{
+  // an absurdly small MSS would leave no room for the timestamps, or for any payload at all
+  uint64_t limit = max( mss.value_or( TCPConfig::DEFAULT_MSS ), TCPConfig::MIN_MSS );
+  if ( mss_offer_.has_value() ) {
+    limit = min( limit, uint64_t { *mss_offer_ } ); // our own link's MTU
+  }
+  if ( timestamps_ && peer_timestamps_ ) {
+    limit -= 12; // the option, with its padding, takes room from every segment's payload
+  }
+  peer_mss_ = search_high_ = limit;
+  mss_ = mtu_probing_ ? min( mss_, limit ) : limit;
+  cc_.set_mss( mss_ );
+}
+
+void TCPSender::stamp( TCPSenderMessage& msg ) const
+{
+  if ( timestamps_ && ( peer_timestamps_ || msg.SYN ) ) {
+    msg.timestamp = static_cast<uint32_t>( now_ms_ );
+  } else {
+    msg.timestamp.reset();
+  }
+}
+
+void TCPSender::on_duplicate_ack()
+{
+  dup_acks_++;
+  if ( in_recovery_ ) {
+    // with SACK, retransmit the next hole in place of the segment that has left the network
+    if ( high_sacked_ > abs_last_ackno_ && !retransmit_pending_ && next_hole() != nullptr ) {
+      retransmit_pending_ = true;
+    } else {
+      cc_.inflate( 1 ); // another segment has left the network
+    }
+    return;
+  }
+
+  // the path MTU probe did not get through, but the segments after it did: no sign of congestion
+  if ( dup_acks_ == TCPConfig::DUP_ACK_THRESHOLD && abs_last_ackno_ == mtu_probe_seqno_ ) {
+    high_rxt_ = 0;
+    retransmit_pending_ = true;
+    return;
+  }
+
+  // after a timeout, duplicates of what was sent before it are no news (RFC 6582)
+  if ( dup_acks_ == TCPConfig::DUP_ACK_THRESHOLD && abs_last_ackno_ >= recover_ ) {
+    enter_recovery();
+    cc_.inflate( TCPConfig::DUP_ACK_THRESHOLD );
+  }
+}
+
+void TCPSender::enter_recovery()
+{
+  in_recovery_ = true;
+  recover_ = abs_exp_ackno_;
+  high_rxt_ = 0;
+  cc_.on_loss( sequence_numbers_in_flight() );
+  retransmit_pending_ = true;
+  probe_timer_.turnoff();
+}
+
+void TCPSender::mark_sacked( const TCPReceiverMessage& msg, uint64_t abs_ackno )
+{
+  for ( const auto& [wrapped_begin, wrapped_end] : msg.sack ) {
+    const uint64_t begin = wrapped_begin.unwrap( isn_, abs_ackno );
+    const uint64_t end = wrapped_end.unwrap( isn_, abs_ackno );
+    if ( begin <= abs_ackno || end <= begin || end > abs_exp_ackno_ ) {
+      continue; // not a range of what is outstanding
+    }
+    for ( auto it = outstanding_from( begin ); it != outstanding().end() && it->end() <= end; ++it ) {
+      if ( rack_tlp_ && !it->sacked ) {
+        rack_delivered( *it, it->end() );
+      }
+      if ( it->seqno == mtu_probe_seqno_ ) {
+        mtu_probe_delivered();
+      }
+      it->sacked = true;
+      high_sacked_ = max( high_sacked_, it->end() );
+    }
+  }
+}
+
+span<TCPSender::Outstanding>::iterator TCPSender::outstanding_from( uint64_t seqno )
+{
+  return lower_bound( outstanding().begin(), outstanding().end(), seqno, []( const auto& seg, uint64_t value ) {
+    return seg.seqno < value;
+  } );
+}
+
+TCPSender::Outstanding* TCPSender::next_hole()
+{
+  if ( outstanding().empty() ) {
+    return nullptr;
+  }
+  if ( rack_tlp_ ) {
+    const auto lost = find_if(
+      outstanding().begin(), outstanding().end(), []( const auto& seg ) { return seg.lost && !seg.sacked; } );
+    if ( lost != outstanding().end() ) {
+      return &*lost;
+    }
+  }
+  if ( high_sacked_ <= abs_last_ackno_ ) {
+    return &outstanding().front();
+  }
+  for ( auto it = outstanding_from( high_rxt_ ); it != outstanding().end() && it->seqno < high_sacked_; ++it ) {
+    if ( !it->sacked ) {
+      return &*it;
+    }
+  }
+  return nullptr;
+}
+
+void TCPSender::retransmit_next_hole( const TransmitFunction& transmit )
+{
+  retransmit_pending_ = false;
+  Outstanding* const hole = next_hole();
+  if ( hole == nullptr ) {
+    return;
+  }
+  retransmit( *hole, transmit );
+  high_rxt_ = max( high_rxt_, hole->end() );
+  timer_.reset( cur_RTO_ms_ );
+}
+
+void TCPSender::rack_delivered( const Outstanding& seg, uint64_t end )
+{
+  const uint64_t rtt = now_ms_ - seg.sent_ms;
+  if ( seg.retransmitted && rtt < min_rtt_ ) {
+    return; // too quick to be the retransmission's round trip: the original may have arrived
+  }
+  if ( !seg.retransmitted ) {
+    min_rtt_ = min( min_rtt_, rtt );
+    reordering_seen_ |= end < rack_fack_; // it arrived after one sent later
+  }
+  if ( seg.sent_ms > rack_xmit_ms_ || ( seg.sent_ms == rack_xmit_ms_ && end > rack_end_ ) ) {
+    rack_xmit_ms_ = seg.sent_ms;
+    rack_end_ = end;
+    rack_rtt_ = rtt;
+  }
+}
+
+void TCPSender::rack_detect_loss()
+{
+  if ( rack_end_ == 0 ) {
+    return;
+  }
+
+  // lost: sent before the latest delivered segment, and not delivered a reordering window after it would have been
+  const uint64_t reo_wnd = reordering_window();
+  uint64_t wait = 0;
+  bool found = false;
+  for ( auto& seg : outstanding() ) {
+    const uint64_t end = seg.end();
+    const bool sent_before = seg.sent_ms < rack_xmit_ms_ || ( seg.sent_ms == rack_xmit_ms_ && end < rack_end_ );
+    if ( seg.sacked || seg.lost || !sent_before ) {
+      continue;
+    }
+    const uint64_t deadline = seg.sent_ms + rack_rtt_ + reo_wnd;
+    if ( deadline <= now_ms_ ) {
+      seg.lost = true;
+      found |= seg.seqno != mtu_probe_seqno_; // a lost path MTU probe is no sign of congestion
+      retransmit_pending_ = true;
+    } else {
+      wait = max( wait, deadline - now_ms_ );
+    }
+  }
+
+  if ( wait > 0 ) {
+    reo_timer_.reset( wait );
+  } else {
+    reo_timer_.turnoff();
+  }
+  if ( found ) {
+    if ( !in_recovery_ && abs_last_ackno_ >= recover_ ) {
+      enter_recovery();
+      cc_.inflate( count_if( outstanding().begin(), outstanding().end(), []( const auto& seg ) {
+        return seg.sacked; // as with duplicate acks, these have left the network
+      } ) );
+    }
+  }
+}
+
+uint64_t TCPSender::reordering_window() const
+{
+  if ( !reordering_seen_ ) {
+    // no sign of reordering yet: losses are as certain as after three duplicate acks
+    const auto sacked
+      = count_if( outstanding().begin(), outstanding().end(), []( const auto& seg ) { return seg.sacked; } );
+    if ( in_recovery_ || static_cast<uint64_t>( sacked ) >= TCPConfig::DUP_ACK_THRESHOLD ) {
+      return 0;
+    }
+  }
+  if ( min_rtt_ == UINT64_MAX ) {
+    return 0;
+  }
+  return min( min_rtt_ / 4, static_cast<uint64_t>( rtt_.srtt_ms() ) );
+}
+
+void TCPSender::arm_probe()
+{
+  if ( !rack_tlp_ || in_recovery_ || probe_end_ || outstanding().empty() || wnd_size_ == 0 ) {
+    probe_timer_.turnoff();
+    return;
+  }
+
+  uint64_t pto = rtt_.has_sample() ? static_cast<uint64_t>( 2 * rtt_.srtt_ms() ) : TCPConfig::TIMEOUT_DFLT;
+  if ( outstanding().size() == 1 ) {
+    pto += TCPConfig::MAX_ACK_DELAY; // the receiver may be holding back the ack of a lone segment
+  }
+  pto = max( pto, uint64_t { 10 } );
+  if ( timer_.cur_time_ + pto >= timer_.exp_time_ ) {
+    probe_timer_.turnoff(); // the timeout comes first
+    return;
+  }
+  probe_timer_.reset( pto );
+}
+
+void TCPSender::send_probe( const TransmitFunction& transmit )
+{
+  // new data if the receiver's window takes it, else the last segment again
+  const uint64_t sent = abs_exp_ackno_;
+  probe_end_ = sent;
+  probe_allowance_ = mss_;
+  push( transmit );
+  probe_allowance_ = 0;
+
+  probe_retransmitted_ = abs_exp_ackno_ == sent;
+  if ( probe_retransmitted_ && !outstanding().empty() ) {
+    retransmit( outstanding().back(), transmit );
+  }
+  probe_end_ = abs_exp_ackno_;
+  timer_.reset( cur_RTO_ms_ );
+}
+
+void TCPSender::retransmit( Outstanding& seg, const TransmitFunction& transmit )
+{
+  if ( seg.seqno == mtu_probe_seqno_ ) {
+    mtu_probe_lost();
+  }
+  const uint64_t payload_size = seg.payload_size();
+  if ( payload_size <= mss_ || seg.SYN ) {
+    transmit( make_segment( seg.seqno, payload_size, seg.SYN, seg.FIN ) );
+  } else if ( gso_ ) {
+    TCPSenderMessage msg = make_segment( seg.seqno, payload_size, false, seg.FIN );
+    msg.gso_size = static_cast<uint16_t>( mss_ );
+    transmit( msg );
+  } else {
+    for ( uint64_t offset = 0; offset < payload_size; offset += mss_ ) {
+      const uint64_t piece_size = min( mss_, payload_size - offset );
+      const bool FIN = seg.FIN && offset + piece_size == payload_size;
+      transmit( make_segment( seg.seqno + offset, piece_size, false, FIN ) );
+    }
+  }
+  seg.sent_ms = now_ms_;
+  seg.retransmitted = true;
+  seg.lost = false;
+}
+
+uint64_t TCPSender::next_segment_size( uint64_t room ) const
+{
+  if ( !mtu_probing_ || mtu_probe_seqno_.has_value() || in_recovery_ || abs_last_ackno_ == 0
+       || search_high_ < mss_ + TCPConfig::MTU_PROBE_STEP ) {
+    return mss_;
+  }
+  // the peer's MSS first, as most paths carry it; then halve the range that is left after a probe is lost
+  const uint64_t probe = search_high_ == peer_mss_ ? search_high_ : ( mss_ + search_high_ + 1 ) / 2;
+  if ( probe > bytes_unsent() ) {
+    return mss_; // a probe is full-sized, or it tells nothing
+  }
+  if ( probe > room ) {
+    // hold back until enough of what is in flight is acknowledged for the probe to fit, if it ever will
+    return probe <= min( wnd_size_, cc_.cwnd() ) ? 0 : mss_;
+  }
+  return probe;
+}
+
+void TCPSender::mtu_probe_delivered()
+{
+  mss_ = mtu_probe_size_;
+  cc_.set_mss( mss_ );
+  mtu_probe_seqno_.reset();
+  mtu_probes_lost_ = 0;
+}
+
+void TCPSender::mtu_probe_lost()
+{
+  mtu_probe_seqno_.reset();
+  recover_ = abs_exp_ackno_; // the duplicate acks of the segments after the probe are no sign of congestion either
+  if ( ++mtu_probes_lost_ >= TCPConfig::MAX_MTU_PROBES ) { // not just an unlucky loss: the path is narrower
+    search_high_ = mtu_probe_size_ - 1;
+    mtu_probes_lost_ = 0;
+  }
+}
+
+void TCPSender::update_pacing_rate()
+{
+  pacer_.update( cc_.cwnd(), cc_.in_slow_start(), rtt_.has_sample(), rtt_.srtt_ms(), mss_ );
 }
 
 void TCPSender::tick( uint64_t ms_since_last_tick, const TransmitFunction& transmit )
 {
   // Your code here.
+  now_ms_ += ms_since_last_tick;
+  cc_.tick( ms_since_last_tick );
+  if ( pacing_ ) {
+    pacer_.tick( ms_since_last_tick, paced_out_ );
+    if ( paced_out_ && pacer_.ready() ) {
+      push( transmit ); // the bucket has filled for what it held back
+    }
+  }
+
+  if ( reo_timer_.is_running_ ) {
+    reo_timer_.grow( ms_since_last_tick );
+    if ( reo_timer_.is_expired() ) {
+      rack_detect_loss();
+      if ( retransmit_pending_ ) {
+        retransmit_next_hole( transmit );
+      }
+    }
+  }
+  if ( probe_timer_.is_running_ ) {
+    probe_timer_.grow( ms_since_last_tick );
+    if ( probe_timer_.is_expired() ) {
+      probe_timer_.turnoff();
+      send_probe( transmit );
+      return;
+    }
+  }
+
   if ( !timer_.is_running_ ) {
     return;
   }
@@ -174,7 +682,7 @@ void TCPSender::tick( uint64_t ms_since_last_tick, const TransmitFunction& trans
   // now timer is expired, let's check
 
   // expire with nothing in flight should not happen, because timer_ is already turnoff in receive()
-  if ( ost_segs_.empty() ) {
+  if ( outstanding().empty() ) {
     cerr << "timer_ is already off in tick() if receive() get all segments acknowledged" << endl;
     if ( ( abs_last_ackno_ != abs_exp_ackno_ ) ) {
       cerr << "error: abs_last_ackno_ != abs_exp_ackno_" << endl;
@@ -185,10 +693,27 @@ void TCPSender::tick( uint64_t ms_since_last_tick, const TransmitFunction& trans
     return;
   }
 
-  transmit( ost_segs_.begin()->second );
+  retransmit( outstanding().front(), transmit );
 
   if ( wnd_size_ != 0 ) {
+    in_recovery_ = false;
+    dup_acks_ = 0;
+    recover_ = abs_exp_ackno_;
+    if ( high_sacked_ > abs_last_ackno_ ) {
+      // the receiver may have dropped what it SACKed (RFC 2018): start over without it
+      for ( auto& seg : outstanding() ) {
+        seg.sacked = false;
+      }
+      high_sacked_ = 0;
+    }
+    for ( auto& seg : outstanding() ) {
+      seg.lost = false; // back to the first outstanding segment
+    }
+    reo_timer_.turnoff();
+    probe_timer_.turnoff();
+    probe_end_ = 0;
     if ( !is_con_retx_ ) {
+      cc_.on_timeout( sequence_numbers_in_flight() ); // once: the window is already down to one segment after
       retx_cnt_ = 1;
       is_con_retx_ = true;
     } else {
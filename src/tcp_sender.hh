@@ -1,6 +1,10 @@
 #pragma once
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "pacer.hh"
+#include "rtt_estimator.hh"
+#include "tcp_config.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 
@@ -8,18 +12,25 @@
 #include <cstdint>
 #include <functional>
 #include <list>
-#include <map>
 #include <memory>
 #include <optional>
 #include <queue>
+#include <span>
+#include <vector>
 
 class TCPSender
 {
 public:
   /* Construct TCP sender with given default Retransmission Timeout and possible ISN */
-  TCPSender( ByteStream&& input, Wrap32 isn, uint64_t initial_RTO_ms )
-    : input_( std::move( input ) ), isn_( isn ), initial_RTO_ms_( initial_RTO_ms ), cur_RTO_ms_( initial_RTO_ms )
-  {}
+  /* (and congestion control algorithm: by default, only the receiver's window limits the sender) */
+  TCPSender( ByteStream&& input,
+             Wrap32 isn,
+             uint64_t initial_RTO_ms,
+             CongestionControl::Algorithm congestion_control = CongestionControl::Algorithm::None );
+
+  /* Construct TCP sender as configured: its Retransmission Timeout follows the measured round-trip time, and it
+     recovers from losses as `config` says */
+  TCPSender( ByteStream&& input, const TCPConfig& config );
 
   /* Generate an empty TCPSenderMessage */
   TCPSenderMessage make_empty_message() const;
@@ -27,6 +38,17 @@ public:
   /* Receive and process a TCPReceiverMessage from the peer's receiver */
   void receive( const TCPReceiverMessage& msg );
 
+  /* The peer's SYN offered this window scale, or none: its receiver's windows are shifted left by as many bits
+     from now on, if our own SYN offered a window scale too (RFC 7323) */
+  void set_peer_window_scale( std::optional<uint8_t> shift );
+
+  /* Did the peer's SYN have a timestamp? If not, the segments after our SYN go without one (RFC 7323) */
+  void set_peer_timestamps( bool timestamps );
+
+  /* The peer's SYN offered this MSS, or none: segments grow up to it, less the options they carry, and no larger
+     than our own MSS (at once, or by probing if the config says so) */
+  void set_peer_mss( std::optional<uint16_t> mss );
+
   /* Type of the `transmit` function that the push and tick methods can use to send messages */
   using TransmitFunction = std::function<void( const TCPSenderMessage& )>;
 
@@ -45,6 +67,23 @@ public:
   // Access input stream reader, but const-only (can't read from outside)
   const Reader& reader() const { return input_.reader(); }
 
+  // Has all of the closed outbound stream been sent? (Its bytes stay in it until they are acknowledged.)
+  bool is_input_sent() const { return input_.writer().is_closed() && bytes_unsent() == 0; }
+
+  // The congestion window, ssthresh and algorithm
+  const CongestionControl& congestion_control() const { return cc_; }
+
+  // The round-trip time estimate and the RTO computed from it
+  const RTTEstimator& rtt() const { return rtt_; }
+
+  // The payload of a segment, and the most it can grow to
+  uint64_t mss() const { return mss_; }
+  uint64_t peer_mss() const { return peer_mss_; }
+
+  // The pacing rate and the tokens in its bucket, if the sender paces
+  bool pacing() const { return pacing_; }
+  const Pacer& pacer() const { return pacer_; }
+
   struct Timer
   {
     Timer() {}
@@ -87,8 +126,8 @@ private:
   // Variables initialized in constructor
   ByteStream input_;
   Wrap32 isn_;
-  uint64_t initial_RTO_ms_;
-  uint64_t cur_RTO_ms_;
+  RTTEstimator rtt_;
+  uint64_t cur_RTO_ms_; // rtt_.rto_ms(), doubled on each consecutive retransmission
 
   // receiver: please send me the first byte, equals 0 if NOT ack SYN, promise aligned with ost_segs_
   uint64_t abs_last_ackno_ { 0 };
@@ -102,6 +141,112 @@ private:
 
   Timer timer_ {};
 
-  uint64_t wnd_size_ { 1 };
-  std::map<uint64_t, TCPSenderMessage> ost_segs_ {}; // outstanding segments, <seqno, msg>
+  uint64_t wnd_size_ { 1 };                      // the receiver's window
+  std::optional<uint8_t> window_shift_offer_ {}; // the window scale our SYN offers for our own receiver's windows
+  uint8_t peer_window_shift_ { 0 };              // the window scale of the peer's receiver, once both offered one
+  bool timestamps_ { false };                    // put a timestamp on every segment...
+  bool peer_timestamps_ { true };                // ...until the peer's SYN turns out to have none
+  CongestionControl cc_;    // the congestion window, the sender never has more than the smaller one in flight
+
+  // fast retransmit and recovery (RFC 5681 and RFC 6582)
+  bool fast_retransmit_ { false };
+  uint64_t dup_acks_ { 0 };           // duplicate acks in a row
+  bool in_recovery_ { false };        // has the first outstanding segment been fast-retransmitted?
+  uint64_t recover_ { 0 };            // recovery ends once everything sent before it started is acknowledged
+  bool retransmit_pending_ { false }; // the next push() retransmits the next hole
+
+  // SACK (RFC 2018): which outstanding segments the receiver already holds
+  bool sack_ { false };
+  uint64_t high_sacked_ { 0 }; // end of the highest segment SACKed
+  uint64_t high_rxt_ { 0 };    // end of the highest segment retransmitted in this recovery
+
+  // RACK-TLP (RFC 8985): a segment is lost once one sent after it arrived and a reordering window has passed,
+  // and a probe goes out when the tail of what was sent is not acknowledged in about two round trips
+  bool rack_tlp_ { false };
+  uint64_t rack_xmit_ms_ { 0 };        // when the most recently sent of the delivered segments was sent
+  uint64_t rack_end_ { 0 };            // the end of that segment, 0 until one is delivered
+  uint64_t rack_rtt_ { 0 };            // the round trip that segment took
+  uint64_t rack_fack_ { 0 };           // the end of the highest segment delivered before this ack
+  uint64_t min_rtt_ { UINT64_MAX };    // the shortest round trip seen
+  bool reordering_seen_ { false };     // has a segment arrived after one sent later?
+  Timer reo_timer_ {};                 // runs while a segment waits out the reordering window
+  Timer probe_timer_ {};               // runs until the tail loss probe goes out
+  uint64_t probe_end_ { 0 };           // the end of the probe in flight, 0 if there is none
+  bool probe_retransmitted_ { false }; // was the probe a retransmission of the last segment?
+  uint64_t probe_allowance_ { 0 };     // how far a new-data probe may go past the congestion window
+
+  // segment size: the peer's MSS, or as much of it as probing found the path to carry (RFC 4821)
+  std::optional<uint16_t> mss_offer_ {};                 // the MSS our SYN offers
+  bool mtu_probing_ { false };
+  uint64_t mss_ { TCPConfig::MAX_PAYLOAD_SIZE };         // the payload of a segment
+  uint64_t peer_mss_ { TCPConfig::MAX_PAYLOAD_SIZE };    // the most it can grow to
+  uint64_t search_high_ { TCPConfig::MAX_PAYLOAD_SIZE }; // the largest payload that may still fit the path
+  std::optional<uint64_t> mtu_probe_seqno_ {};           // where the probe in flight starts, if there is one
+  uint64_t mtu_probe_size_ { 0 };                        // its payload
+  unsigned mtu_probes_lost_ { 0 };                       // probes of that size lost in a row
+
+  // pacing: new segments wait for the bucket, and tick() sends them once it fills
+  bool pacing_ { false };
+  Pacer pacer_ {};
+  bool paced_out_ { false }; // is there something the bucket held back?
+  void update_pacing_rate();
+
+  bool gso_ { false }; // send runs of full-sized segments as one, for the adapter to cut apart
+
+  uint64_t now_ms_ { 0 }; // time since the sender was constructed
+
+  // An outstanding segment. Its payload stays in `input_` until it is acknowledged, and is sliced out of it
+  // again to be retransmitted.
+  struct Outstanding
+  {
+    uint64_t seqno;     // absolute
+    uint64_t length;    // sequence numbers, SYN and FIN included
+    bool SYN;
+    bool FIN;
+    uint64_t sent_ms;   // when it was last sent
+    bool retransmitted; // Karn's rule: its acknowledgment does not tell how long a round trip takes
+    bool sacked;        // the receiver holds it, but not everything before it
+    bool lost;          // RACK gave up on it, and it is waiting to be retransmitted
+
+    uint64_t end() const { return seqno + length; }
+    uint64_t payload_size() const { return length - SYN - FIN; }
+  };
+
+  // The outstanding segments, in order, are those from `first_seg_` on. An ack just moves `first_seg_` past the
+  // segments it covers; their room is reused once the vector is full, so it stops allocating at the largest
+  // number of segments in flight.
+  std::vector<Outstanding> ost_segs_ {};
+  size_t first_seg_ { 0 };
+  std::span<Outstanding> outstanding() { return std::span( ost_segs_ ).subspan( first_seg_ ); }
+  std::span<const Outstanding> outstanding() const { return std::span( ost_segs_ ).subspan( first_seg_ ); }
+  // the first outstanding segment that starts at or after `seqno`
+  std::span<Outstanding>::iterator outstanding_from( uint64_t seqno );
+
+  uint64_t bytes_sent() const { return abs_exp_ackno_ == 0 ? 0 : abs_exp_ackno_ - 1 - has_FIN_sent_; }
+  uint64_t bytes_unsent() const { return input_.writer().bytes_pushed() - bytes_sent(); }
+
+  // the segment of `payload_size` bytes at `seqno`, from the outbound stream, stamped to be sent now
+  TCPSenderMessage make_segment( uint64_t seqno, uint64_t payload_size, bool SYN, bool FIN ) const;
+  void stamp( TCPSenderMessage& msg ) const; // put the current time on a segment about to be (re)sent
+  // send an outstanding segment again (in pieces, if it was a larger segment than the path turned out to carry)
+  void retransmit( Outstanding& seg, const TransmitFunction& transmit );
+  void on_duplicate_ack();
+  void enter_recovery();
+  void mark_sacked( const TCPReceiverMessage& msg, uint64_t abs_ackno );
+  // the next segment to retransmit in fast recovery: one RACK found lost, else the first outstanding one, or with
+  // SACK the first one that is neither SACKed nor retransmitted yet while a later one is SACKed (null if none)
+  Outstanding* next_hole();
+  void retransmit_next_hole( const TransmitFunction& transmit );
+
+  void rack_delivered( const Outstanding& seg, uint64_t end );
+  void rack_detect_loss();
+  uint64_t reordering_window() const;
+  void arm_probe();
+  void send_probe( const TransmitFunction& transmit );
+
+  // the payload of the next segment, with `room` left in the window: larger than the MSS if it is time for a path MTU
+  // probe, 0 if the probe has to wait for the window to open
+  uint64_t next_segment_size( uint64_t room ) const;
+  void mtu_probe_delivered();
+  void mtu_probe_lost();
 };
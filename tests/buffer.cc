@@ -0,0 +1,77 @@
+#include "buffer.hh"
+#include "byte_stream.hh"
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      Buffer buf { string( 100, 'x' ) + "abc" };
+      const char* const address = buf.data();
+
+      const Buffer slice = buf.substr( 100 );
+      test_should_be( slice.data() == address + 100, true );
+      test_should_be( slice.view() == "abc", true );
+      test_should_be( slice.substr( 1, 1 ).view() == "b", true );
+
+      test_should_be( buf.append_in_place( "d" ), false ); // shared with `slice`
+      test_should_be( std::move( Buffer { slice } ).release() == "abc", true );
+
+      buf.remove_prefix( 100 );
+      test_should_be( buf.data() == slice.data(), true );
+      test_should_be( std::move( buf ).release() == "abc", true ); // copied: the string is still shared
+      test_should_be( slice.view() == "abc", true );
+
+      string owned( 100, 'y' );
+      const char* const owned_address = owned.data();
+      test_should_be( Buffer { std::move( owned ) }.data() == owned_address, true );
+      test_should_be( std::move( Buffer { string( 100, 'z' ) } ).release() == string( 100, 'z' ), true );
+    }
+
+    {
+      // a parsed payload shares the string it was read into, all the way to Reader::peek()
+      auto segment = []( uint64_t seqno, const string& payload, vector<string>& out ) {
+        TCPSegment seg;
+        seg.message.sender.seqno = Wrap32 { static_cast<uint32_t>( seqno ) };
+        seg.message.sender.payload = payload;
+        seg.compute_checksum( 0 );
+        out = serialize( seg );
+        return out.back().data();
+      };
+
+      vector<string> first;
+      vector<string> second;
+      const char* const first_address = segment( 1, string( 1000, 'a' ), first );
+      const char* const second_address = segment( 1001, string( 1000, 'b' ), second );
+
+      TCPSegment parsed_first;
+      TCPSegment parsed_second;
+      test_should_be( parse( parsed_first, std::move( first ), 0 ), true );
+      test_should_be( parse( parsed_second, std::move( second ), 0 ), true );
+      test_should_be( parsed_first.message.sender.payload.data() == first_address, true );
+
+      TCPReceiver receiver { Reassembler { ByteStream { 4000, ByteStream::Storage::Chunked } } };
+      receiver.receive( { .seqno = Wrap32 { 0 }, .SYN = true } );
+      receiver.receive( std::move( parsed_second.message.sender ) );
+      receiver.receive( std::move( parsed_first.message.sender ) );
+      test_should_be( receiver.reader().bytes_buffered(), uint64_t { 2000 } );
+      test_should_be( receiver.reader().peek().data() == first_address, true );
+      receiver.reader().pop( 1000 );
+      test_should_be( receiver.reader().peek().data() == second_address, true );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+#include "buffer_pool.hh"
+#include "byte_stream_test_harness.hh"
+#include "reassembler_test_harness.hh"
+#include "test_should_be.hh"
+
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <vector>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      BufferPool pool { 4096 };
+      test_should_be( pool.stats().pages_in_use, size_t { 0 } );
+      test_should_be( pool.stats().pages_reserved, size_t { 0 } );
+
+      {
+        vector<BufferPool::Page> pages;
+        for ( int i = 0; i < 3; ++i ) {
+          pages.push_back( pool.get() );
+        }
+        test_should_be( pages[0].size(), size_t { 4096 } );
+        test_should_be( pool.stats().pages_in_use, size_t { 3 } );
+        test_should_be( pool.stats().pages_reserved, BufferPool::kSlabSize / 4096 );
+
+        memcpy( pages[1].data(), "hello", 5 );
+        const BufferPool::Page copy = pages[1];
+        test_should_be( memcmp( copy.data(), "hello", 5 ) == 0, true );
+        test_should_be( pool.stats().pages_in_use, size_t { 4 } );
+
+        pages.pop_back();
+        test_should_be( pool.stats().pages_in_use, size_t { 3 } );
+      }
+
+      const BufferPool::Stats stats = pool.stats();
+      test_should_be( stats.pages_in_use, size_t { 0 } );
+      test_should_be( stats.high_water_mark, size_t { 4 } );
+      test_should_be( stats.allocation_failures, size_t { 0 } );
+
+      // a returned page is handed out again
+      optional<BufferPool::Page> first { pool.get() };
+      char* const address = first->data();
+      first.reset();
+      test_should_be( pool.get().data() == address, true );
+    }
+
+    {
+      BufferPool pool { 65536, { .max_pages = 2 } };
+      vector<BufferPool::Page> pages;
+      for ( int i = 0; i < 3; ++i ) {
+        pages.push_back( pool.get() );
+        memset( pages.back().data(), i, pages.back().size() ); // the page past the limit is usable too
+      }
+      test_should_be( pool.stats().pages_in_use, size_t { 2 } );
+      test_should_be( pool.stats().allocation_failures, size_t { 1 } );
+      pages.clear();
+      test_should_be( pool.stats().pages_in_use, size_t { 0 } );
+    }
+
+    test_should_be( &BufferPool::global() == &BufferPool::global( BufferPool::kDefaultPageSize ), true );
+    test_should_be( BufferPool::global( 65536 ).page_size(), size_t { 65536 } );
+
+    {
+      BufferPool pool { 8 };
+      {
+        ByteStreamTestHarness test { "pages-peek-separately", 30, ByteStream::Storage::Pooled, &pool };
+
+        test.execute( Push { "abcdef" } );
+        test.execute( Push { "ghijklmnopq" } );
+        test.execute( BytesBuffered { 17 } );
+        test.execute( PeekSpans { "abcdefgh", "ijklmnop" } );
+        test.execute( Pop { 3 } );
+        test.execute( PeekSpans { "defgh", "ijklmnop" } );
+        test.execute( Pop { 5 } );
+        test.execute( PeekSpans { "ijklmnop", "q" } );
+        test.execute( Push { "rstuvwxyz0123456789ABCDEF" } );
+        test.execute( BytesPushed { 38 } );
+        test.execute( AvailableCapacity { 0 } );
+        test.execute( Close {} );
+        test.execute( ReadAll { "ijklmnopqrstuvwxyz0123456789AB" } );
+        test.execute( IsFinished { true } );
+      }
+      test_should_be( pool.stats().pages_in_use, size_t { 0 } );
+
+      {
+        ReassemblerTestHarness test { "pending-bytes-in-pages", 40, &pool };
+
+        test.execute( Insert { "klmnopqrstuvwx", 10 } );
+        test.execute( Insert { "yz0123456789ABCDEF", 24 } );
+        test.execute( BytesPending { 30 } );
+        test.execute( Insert { "efghij", 4 } );
+        test.execute( Insert { "abcd", 0 } );
+        test.execute( BytesPending { 0 } );
+        test.execute( BytesPushed( 40 ) );
+        test.execute( ReadAll( "abcdefghijklmnopqrstuvwxyz0123456789ABCD" ) );
+        test.execute( Insert { "EF", 40 }.is_last() );
+        test.execute( ReadAll( "EF" ) );
+        test.execute( IsFinished { true } );
+      }
+      test_should_be( pool.stats().pages_in_use, size_t { 0 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
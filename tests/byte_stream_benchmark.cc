@@ -0,0 +1,282 @@
+#include "byte_stream.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <queue>
+#include <random>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+/*
+ * byte_stream_benchmark: sweep ByteStream configurations and report throughput and per-call latency.
+ *
+ *   byte_stream_benchmark [--format csv|json] [--repeat N] [--quick]
+ *
+ * Every point of the matrix (storage x capacity x write size x read size x payload length) runs N times. Each
+ * repetition streams the payload through the ByteStream twice: once untimed inside the loop, for throughput, and
+ * once timing every push and every peek+pop, for latency (less the cost of reading the clock).
+ */
+
+struct Point
+{
+  ByteStream::Storage storage;
+  size_t capacity;
+  size_t write_size;
+  size_t read_size;
+  size_t payload_len;
+};
+
+struct Result
+{
+  Point point;
+  size_t repeat;
+  double gbps_median;
+  double gbps_p99; // throughput of the slowest 1% of runs
+  double push_ns_median;
+  double push_ns_p99;
+  double pop_ns_median;
+  double pop_ns_p99;
+};
+
+static string storage_name( ByteStream::Storage storage )
+{
+  switch ( storage ) {
+    case ByteStream::Storage::Ring:
+      return "ring";
+    case ByteStream::Storage::Chunked:
+      return "chunked";
+    case ByteStream::Storage::Mapped:
+      return "mapped";
+    case ByteStream::Storage::Pooled:
+      return "pooled";
+  }
+  return "unknown";
+}
+
+// nearest-rank percentile
+template<typename T>
+static T percentile( vector<T>& samples, double p )
+{
+  const size_t rank = static_cast<size_t>( p / 100 * static_cast<double>( samples.size() - 1 ) + 0.5 );
+  nth_element( samples.begin(), samples.begin() + static_cast<ptrdiff_t>( rank ), samples.end() );
+  return samples[rank];
+}
+
+// median cost of reading the clock, subtracted from each timed call
+static double clock_overhead_ns()
+{
+  vector<double> samples;
+  for ( int i = 0; i < 10001; ++i ) {
+    const auto start = steady_clock::now();
+    const auto stop = steady_clock::now();
+    samples.push_back( duration<double, nano>( stop - start ).count() );
+  }
+  return percentile( samples, 50 );
+}
+
+// Stream `data` through a ByteStream; with `push_ns` and `pop_ns`, time every call. Returns the elapsed time.
+static duration<double> run( const Point& point,
+                             const string& data,
+                             vector<double>* push_ns = nullptr,
+                             vector<double>* pop_ns = nullptr )
+{
+  queue<string> split_data;
+  for ( size_t i = 0; i < data.size(); i += point.write_size ) {
+    split_data.emplace( data.substr( i, point.write_size ) );
+  }
+
+  ByteStream bs { point.capacity, point.storage };
+  string output_data;
+  output_data.reserve( data.size() );
+
+  const auto start_time = steady_clock::now();
+  while ( not bs.reader().is_finished() ) {
+    if ( split_data.empty() ) {
+      if ( not bs.writer().is_closed() ) {
+        bs.writer().close();
+      }
+    } else if ( split_data.front().size() <= bs.writer().available_capacity() ) {
+      if ( push_ns ) {
+        const auto before = steady_clock::now();
+        bs.writer().push( move( split_data.front() ) );
+        push_ns->push_back( duration<double, nano>( steady_clock::now() - before ).count() );
+      } else {
+        bs.writer().push( move( split_data.front() ) );
+      }
+      split_data.pop();
+    }
+
+    if ( bs.reader().bytes_buffered() ) {
+      const auto before = pop_ns ? steady_clock::now() : steady_clock::time_point {};
+      auto peeked = bs.reader().peek().substr( 0, point.read_size );
+      if ( peeked.empty() ) {
+        throw runtime_error( "ByteStream::reader().peek() returned empty view" );
+      }
+      output_data += peeked;
+      bs.reader().pop( peeked.size() );
+      if ( pop_ns ) {
+        pop_ns->push_back( duration<double, nano>( steady_clock::now() - before ).count() );
+      }
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+  return stop_time - start_time;
+}
+
+static Result measure( const Point& point, const string& data, size_t repeat, double overhead_ns )
+{
+  vector<double> gbps;
+  vector<double> push_ns;
+  vector<double> pop_ns;
+  run( point, data ); // warm up the allocator and the caches
+  for ( size_t i = 0; i < repeat; ++i ) {
+    gbps.push_back( 8 * static_cast<double>( data.size() ) / run( point, data ).count() / 1e9 );
+    run( point, data, &push_ns, &pop_ns );
+  }
+  for ( auto* samples : { &push_ns, &pop_ns } ) {
+    for ( double& ns : *samples ) {
+      ns = max( 0.0, ns - overhead_ns );
+    }
+  }
+
+  return { point,
+           repeat,
+           percentile( gbps, 50 ),
+           percentile( gbps, 1 ),
+           percentile( push_ns, 50 ),
+           percentile( push_ns, 99 ),
+           percentile( pop_ns, 50 ),
+           percentile( pop_ns, 99 ) };
+}
+
+static void print_csv( const vector<Result>& results )
+{
+  cout << "storage,capacity,write_size,read_size,payload_len,repeat,gbps_median,gbps_p99,push_ns_median,push_ns_p99,"
+          "pop_ns_median,pop_ns_p99\n";
+  cout << fixed << setprecision( 2 );
+  for ( const auto& r : results ) {
+    cout << storage_name( r.point.storage ) << "," << r.point.capacity << "," << r.point.write_size << ","
+         << r.point.read_size << "," << r.point.payload_len << "," << r.repeat << "," << r.gbps_median << ","
+         << r.gbps_p99 << "," << r.push_ns_median << "," << r.push_ns_p99 << "," << r.pop_ns_median << ","
+         << r.pop_ns_p99 << "\n";
+  }
+}
+
+static void print_json( const vector<Result>& results )
+{
+  cout << "[\n" << fixed << setprecision( 2 );
+  for ( size_t i = 0; i < results.size(); ++i ) {
+    const auto& r = results[i];
+    cout << "  {\"storage\": \"" << storage_name( r.point.storage ) << "\", \"capacity\": " << r.point.capacity
+         << ", \"write_size\": " << r.point.write_size << ", \"read_size\": " << r.point.read_size
+         << ", \"payload_len\": " << r.point.payload_len << ", \"repeat\": " << r.repeat
+         << ", \"gbps_median\": " << r.gbps_median << ", \"gbps_p99\": " << r.gbps_p99
+         << ", \"push_ns_median\": " << r.push_ns_median << ", \"push_ns_p99\": " << r.push_ns_p99
+         << ", \"pop_ns_median\": " << r.pop_ns_median << ", \"pop_ns_p99\": " << r.pop_ns_p99 << "}"
+         << ( i + 1 < results.size() ? ",\n" : "\n" );
+  }
+  cout << "]\n";
+}
+
+static string make_data( const size_t input_len, const size_t random_seed )
+{
+  default_random_engine rd { random_seed };
+  uniform_int_distribution<char> ud;
+  string ret;
+  for ( size_t i = 0; i < input_len; ++i ) {
+    ret += ud( rd );
+  }
+  return ret;
+}
+
+void program_body( const vector<string_view>& args )
+{
+  string format = "csv";
+  size_t repeat = 7;
+  bool quick = false;
+  for ( size_t i = 0; i < args.size(); ++i ) {
+    if ( args[i] == "--format" and i + 1 < args.size() ) {
+      format = args[++i];
+    } else if ( args[i] == "--repeat" and i + 1 < args.size() ) {
+      repeat = stoul( string( args[++i] ) );
+    } else if ( args[i] == "--quick" ) {
+      quick = true;
+    } else {
+      throw runtime_error( "usage: byte_stream_benchmark [--format csv|json] [--repeat N] [--quick]" );
+    }
+  }
+  if ( format != "csv" and format != "json" ) {
+    throw runtime_error( "unknown format: " + format );
+  }
+  if ( repeat == 0 ) {
+    throw runtime_error( "--repeat must be positive" );
+  }
+
+  const vector<ByteStream::Storage> storages { ByteStream::Storage::Ring,
+                                               ByteStream::Storage::Chunked,
+                                               ByteStream::Storage::Pooled,
+                                               ByteStream::Storage::Mapped };
+  vector<size_t> capacities { 4096, 65536, 1048576 };
+  vector<size_t> write_sizes { 128, 1500, 16384 };
+  vector<size_t> read_sizes { 128, 1500, 65536 };
+  vector<size_t> payload_lens { 1000000, 10000000 };
+  if ( quick ) {
+    capacities = { 65536 };
+    write_sizes = { 1500 };
+    read_sizes = { 1500 };
+    payload_lens = { 1000000 };
+    repeat = min( repeat, size_t { 3 } );
+  }
+
+  map<size_t, string> payloads;
+  for ( const size_t len : payload_lens ) {
+    payloads[len] = make_data( len, len );
+  }
+
+  const double overhead_ns = clock_overhead_ns();
+  vector<Result> results;
+  for ( const auto storage : storages ) {
+    for ( const size_t capacity : capacities ) {
+      for ( const size_t write_size : write_sizes ) {
+        if ( write_size > capacity ) {
+          continue; // each write waits until it fits entirely
+        }
+        for ( const size_t read_size : read_sizes ) {
+          for ( const size_t payload_len : payload_lens ) {
+            const Point point { storage, capacity, write_size, read_size, payload_len };
+            results.push_back( measure( point, payloads.at( payload_len ), repeat, overhead_ns ) );
+          }
+        }
+      }
+    }
+  }
+
+  if ( format == "json" ) {
+    print_json( results );
+  } else {
+    print_csv( results );
+  }
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    program_body( { argv + 1, argv + argc } );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
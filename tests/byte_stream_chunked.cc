@@ -0,0 +1,99 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto chunked = ByteStream::Storage::Chunked;
+
+    {
+      const string a = "abcdefghijklmnop";
+      const string b = "qrstuvwxyz012345";
+      const string c = "6789ABCDEFGHIJKLMNOP";
+      ByteStreamTestHarness test { "chunks-peek-separately", 100, chunked };
+
+      test.execute( Push { a } );
+      test.execute( Push { b } );
+      test.execute( Push { "" } );
+      test.execute( Push { c } );
+
+      test.execute( BytesPushed { 52 } );
+      test.execute( BytesBuffered { 52 } );
+      test.execute( AvailableCapacity { 48 } );
+      test.execute( Peek { a + b + c } );
+
+      test.execute( Pop { 1 } );
+      test.execute( PeekSpans { a.substr( 1 ), b } );
+      test.execute( Pop { 20 } );
+      test.execute( PeekSpans { b.substr( 5 ), c } );
+      test.execute( Pop { 11 } );
+      test.execute( PeekOnce { c } );
+      test.execute( AvailableCapacity { 80 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "chunks-truncated-to-capacity", 5, chunked };
+
+      test.execute( Push { "abc" } );
+      test.execute( Push { "defg" } );
+      test.execute( BytesPushed { 5 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( Push { "h" } );
+      test.execute( BytesPushed { 5 } );
+      test.execute( Peek { "abcde" } );
+
+      test.execute( Pop { 4 } );
+      test.execute( AvailableCapacity { 4 } );
+      test.execute( Push { "hijkl" } );
+      test.execute( BytesBuffered { 5 } );
+      test.execute( Close {} );
+      test.execute( ReadAll { "ehijk" } );
+      test.execute( IsFinished { true } );
+      test.execute( BytesPopped { 9 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "small-chunks-coalesce", 100, chunked };
+
+      test.execute( Push { "a" } );
+      test.execute( Push { "bb" } );
+      test.execute( Push { "ccc" } );
+      test.execute( PeekOnce { "abbccc" } );
+      test.execute( Pop { 4 } );
+      test.execute( PeekOnce { "cc" } );
+      test.execute( BytesBuffered { 2 } );
+      test.execute( Pop { 2 } );
+      test.execute( BufferEmpty { true } );
+      test.execute( AvailableCapacity { 100 } );
+    }
+
+    {
+      const string a = "abcdefghijklmnop";
+      const string b = "qrstuvwxyz012345";
+      ByteStreamTestHarness test { "chunks-sliced-in-place", 100, chunked };
+
+      test.execute( Push { a } );
+      test.execute( Push { b } );
+      test.execute( Slice { 2, 5, "cdefg" }.sharing_front() );
+      test.execute( Slice { 20, 4, "uvwx" } );
+      test.execute( Slice { 14, 4, "opqr" } );
+      test.execute( Slice { 30, 10, "45" } );
+      test.execute( Slice { 40, 10, "" } );
+
+      test.execute( Pop { 17 } );
+      test.execute( Slice { 0, 3, "rst" }.sharing_front() );
+      test.execute( Slice { 13, 5, "45" } );
+      test.execute( BytesBuffered { 15 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
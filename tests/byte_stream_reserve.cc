@@ -0,0 +1,117 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+#include "exception.hh"
+#include "file_descriptor.hh"
+
+#include <array>
+#include <exception>
+#include <iostream>
+#include <unistd.h>
+
+using namespace std;
+
+void fd_round_trip( ByteStream::Storage storage )
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "pipe", ::pipe( fds.data() ) );
+  FileDescriptor read_end { fds[0] };
+  FileDescriptor write_end { fds[1] };
+
+  ByteStream bs { 8, storage };
+  bs.writer().push( "abcdef" );
+  bs.reader().pop( 4 );
+
+  write_end.write( "ghijklmnop" );
+  if ( bs.writer().read_from( read_end ) != 6 or bs.reader().bytes_buffered() != 8 ) {
+    throw runtime_error( "Writer::read_from() did not fill the available capacity" );
+  }
+
+  if ( bs.reader().write_to( write_end ) != 8 or bs.reader().bytes_popped() != 12 ) {
+    throw runtime_error( "Reader::write_to() did not write all buffered bytes" );
+  }
+
+  string out;
+  read_end.read( out );
+  if ( out != "mnopefghijkl" ) {
+    throw runtime_error( "Expected \"mnopefghijkl\" through the pipe, got \"" + out + "\"" );
+  }
+
+  write_end.close();
+  bs.writer().read_from( read_end );
+  if ( not read_end.eof() ) {
+    throw runtime_error( "Writer::read_from() did not reach EOF" );
+  }
+
+  // a read much smaller than the capacity takes just the bytes that are ready, then still tells EOF
+  CheckSystemCall( "pipe", ::pipe( fds.data() ) );
+  FileDescriptor small_read_end { fds[0] };
+  FileDescriptor small_write_end { fds[1] };
+  ByteStream large { 100000, storage };
+  small_write_end.write( "qrs" );
+  small_write_end.close();
+  if ( large.writer().read_from( small_read_end ) != 3 or large.reader().peek() != "qrs" ) {
+    throw runtime_error( "Writer::read_from() did not read the 3 bytes ready" );
+  }
+  if ( large.writer().read_from( small_read_end ) != 0 or not small_read_end.eof() ) {
+    throw runtime_error( "Writer::read_from() did not reach EOF after a small read" );
+  }
+}
+
+int main()
+{
+  try {
+    for ( const auto storage : { ByteStream::Storage::Ring, ByteStream::Storage::Chunked } ) {
+      {
+        ByteStreamTestHarness test { "reserve-commit", 8, storage };
+
+        test.execute( ReserveCommit { "abcde", 3 } );
+        test.execute( BytesPushed { 3 } );
+        test.execute( AvailableCapacity { 5 } );
+        test.execute( Peek { "abc" } );
+
+        test.execute( ReserveCommit { "defghijk", 8 } );
+        test.execute( BytesPushed { 8 } );
+        test.execute( AvailableCapacity { 0 } );
+        test.execute( Pop { 6 } );
+        test.execute( Peek { "gh" } );
+      }
+
+      {
+        ByteStreamTestHarness test { "reserve-wraps", 4, storage };
+
+        test.execute( Push { "abc" } );
+        test.execute( Pop { 2 } );
+        test.execute( ReserveCommit { "xyz", 2 } );
+        test.execute( ReserveCommit { "zzzz", 0 } );
+        test.execute( BytesPushed { 5 } );
+        test.execute( Peek { "cxy" } );
+        test.execute( Close {} );
+        test.execute( ReserveCommit { "w", 1 } );
+        test.execute( BytesPushed { 5 } );
+        test.execute( ReadAll { "cxy" } );
+        test.execute( IsFinished { true } );
+      }
+
+      {
+        // the ring is allocated lazily, so it may hold much less than the capacity
+        ByteStreamTestHarness test { "commit-past-reservation", 100000, storage };
+
+        test.execute( ReserveCommit { "abc", 50000 } );
+        test.execute( BytesPushed { 3 } );
+        test.execute( AvailableCapacity { 99997 } );
+        test.execute( Peek { "abc" } );
+        test.execute( ReserveCommit { "", 50000 } );
+        test.execute( BytesPushed { 3 } );
+        test.execute( Push { "def" } );
+        test.execute( ReadAll { "abcdef" } );
+      }
+
+      fd_round_trip( storage );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
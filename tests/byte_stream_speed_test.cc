@@ -15,7 +15,8 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
                  const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t write_size,  // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t read_size )  // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t read_size,   // NOLINT(bugprone-easily-swappable-parameters)
+                 const ByteStream::Storage storage = ByteStream::Storage::Ring )
 {
   // Generate the data to be written
   const string data = [&random_seed, &input_len] {
@@ -34,7 +35,7 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
     split_data.emplace( data.substr( i, write_size ) );
   }
 
-  ByteStream bs { capacity };
+  ByteStream bs { capacity, storage };
   string output_data;
   output_data.reserve( data.size() );
 
@@ -75,8 +76,9 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
   fstream debug_output;
   debug_output.open( "/dev/tty" );
 
-  cout << "ByteStream with capacity=" << capacity << ", write_size=" << write_size << ", read_size=" << read_size
-       << " reached " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
+  cout << ( storage == ByteStream::Storage::Chunked ? "Chunked " : "" ) << "ByteStream with capacity=" << capacity
+       << ", write_size=" << write_size << ", read_size=" << read_size << " reached " << fixed << setprecision( 2 )
+       << gigabits_per_second << " Gbit/s.\n";
 
   debug_output << "             ByteStream throughput: " << fixed << setprecision( 2 ) << gigabits_per_second
                << " Gbit/s\n";
@@ -89,6 +91,13 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
 void program_body()
 {
   speed_test( 1e7, 32768, 789, 1500, 128 );
+  speed_test( 1e7, 32768, 790, 1500, 1500 );
+  speed_test( 1e7, 4096, 791, 1500, 512 );
+  speed_test( 1e7, 65536, 792, 1000, 4096 );
+  speed_test( 1e7, 1048576, 793, 16384, 65536 );
+
+  speed_test( 1e7, 32768, 789, 1500, 128, ByteStream::Storage::Chunked );
+  speed_test( 1e7, 1048576, 793, 16384, 65536, ByteStream::Storage::Chunked );
 }
 
 int main()
@@ -0,0 +1,114 @@
+#include "byte_stream.hh"
+#include "mapped_file.hh"
+
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <linux/magic.h>
+#include <stdexcept>
+#include <string>
+#include <sys/vfs.h>
+
+using namespace std;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "Mapped storage: " + what );
+  }
+}
+
+// bytes of file-backed and shared memory that this process has mapped in, from /proc/self/status
+uint64_t resident_file_bytes()
+{
+  ifstream status { "/proc/self/status" };
+  uint64_t total = 0;
+  string key;
+  while ( status >> key ) {
+    uint64_t kib = 0;
+    if ( key == "RssFile:" or key == "RssShmem:" ) {
+      status >> kib;
+      total += kib * 1024;
+    }
+    status.ignore( numeric_limits<streamsize>::max(), '\n' );
+  }
+  return total;
+}
+
+bool in_memory( const string& dir )
+{
+  struct statfs fs {};
+  return ::statfs( dir.c_str(), &fs ) == 0 and ( fs.f_type == TMPFS_MAGIC or fs.f_type == RAMFS_MAGIC );
+}
+
+void resident_memory_test()
+{
+  static constexpr uint64_t capacity = 16 * 1024 * 1024;
+  static constexpr uint64_t limit = 4 * ByteStream::kMappedWindow + 1024 * 1024; // both windows, and some slack
+
+  ByteStream bs { capacity, ByteStream::Storage::Mapped };
+  const uint64_t before = resident_file_bytes();
+
+  // fill the stream without reading: all but the windows at its two ends are spilled
+  string chunk( 64 * 1024, 0 );
+  for ( uint64_t pushed = 0; pushed < capacity; pushed += chunk.size() ) {
+    for ( uint64_t i = 0; i < chunk.size(); i += sizeof( uint64_t ) ) {
+      const uint64_t index = pushed + i;
+      memcpy( chunk.data() + i, &index, sizeof( index ) );
+    }
+    bs.writer().push( chunk );
+    const uint64_t resident = resident_file_bytes();
+    expect( resident < before + limit,
+            to_string( resident - before ) + " bytes resident at " + to_string( pushed + chunk.size() ) );
+  }
+  expect( bs.writer().available_capacity() == 0, "full" );
+
+  // the spilled bytes come back in
+  for ( uint64_t popped = 0; popped < capacity; ) {
+    const string_view view = bs.reader().peek();
+    const uint64_t aligned = view.size() / sizeof( uint64_t ) * sizeof( uint64_t );
+    for ( uint64_t i = 0; i < aligned; i += sizeof( uint64_t ) ) {
+      uint64_t index = 0;
+      memcpy( &index, view.data() + i, sizeof( index ) );
+      expect( index == popped + i, "bytes read back at " + to_string( popped + i ) );
+    }
+    bs.reader().pop( aligned );
+    popped += aligned;
+  }
+}
+
+void directory_test()
+{
+  // a directory in memory is passed over for one on disk
+  if ( in_memory( "/dev/shm" ) and not in_memory( "/var/tmp" ) ) {
+    MappedFile::set_directory( "/dev/shm" );
+    const MappedFile file { 4096 };
+    expect( not file.memory_backed(), "spilled to a tmpfs" );
+  }
+
+  // a directory that cannot be used is passed over too
+  MappedFile::set_directory( "/nonexistent/minnow" );
+  expect( MappedFile::directory() == "/nonexistent/minnow", "set_directory()" );
+  {
+    MappedFile file { 4096 };
+    file.data()[0] = 'x';
+  }
+
+  MappedFile::set_directory( "" );
+  expect( MappedFile::directory() != "/nonexistent/minnow", "the default directory is restored" );
+}
+
+int main()
+{
+  try {
+    directory_test();
+    resident_memory_test();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
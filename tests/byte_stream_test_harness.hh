@@ -3,6 +3,7 @@
 #include "byte_stream.hh"
 #include "common.hh"
 
+#include <algorithm>
 #include <concepts>
 #include <optional>
 #include <utility>
@@ -16,10 +17,29 @@ static_assert( sizeof( Writer ) == sizeof( ByteStream ),
 class ByteStreamTestHarness : public TestHarness<ByteStream>
 {
 public:
-  ByteStreamTestHarness( std::string test_name, uint64_t capacity )
-    : TestHarness( move( test_name ), "capacity=" + std::to_string( capacity ), ByteStream { capacity } )
+  ByteStreamTestHarness( std::string test_name,
+                         uint64_t capacity,
+                         ByteStream::Storage storage = ByteStream::Storage::Ring,
+                         BufferPool* pool = nullptr )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity ) + storage_description( storage, pool ),
+                   ByteStream { capacity, storage, pool } )
   {}
 
+  static std::string storage_description( ByteStream::Storage storage, BufferPool* pool )
+  {
+    switch ( storage ) {
+      case ByteStream::Storage::Chunked:
+        return ", chunked storage";
+      case ByteStream::Storage::Mapped:
+        return ", mapped storage";
+      case ByteStream::Storage::Pooled:
+        return ", pooled storage" + ( pool ? " (" + std::to_string( pool->page_size() ) + "-byte pages)" : "" );
+      default:
+        return "";
+    }
+  }
+
   size_t peek_size() { return object().reader().peek().size(); }
 };
 
@@ -34,6 +54,27 @@ struct Push : public Action<ByteStream>
   void execute( ByteStream& bs ) const override { bs.writer().push( data_ ); }
 };
 
+struct ReserveCommit : public Action<ByteStream>
+{
+  std::string data_;
+  size_t commit_len_;
+
+  ReserveCommit( std::string data, size_t commit_len ) : data_( move( data ) ), commit_len_( commit_len ) {}
+  std::string description() const override
+  {
+    return "reserve " + std::to_string( data_.size() ) + ", write \"" + Printer::prettify( data_ ) + "\", commit "
+           + std::to_string( commit_len_ );
+  }
+  void execute( ByteStream& bs ) const override
+  {
+    const auto regions = bs.writer().reserve( data_.size() );
+    const std::string_view data = std::string_view( data_ ).substr( 0, regions[0].size() + regions[1].size() );
+    std::copy( data.begin(), data.begin() + regions[0].size(), regions[0].begin() );
+    std::copy( data.begin() + regions[0].size(), data.end(), regions[1].begin() );
+    bs.writer().commit( commit_len_ );
+  }
+};
+
 struct Close : public Action<ByteStream>
 {
   std::string description() const override { return "close"; }
@@ -46,6 +87,12 @@ struct SetError : public Action<ByteStream>
   void execute( ByteStream& bs ) const override { bs.set_error(); }
 };
 
+struct ReleaseBuffer : public Action<ByteStream>
+{
+  std::string description() const override { return "release_buffer"; }
+  void execute( ByteStream& bs ) const override { bs.release_buffer(); }
+};
+
 struct Pop : public Action<ByteStream>
 {
   size_t len_;
@@ -107,6 +154,71 @@ struct PeekOnce : public Peek
   }
 };
 
+struct PeekSpans : public Expectation<ByteStream>
+{
+  std::string first_;
+  std::string second_;
+
+  PeekSpans( std::string first, std::string second ) : first_( move( first ) ), second_( move( second ) ) {}
+
+  std::string description() const override
+  {
+    return "peek_spans() gives \"" + Printer::prettify( first_ ) + "\" and \"" + Printer::prettify( second_ )
+           + "\"";
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    const auto spans = bs.reader().peek_spans();
+    if ( spans[0] != first_ or spans[1] != second_ ) {
+      throw ExpectationViolation { "Expected spans \"" + Printer::prettify( first_ ) + "\" and \""
+                                   + Printer::prettify( second_ ) + "\", but found \""
+                                   + Printer::prettify( spans[0] ) + "\" and \"" + Printer::prettify( spans[1] )
+                                   + "\"" };
+    }
+  }
+};
+
+struct Slice : public Expectation<ByteStream>
+{
+  uint64_t offset_;
+  uint64_t len_;
+  std::string output_;
+  bool shares_front_ {}; // must the slice point into the front chunk, as peek() does?
+
+  Slice( uint64_t offset, uint64_t len, std::string output )
+    : offset_( offset ), len_( len ), output_( move( output ) )
+  {}
+
+  Slice& sharing_front()
+  {
+    shares_front_ = true;
+    return *this;
+  }
+
+  std::string description() const override
+  {
+    return "slice( " + std::to_string( offset_ ) + ", " + std::to_string( len_ ) + " ) gives \""
+           + Printer::prettify( output_ ) + "\"" + ( shares_front_ ? " without copying" : "" );
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    const uint64_t buffered = bs.reader().bytes_buffered();
+    const Buffer got = bs.reader().slice( offset_, len_ );
+    if ( got.view() != output_ ) {
+      throw ExpectationViolation { "Expected slice \"" + Printer::prettify( output_ ) + "\", but found \""
+                                   + Printer::prettify( got.view() ) + "\"" };
+    }
+    if ( shares_front_ and got.data() != bs.reader().peek().data() + offset_ ) {
+      throw ExpectationViolation { "Expected the slice to share the front chunk, but it was copied" };
+    }
+    if ( bs.reader().bytes_buffered() != buffered ) {
+      throw ExpectationViolation { "Reader::slice() changed the number of bytes buffered" };
+    }
+  }
+};
+
 struct IsClosed : public ConstExpectBool<ByteStream>
 {
   using ConstExpectBool::ConstExpectBool;
@@ -0,0 +1,87 @@
+#include "byte_stream.hh"
+#include "test_should_be.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static void watermarks_test( ByteStream::Storage storage )
+{
+  {
+    ByteStream bs { 10, storage };
+    int readable = 0;
+    int writable = 0;
+    bs.on_readable( [&] { ++readable; }, 4 );
+    bs.on_writable( [&] { ++writable; }, 3 );
+
+    bs.writer().push( "abc" );
+    test_should_be( readable, 0 ); // below the low watermark
+    bs.writer().push( "def" );
+    test_should_be( readable, 1 );
+    bs.writer().push( "ghi" );
+    test_should_be( readable, 1 ); // still readable: no new transition
+    test_should_be( writable, 0 ); // was writable when the callback was set
+
+    bs.writer().push( "jkl" );
+    bs.reader().pop( 1 );
+    test_should_be( writable, 0 ); // one byte free is below the free watermark
+    bs.reader().pop( 2 );
+    test_should_be( writable, 1 );
+    bs.reader().pop( 5 );
+    test_should_be( writable, 1 );
+    test_should_be( readable, 1 );
+
+    bs.reader().pop( 2 ); // empty now: no longer readable
+    bs.writer().push( "mnop" );
+    test_should_be( readable, 2 );
+  }
+
+  {
+    ByteStream bs { 4, storage };
+    int readable = 0;
+    int writable = 0;
+    bs.on_readable( [&] { ++readable; } );
+    bs.on_writable( [&] { ++writable; } );
+
+    bs.writer().close();
+    test_should_be( readable, 1 ); // closing makes the stream readable (finished)
+
+    ByteStream errored { 4, storage };
+    errored.writer().push( "abcd" );
+    errored.on_writable( [&] { ++writable; } );
+    errored.set_error();
+    test_should_be( writable, 1 ); // an error wakes up the writer too
+  }
+
+  {
+    // a callback may push again right away
+    ByteStream bs { 8, storage };
+    int writable = 0;
+    bs.on_writable( [&] {
+      ++writable;
+      bs.writer().push( "xy" );
+    } );
+    bs.writer().push( "abcdefgh" );
+    bs.reader().pop( 2 );
+    test_should_be( writable, 1 );
+    test_should_be( bs.writer().available_capacity(), uint64_t { 0 } );
+    string out;
+    read( bs.reader(), 8, out );
+    test_should_be( out == "cdefghxy", true );
+  }
+}
+
+int main()
+{
+  try {
+    watermarks_test( ByteStream::Storage::Ring );
+    watermarks_test( ByteStream::Storage::Chunked );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
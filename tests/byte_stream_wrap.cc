@@ -0,0 +1,116 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "wrap-around", 4 };
+
+      test.execute( Push { "abc" } );
+      test.execute( Pop { 2 } );
+      test.execute( Push { "def" } );
+
+      test.execute( BytesPushed { 6 } );
+      test.execute( BytesBuffered { 4 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( PeekSpans { "cd", "ef" } );
+      test.execute( PeekOnce { "cd" } );
+      test.execute( Peek { "cdef" } );
+
+      test.execute( Pop { 2 } );
+      test.execute( PeekSpans { "ef", "" } );
+      test.execute( Push { "ghij" } );
+      test.execute( BytesPushed { 8 } );
+      test.execute( PeekSpans { "efgh", "" } );
+      test.execute( Pop { 3 } );
+      test.execute( Push { "ijk" } );
+      test.execute( PeekSpans { "h", "ijk" } );
+      test.execute( Peek { "hijk" } );
+      test.execute( Slice { 0, 4, "hijk" } );
+      test.execute( Slice { 1, 2, "ij" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "wrap-exact-fit", 3 };
+
+      test.execute( Push { "ab" } );
+      test.execute( Pop { 1 } );
+      test.execute( Push { "cd" } );
+      test.execute( PeekSpans { "bc", "d" } );
+      test.execute( Pop { 2 } );
+      test.execute( PeekSpans { "d", "" } );
+      test.execute( Close {} );
+      test.execute( IsFinished { false } );
+      test.execute( ReadAll { "d" } );
+      test.execute( IsFinished { true } );
+      test.execute( BytesPopped { 4 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "drain-rewinds", 4 };
+
+      test.execute( Push { "abc" } );
+      test.execute( Pop { 3 } );
+      test.execute( Push { "defg" } );
+      test.execute( PeekSpans { "defg", "" } );
+      test.execute( PeekOnce { "defg" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "over-pop", 4 };
+
+      test.execute( Push { "ab" } );
+      test.execute( Pop { 3 } );
+      test.execute( BytesPopped { 2 } );
+      test.execute( BufferEmpty { true } );
+      test.execute( AvailableCapacity { 4 } );
+    }
+
+    {
+      const string a( 5000, 'a' );
+      const string b( 5000, 'b' );
+      const string c( 9000, 'c' );
+      ByteStreamTestHarness test { "grow-while-wrapped", 20000 };
+
+      test.execute( Push { a } );
+      test.execute( Pop { 3000 } );
+      test.execute( Push { b } );
+      test.execute( Pop { 1000 } );
+      test.execute( Push { c } );
+      test.execute( BytesBuffered { 15000 } );
+      test.execute( AvailableCapacity { 5000 } );
+      test.execute( PeekSpans { a.substr( 4000 ) + b + c, "" } );
+      test.execute( Pop { 15000 } );
+      test.execute( BufferEmpty { true } );
+    }
+
+    {
+      ByteStreamTestHarness test { "release-buffer", 8 };
+
+      test.execute( Push { "abcdef" } );
+      test.execute( ReleaseBuffer {} );
+      test.execute( Peek { "abcdef" } );
+      test.execute( Pop { 6 } );
+      test.execute( ReleaseBuffer {} );
+      test.execute( BufferEmpty { true } );
+      test.execute( AvailableCapacity { 8 } );
+      test.execute( Push { "ghijklmnop" } );
+      test.execute( BytesPushed { 14 } );
+      test.execute( Peek { "ghijklmn" } );
+      test.execute( Close {} );
+      test.execute( ReadAll { "ghijklmn" } );
+      test.execute( IsFinished { true } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
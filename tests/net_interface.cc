@@ -320,6 +320,39 @@ int main()
         serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5" ) ) ) } );
       test.execute( ExpectNoFrame {} );
     }
+
+    {
+      // nothing fragments a datagram too long for the link: it is dropped, before any ARP request goes out
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test { "datagrams longer than the MTU", local_eth, Address( "4.3.2.1", 0 ) };
+      auto datagram = make_datagram( "5.6.7.8", "13.12.11.10" );
+      datagram.payload = { string( EthernetHeader::MTU - datagram.header.hlen * 4 + 1, 'x' ) };
+      datagram.header.len = EthernetHeader::MTU + 1;
+      datagram.header.compute_checksum();
+      test.execute( SendDatagram { datagram, Address( "192.168.0.1", 0 ) } );
+      test.execute( ExpectNoFrame {} );
+
+      // a link with jumbo frames takes it
+      NetworkInterfaceTestHarness jumbo {
+        "jumbo frames", local_eth, Address( "4.3.2.1", 0 ), EthernetHeader::JUMBO_MTU };
+      jumbo.execute( SendDatagram { datagram, Address( "192.168.0.1", 0 ) } );
+      jumbo.execute( ExpectFrame { make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "4.3.2.1", {}, "192.168.0.1" ) ) ) } );
+      const EthernetAddress target_eth = random_private_ethernet_address();
+      jumbo.execute( ReceiveFrame {
+        make_frame(
+          target_eth,
+          local_eth,
+          EthernetHeader::TYPE_ARP, // NOLINTNEXTLINE(*-suspicious-*)
+          serialize( make_arp( ARPMessage::OPCODE_REPLY, target_eth, "192.168.0.1", local_eth, "4.3.2.1" ) ) ),
+        {} } );
+      jumbo.execute(
+        ExpectFrame { make_frame( local_eth, target_eth, EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+      jumbo.execute( ExpectNoFrame {} );
+    }
   } catch ( const exception& e ) {
     cerr << e.what() << endl;
     return EXIT_FAILURE;
@@ -23,10 +23,11 @@ class NetworkInterfaceTestHarness : public TestHarness<InterfaceAndOutput>
 public:
   NetworkInterfaceTestHarness( std::string test_name,
                                const EthernetAddress& ethernet_address,
-                               const Address& ip_address )
+                               const Address& ip_address,
+                               size_t mtu = EthernetHeader::MTU )
     : TestHarness( move( test_name ), "eth=" + to_string( ethernet_address ) + ", ip=" + ip_address.ip(), [&] {
       const Output output { std::make_shared<FramesOut>() };
-      const NetworkInterface iface { "test", output, ethernet_address, ip_address };
+      const NetworkInterface iface { "test", output, ethernet_address, ip_address, mtu };
       return InterfaceAndOutput { iface, output };
     }() )
   {}
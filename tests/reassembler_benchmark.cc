@@ -0,0 +1,392 @@
+#include "reassembler.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+/*
+ * reassembler_benchmark: drive the Reassembler with adversarial arrival patterns and report the cost per insert.
+ *
+ *   reassembler_benchmark [--format csv|json] [--repeat N] [--bytes N] [--scenario NAME] [--variant NAME] [--quick]
+ *
+ * Each scenario is a sequence of inserts covering a stream of `--bytes` bytes (16 MiB by default; 128 MiB makes
+ * several scenarios a million inserts or more). The reader is drained after every insert, and bytes_pending() is
+ * read after every insert, as the receiver does to send an ACK. Only the Reassembler's public API is used, so the
+ * variants just construct it differently:
+ *
+ *   intervals  pending bytes in slices of the inserted strings, Chunked output
+ *   pooled     pending bytes in pages of the global BufferPool, Pooled output
+ *   in-place   pending bytes staged in the Ring output's free space
+ *
+ * The strings to insert are made before each batch of inserts, outside the timed part. Allocations are counted by
+ * replacing the global operator new.
+ */
+
+static uint64_t allocations = 0;
+
+void* operator new( size_t size )
+{
+  ++allocations;
+  if ( void* const ptr = malloc( size ? size : 1 ) ) {
+    return ptr;
+  }
+  throw bad_alloc();
+}
+
+void operator delete( void* ptr ) noexcept
+{
+  free( ptr );
+}
+
+void operator delete( void* ptr, size_t /* size */ ) noexcept
+{
+  free( ptr );
+}
+
+static constexpr uint64_t kCapacity = 256 * 1024;
+static constexpr size_t kBatch = 4096;
+
+struct Piece
+{
+  uint64_t first_index;
+  uint64_t len;
+  bool is_last;
+};
+
+struct Scenario
+{
+  string name;
+  string description;
+  function<vector<Piece>( uint64_t stream_len, default_random_engine& rd )> make;
+};
+
+struct Variant
+{
+  string name;
+  function<Reassembler()> make;
+};
+
+struct Result
+{
+  string scenario;
+  string variant;
+  uint64_t inserts;
+  uint64_t bytes;
+  size_t repeat;
+  double ns_per_insert_median;
+  double ns_per_insert_min;
+  double gbps_median;
+  uint64_t peak_pending;
+  double allocs_per_insert;
+};
+
+// split [begin, end) into `len`-byte segments
+static vector<Piece> segments( uint64_t begin, uint64_t end, uint64_t len, uint64_t stream_len )
+{
+  vector<Piece> ret;
+  for ( uint64_t i = begin; i < end; i += len ) {
+    const uint64_t size = min( len, end - i );
+    ret.push_back( { i, size, i + size == stream_len } );
+  }
+  return ret;
+}
+
+static vector<Scenario> scenarios()
+{
+  return {
+    { "in-order",
+      "1460-byte segments in order (baseline)",
+      []( uint64_t stream_len, default_random_engine& ) { return segments( 0, stream_len, 1460, stream_len ); } },
+
+    { "reorder",
+      "128-byte segments shuffled within each window, the first one last",
+      []( uint64_t stream_len, default_random_engine& rd ) {
+        vector<Piece> ret;
+        for ( uint64_t window = 0; window < stream_len; window += kCapacity ) {
+          auto pieces = segments( window, min( window + kCapacity, stream_len ), 128, stream_len );
+          shuffle( pieces.begin() + 1, pieces.end(), rd );
+          rotate( pieces.begin(), pieces.begin() + 1, pieces.end() );
+          ret.insert( ret.end(), pieces.begin(), pieces.end() );
+        }
+        return ret;
+      } },
+
+    { "tiny-holes",
+      "256-byte segments missing their first byte, then 1-byte retransmits filling the holes in order",
+      []( uint64_t stream_len, default_random_engine& ) {
+        vector<Piece> ret;
+        for ( uint64_t window = 0; window < stream_len; window += kCapacity ) {
+          const auto pieces = segments( window, min( window + kCapacity, stream_len ), 256, stream_len );
+          for ( const auto& p : pieces ) {
+            if ( p.len > 1 ) {
+              ret.push_back( { p.first_index + 1, p.len - 1, p.is_last } );
+            }
+          }
+          for ( const auto& p : pieces ) {
+            ret.push_back( { p.first_index, 1, p.is_last and p.len == 1 } );
+          }
+        }
+        return ret;
+      } },
+
+    { "duplicates",
+      "512-byte segments sent 8 times each: twice early, twice in order, four times stale",
+      []( uint64_t stream_len, default_random_engine& ) {
+        const auto pieces = segments( 0, stream_len, 512, stream_len );
+        vector<Piece> ret;
+        for ( size_t i = 0; i < pieces.size(); ++i ) {
+          for ( const size_t j : { i + 1, i + 1, i, i, i - 1, i - 1, i + 1, i + 1 } ) {
+            if ( j < pieces.size() ) {
+              ret.push_back( pieces[j] );
+            }
+          }
+        }
+        return ret;
+      } },
+
+    { "far-future",
+      "1460-byte segments in order, each followed by 8 segments beyond the window",
+      []( uint64_t stream_len, default_random_engine& rd ) {
+        uniform_int_distribution<uint64_t> beyond { kCapacity, 64 * kCapacity };
+        vector<Piece> ret;
+        for ( const auto& p : segments( 0, stream_len, 1460, stream_len ) ) {
+          ret.push_back( p );
+          for ( int i = 0; i < 8; ++i ) {
+            const uint64_t first_index = p.first_index + p.len + beyond( rd );
+            if ( first_index + 1460 < stream_len ) {
+              ret.push_back( { first_index, 1460, false } );
+            }
+          }
+        }
+        return ret;
+      } },
+
+    { "random-overlap",
+      "pieces of 1 to 1024 bytes at random offsets within each window, then 1460-byte segments covering it",
+      []( uint64_t stream_len, default_random_engine& rd ) {
+        vector<Piece> ret;
+        for ( uint64_t window = 0; window < stream_len; window += kCapacity ) {
+          const uint64_t end = min( window + kCapacity, stream_len );
+          uniform_int_distribution<uint64_t> offset { window + 1, end - 1 };
+          uniform_int_distribution<uint64_t> len { 1, 1024 };
+          for ( uint64_t i = 0; i < ( end - window ) / 128; ++i ) {
+            const uint64_t first_index = offset( rd );
+            ret.push_back( { first_index, min( len( rd ), end - first_index ), false } );
+          }
+          const auto pieces = segments( window, end, 1460, stream_len );
+          ret.insert( ret.end(), pieces.begin(), pieces.end() );
+        }
+        return ret;
+      } },
+  };
+}
+
+static vector<Variant> variants()
+{
+  return {
+    { "intervals", [] { return Reassembler { ByteStream { kCapacity, ByteStream::Storage::Chunked } }; } },
+    { "pooled",
+      [] {
+        return Reassembler { ByteStream { kCapacity, ByteStream::Storage::Pooled, &BufferPool::global() },
+                             &BufferPool::global() };
+      } },
+    { "in-place",
+      [] {
+        return Reassembler { ByteStream { kCapacity, ByteStream::Storage::Ring }, Reassembler::Mode::InPlace };
+      } },
+  };
+}
+
+struct Run
+{
+  duration<double> elapsed;
+  uint64_t allocations;
+  uint64_t peak_pending;
+};
+
+// Insert every piece of `data`, draining the reader as it goes. With `verify`, also check the bytes read (which
+// is only done in the warm-up run, whose time is not reported).
+static Run run( const Variant& variant, const vector<Piece>& pieces, const string& data, bool verify )
+{
+  Reassembler reassembler = variant.make();
+  Run ret {};
+  vector<string> batch;
+  batch.reserve( kBatch );
+
+  for ( size_t first = 0; first < pieces.size(); first += kBatch ) {
+    const size_t last = min( first + kBatch, pieces.size() );
+    batch.clear();
+    for ( size_t i = first; i < last; ++i ) {
+      batch.emplace_back( data, pieces[i].first_index, pieces[i].len );
+    }
+
+    const uint64_t allocations_before = allocations;
+    const auto start = steady_clock::now();
+    for ( size_t i = first; i < last; ++i ) {
+      reassembler.insert( pieces[i].first_index, move( batch[i - first] ), pieces[i].is_last );
+      ret.peak_pending = max( ret.peak_pending, reassembler.bytes_pending() );
+
+      while ( reassembler.reader().bytes_buffered() ) {
+        const string_view peeked = reassembler.reader().peek();
+        const char* const expected = data.data() + reassembler.reader().bytes_popped();
+        if ( verify and memcmp( peeked.data(), expected, peeked.size() ) ) {
+          throw runtime_error( variant.name + ": mismatch between data inserted and read" );
+        }
+        reassembler.reader().pop( peeked.size() );
+      }
+    }
+    ret.elapsed += steady_clock::now() - start;
+    ret.allocations += allocations - allocations_before;
+  }
+
+  if ( not reassembler.reader().is_finished() or reassembler.reader().bytes_popped() != data.size() ) {
+    throw runtime_error( variant.name + ": the stream did not finish" );
+  }
+  return ret;
+}
+
+static Result measure( const Scenario& scenario,
+                       const Variant& variant,
+                       const vector<Piece>& pieces,
+                       const string& data,
+                       size_t repeat )
+{
+  run( variant, pieces, data, true ); // warm up the allocator and the caches, and check the output
+
+  vector<double> ns_per_insert;
+  vector<double> gbps;
+  Run last {};
+  for ( size_t i = 0; i < repeat; ++i ) {
+    last = run( variant, pieces, data, false );
+    const double elapsed_ns = duration<double, nano>( last.elapsed ).count();
+    ns_per_insert.push_back( elapsed_ns / static_cast<double>( pieces.size() ) );
+    gbps.push_back( 8 * static_cast<double>( data.size() ) / last.elapsed.count() / 1e9 );
+  }
+  sort( ns_per_insert.begin(), ns_per_insert.end() );
+  sort( gbps.begin(), gbps.end() );
+
+  return { scenario.name,
+           variant.name,
+           pieces.size(),
+           data.size(),
+           repeat,
+           ns_per_insert[ns_per_insert.size() / 2],
+           ns_per_insert.front(),
+           gbps[gbps.size() / 2],
+           last.peak_pending,
+           static_cast<double>( last.allocations ) / static_cast<double>( pieces.size() ) };
+}
+
+static void print_csv( const vector<Result>& results )
+{
+  cout << "scenario,variant,inserts,bytes,repeat,ns_per_insert_median,ns_per_insert_min,gbps_median,"
+          "peak_pending_bytes,allocs_per_insert\n";
+  cout << fixed << setprecision( 2 );
+  for ( const auto& r : results ) {
+    cout << r.scenario << "," << r.variant << "," << r.inserts << "," << r.bytes << "," << r.repeat << ","
+         << r.ns_per_insert_median << "," << r.ns_per_insert_min << "," << r.gbps_median << "," << r.peak_pending
+         << "," << r.allocs_per_insert << "\n";
+  }
+}
+
+static void print_json( const vector<Result>& results )
+{
+  cout << "[\n" << fixed << setprecision( 2 );
+  for ( size_t i = 0; i < results.size(); ++i ) {
+    const auto& r = results[i];
+    cout << "  {\"scenario\": \"" << r.scenario << "\", \"variant\": \"" << r.variant
+         << "\", \"inserts\": " << r.inserts << ", \"bytes\": " << r.bytes << ", \"repeat\": " << r.repeat
+         << ", \"ns_per_insert_median\": " << r.ns_per_insert_median
+         << ", \"ns_per_insert_min\": " << r.ns_per_insert_min << ", \"gbps_median\": " << r.gbps_median
+         << ", \"peak_pending_bytes\": " << r.peak_pending << ", \"allocs_per_insert\": " << r.allocs_per_insert
+         << "}" << ( i + 1 < results.size() ? ",\n" : "\n" );
+  }
+  cout << "]\n";
+}
+
+void program_body( const vector<string_view>& args )
+{
+  string format = "csv";
+  size_t repeat = 5;
+  uint64_t stream_len = 16 * 1024 * 1024;
+  string only_scenario;
+  string only_variant;
+  for ( size_t i = 0; i < args.size(); ++i ) {
+    if ( args[i] == "--format" and i + 1 < args.size() ) {
+      format = args[++i];
+    } else if ( args[i] == "--repeat" and i + 1 < args.size() ) {
+      repeat = stoul( string( args[++i] ) );
+    } else if ( args[i] == "--bytes" and i + 1 < args.size() ) {
+      stream_len = stoull( string( args[++i] ) );
+    } else if ( args[i] == "--scenario" and i + 1 < args.size() ) {
+      only_scenario = args[++i];
+    } else if ( args[i] == "--variant" and i + 1 < args.size() ) {
+      only_variant = args[++i];
+    } else if ( args[i] == "--quick" ) {
+      stream_len = 1024 * 1024;
+      repeat = 1;
+    } else {
+      cerr << "usage: reassembler_benchmark [--format csv|json] [--repeat N] [--bytes N] [--scenario NAME] "
+              "[--variant NAME] [--quick]\n\nscenarios:\n";
+      for ( const auto& s : scenarios() ) {
+        cerr << "  " << left << setw( 16 ) << s.name << s.description << "\n";
+      }
+      throw runtime_error( "bad arguments" );
+    }
+  }
+  if ( format != "csv" and format != "json" ) {
+    throw runtime_error( "unknown format: " + format );
+  }
+  if ( repeat == 0 or stream_len == 0 ) {
+    throw runtime_error( "--repeat and --bytes must be positive" );
+  }
+
+  default_random_engine rd { 1370 };
+  string data( stream_len, 0 );
+  generate( data.begin(), data.end(), [&] { return rd(); } );
+
+  vector<Result> results;
+  for ( const auto& scenario : scenarios() ) {
+    if ( not only_scenario.empty() and scenario.name != only_scenario ) {
+      continue;
+    }
+    const vector<Piece> pieces = scenario.make( stream_len, rd );
+    for ( const auto& variant : variants() ) {
+      if ( only_variant.empty() or variant.name == only_variant ) {
+        results.push_back( measure( scenario, variant, pieces, data, repeat ) );
+      }
+    }
+  }
+  if ( results.empty() ) {
+    throw runtime_error( "no such scenario or variant" );
+  }
+
+  if ( format == "json" ) {
+    print_json( results );
+  } else {
+    print_csv( results );
+  }
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    program_body( { argv + 1, argv + argc } );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -129,6 +129,25 @@ int main()
       test.execute( ReadAll( "" ) );
       test.execute( IsFinished { true } );
     }
+
+    {
+      // small pending slices of large strings don't keep those strings alive
+      ReassemblerTestHarness test { "holes 8", 65000 };
+
+      test.execute( InsertSlice { "bcdefghijklmnopqrstu", 1, 16384 } );
+      test.execute( InsertSlice { "ABCDEFGHIJKLMNOPQRSTUVWXYZ", 30, 16384 } );
+      test.execute( BytesPushed( 0 ) );
+      test.execute( BytesPending( 46 ) );
+      test.execute( PendingFootprintAtMost( 1024 ) );
+
+      test.execute( InsertSlice { "a", 0, 16384 } );
+      test.execute( BytesPushed( 21 ) );
+      test.execute( ReadAll( "abcdefghijklmnopqrstu" ) );
+      test.execute( InsertSlice { "vwxyz01234", 21, 16384 } );
+      test.execute( BytesPushed( 56 ) );
+      test.execute( ReadAll( "vwxyz01234BCDEFGHIJKLMNOPQRSTUVWXYZ" ) );
+      test.execute( BytesPending( 0 ) );
+    }
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << endl;
     return EXIT_FAILURE;
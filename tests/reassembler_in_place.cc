@@ -0,0 +1,117 @@
+#include "random.hh"
+#include "reassembler_test_harness.hh"
+#include "test_should_be.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+static void in_place_test( ByteStream::Storage storage )
+{
+  {
+    ReassemblerTestHarness test { "in place holes", 65000, Reassembler::Mode::InPlace, storage };
+
+    test.execute( Insert { "fgh", 5 } );
+    test.execute( Insert { "b", 1 } );
+    test.execute( BytesPending( 4 ) );
+    test.execute( Insert { "bcdefg", 1 } );
+    test.execute( BytesPending( 7 ) );
+    test.execute( BytesPushed( 0 ) );
+    test.execute( Insert { "a", 0 } );
+    test.execute( BytesPending( 0 ) );
+    test.execute( BytesPushed( 8 ) );
+    test.execute( ReadAll( "abcdefgh" ) );
+    test.execute( Insert { "j", 9 }.is_last() );
+    test.execute( Insert { "hi", 7 } );
+    test.execute( ReadAll( "ij" ) );
+    test.execute( IsFinished { true } );
+  }
+
+  {
+    // the window wraps around the end of the stream's buffer
+    ReassemblerTestHarness test { "in place wrap", 8, Reassembler::Mode::InPlace, storage };
+
+    test.execute( Insert { "cdef", 2 } );
+    test.execute( Insert { "ab", 0 } );
+    test.execute( BytesPushed( 6 ) );
+    test.execute( Pop( 5 ) );
+    test.execute( Insert { "jklmnop", 9 } ); // only "jklm" fits before index 13
+    test.execute( BytesPending( 4 ) );
+    test.execute( Insert { "ghi", 6 } );
+    test.execute( BytesPending( 0 ) );
+    test.execute( BytesPushed( 13 ) );
+    test.execute( Peek( "fghijklm" ) );
+    test.execute( Pop( 8 ) );
+    test.execute( Insert { "op", 14 }.is_last() );
+    test.execute( Insert { "n", 13 } );
+    test.execute( ReadAll( "nop" ) );
+    test.execute( IsFinished { true } );
+  }
+
+  {
+    // staged bytes stay put when the reader empties the stream
+    ReassemblerTestHarness test { "in place drained", 16, Reassembler::Mode::InPlace, storage };
+
+    test.execute( Insert { "cd", 2 } );
+    test.execute( Insert { "a", 0 } );
+    test.execute( ReadAll( "a" ) );
+    test.execute( Insert { "b", 1 } );
+    test.execute( ReadAll( "bcd" ) );
+  }
+
+  {
+    // staged bytes survive an attempt to release the stream's buffer
+    Reassembler r { ByteStream { 8, storage }, Reassembler::Mode::InPlace };
+    r.insert( 2, "cd", false );
+    r.reader().release_buffer();
+    r.insert( 0, "ab", false );
+    string out;
+    read( r.reader(), 8, out );
+    test_should_be( out == "abcd", true );
+  }
+
+  auto rd = get_random_engine();
+  for ( unsigned rep_no = 0; rep_no < 8; ++rep_no ) {
+    ReassemblerTestHarness test {
+      "in place random " + to_string( rep_no ), 4096, Reassembler::Mode::InPlace, storage };
+
+    // overlapping segments, shuffled within each window and read out after each one
+    string d( 64 * 1024, 0 );
+    generate( d.begin(), d.end(), [&] { return rd(); } );
+    for ( size_t window = 0; window < d.size(); window += 4096 ) {
+      vector<tuple<size_t, size_t>> seq_size;
+      for ( size_t offset = window; offset < window + 4096; ) {
+        const size_t size = min( window + 4096 - offset, 1 + static_cast<size_t>( rd() % 700 ) );
+        const size_t offs = min( offset - window, static_cast<size_t>( rd() % 100 ) );
+        seq_size.emplace_back( offset - offs, size + offs );
+        offset += size;
+      }
+      shuffle( seq_size.begin(), seq_size.end(), rd );
+      for ( auto [off, sz] : seq_size ) {
+        test.execute( Insert { d.substr( off, sz ), off }.is_last( off + sz == d.size() ) );
+      }
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( d.substr( window, 4096 ) ) );
+    }
+    test.execute( IsFinished { true } );
+  }
+}
+
+int main()
+{
+  try {
+    in_place_test( ByteStream::Storage::Ring );
+    in_place_test( ByteStream::Storage::Mapped );
+    in_place_test( ByteStream::Storage::Chunked ); // falls back to intervals
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -9,6 +9,7 @@
 #include <queue>
 #include <random>
 #include <tuple>
+#include <vector>
 
 using namespace std;
 using namespace std::chrono;
@@ -82,9 +83,98 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
   }
 }
 
+// Deliver each window's worth of small segments shuffled, always with the first one last, so that the whole
+// window is pending before any of it can be written. bytes_pending() is read after every insert, as an ACK would.
+void reordered_speed_test( const size_t num_windows, // NOLINT(bugprone-easily-swappable-parameters)
+                           const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
+                           const size_t segment_len, // NOLINT(bugprone-easily-swappable-parameters)
+                           const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                           const Reassembler::Mode mode )
+{
+  default_random_engine rd { random_seed };
+  const string data = [&] {
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < num_windows * capacity; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  queue<tuple<uint64_t, string, bool>> split_data;
+  for ( size_t window = 0; window < data.size(); window += capacity ) {
+    vector<uint64_t> starts;
+    for ( size_t i = window + segment_len; i < window + capacity; i += segment_len ) {
+      starts.push_back( i );
+    }
+    shuffle( starts.begin(), starts.end(), rd );
+    starts.push_back( window );
+    for ( const uint64_t i : starts ) {
+      split_data.emplace( i, data.substr( i, segment_len ), i + segment_len >= data.size() );
+    }
+  }
+  const size_t num_segments = split_data.size();
+
+  Reassembler reassembler { ByteStream { capacity }, mode };
+
+  string output_data;
+  output_data.reserve( data.size() );
+  uint64_t max_pending = 0;
+
+  const auto start_time = steady_clock::now();
+  while ( not split_data.empty() ) {
+    auto& next = split_data.front();
+    reassembler.insert( get<uint64_t>( next ), move( get<string>( next ) ), get<bool>( next ) );
+    split_data.pop();
+    max_pending = max( max_pending, reassembler.bytes_pending() );
+
+    while ( reassembler.reader().bytes_buffered() ) {
+      output_data += reassembler.reader().peek();
+      reassembler.reader().pop( output_data.size() - reassembler.reader().bytes_popped() );
+    }
+  }
+
+  const auto stop_time = steady_clock::now();
+
+  if ( not reassembler.reader().is_finished() ) {
+    throw runtime_error( "Reassembler did not close ByteStream when finished" );
+  }
+
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+
+  if ( max_pending != capacity - segment_len ) {
+    throw runtime_error( "Reassembler held " + to_string( max_pending ) + " bytes pending, expected "
+                         + to_string( capacity - segment_len ) );
+  }
+
+  auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  auto segments_per_second = static_cast<double>( num_segments ) / test_duration.count();
+  auto gigabits_per_second = 8 * static_cast<double>( data.size() ) / test_duration.count() / 1e9;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  const string mode_name = mode == Reassembler::Mode::InPlace ? " in place" : "";
+  cout << "Reassembler" << mode_name << " with capacity=" << capacity << " and " << segment_len
+       << "-byte segments shuffled reached " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s ("
+       << segments_per_second / 1e6 << " M segments/s).\n";
+
+  debug_output << ( mode == Reassembler::Mode::InPlace ? "     In-place reordered throughput: "
+                                                      : "   Reassembler reordered throughput: " )
+               << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s\n";
+
+  if ( gigabits_per_second < 0.1 ) {
+    throw runtime_error( "Reassembler did not meet minimum speed of 0.1 Gbit/s with reordered segments." );
+  }
+}
+
 void program_body()
 {
   speed_test( 10000, 1500, 1370 );
+  reordered_speed_test( 200, 65536, 64, 1370, Reassembler::Mode::Intervals );
+  reordered_speed_test( 200, 65536, 64, 1370, Reassembler::Mode::InPlace );
 }
 
 int main()
@@ -27,10 +27,22 @@ struct ReassemblerTestStep : public TestStep<Reassembler>
 class ReassemblerTestHarness : public TestHarness<Reassembler>
 {
 public:
-  ReassemblerTestHarness( std::string test_name, uint64_t capacity )
+  ReassemblerTestHarness( std::string test_name, uint64_t capacity, BufferPool* pool = nullptr )
     : TestHarness( move( test_name ),
-                   "capacity=" + std::to_string( capacity ),
-                   { Reassembler { ByteStream { capacity } } } )
+                   "capacity=" + std::to_string( capacity )
+                     + ( pool ? ", pool of " + std::to_string( pool->page_size() ) + "-byte pages" : "" ),
+                   { Reassembler { ByteStream { capacity }, pool } } )
+  {}
+
+  ReassemblerTestHarness( std::string test_name,
+                          uint64_t capacity,
+                          Reassembler::Mode mode,
+                          ByteStream::Storage storage = ByteStream::Storage::Ring )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity )
+                     + ByteStreamTestHarness::storage_description( storage, nullptr )
+                     + ( mode == Reassembler::Mode::InPlace ? ", in place" : "" ),
+                   { Reassembler { ByteStream { capacity, storage }, mode } } )
   {}
 
   template<std::derived_from<TestStep<ByteStream>> T>
@@ -49,6 +61,24 @@ struct BytesPending : public ConstExpectNumber<Reassembler, uint64_t>
   uint64_t value( const Reassembler& r ) const override { return r.bytes_pending(); }
 };
 
+struct PendingFootprintAtMost : public Expectation<Reassembler>
+{
+  uint64_t limit_;
+
+  explicit PendingFootprintAtMost( uint64_t limit ) : limit_( limit ) {}
+
+  std::string description() const override { return "pending_footprint <= " + std::to_string( limit_ ); }
+
+  void execute( Reassembler& r ) const override
+  {
+    if ( r.pending_footprint() > limit_ ) {
+      throw ExpectationViolation { "The Reassembler keeps " + std::to_string( r.pending_footprint() )
+                                   + " bytes alive for its pending bytes, more than "
+                                   + std::to_string( limit_ ) };
+    }
+  }
+};
+
 struct Insert : public Action<Reassembler>
 {
   std::string data_;
@@ -75,3 +105,25 @@ struct Insert : public Action<Reassembler>
 
   void execute( Reassembler& r ) const override { r.insert( first_index_, data_, is_last_substring_ ); }
 };
+
+// Insert `data` as a slice of a much larger string, as a payload parsed out of a large read buffer would be
+struct InsertSlice : public Insert
+{
+  uint64_t backing_size_;
+
+  InsertSlice( std::string data, uint64_t first_index, uint64_t backing_size )
+    : Insert( std::move( data ), first_index ), backing_size_( backing_size )
+  {}
+
+  std::string description() const override
+  {
+    return Insert::description() + " (a slice of " + std::to_string( backing_size_ ) + " bytes)";
+  }
+
+  void execute( Reassembler& r ) const override
+  {
+    std::string backing = data_;
+    backing.resize( std::max<uint64_t>( backing_size_, data_.size() ) );
+    r.insert( first_index_, Buffer( std::move( backing ) ).substr( 0, data_.size() ), is_last_substring_ );
+  }
+};
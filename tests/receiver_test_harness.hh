@@ -8,6 +8,7 @@
 #include <optional>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 template<std::derived_from<TestStep<Reassembler>> T>
 struct DirectReassemblerTest : public TestStep<TCPReceiver>
@@ -46,6 +47,27 @@ public:
                    { TCPReceiver { Reassembler { ByteStream { capacity } } } } )
   {}
 
+  // with a receiver that sends SACK blocks if the sender permits them (and echoes timestamps if both have them)
+  TCPReceiverTestHarness( std::string test_name,
+                          uint64_t capacity,
+                          Reassembler::Mode mode,
+                          bool sack,
+                          bool timestamps = false )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity ) + ", sack=" + std::to_string( sack )
+                     + ", timestamps=" + std::to_string( timestamps ),
+                   { TCPReceiver {
+                     Reassembler { ByteStream { capacity }, mode }, sack, std::nullopt, timestamps } } )
+  {}
+
+  // with a receiver that offers this window scale, and scales its windows if the sender offers one too
+  TCPReceiverTestHarness( std::string test_name, uint64_t capacity, std::optional<uint8_t> window_shift )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity ) + ", window_shift="
+                     + ( window_shift.has_value() ? std::to_string( window_shift.value() ) : "none" ),
+                   { TCPReceiver { Reassembler { ByteStream { capacity } }, false, window_shift } } )
+  {}
+
   template<std::derived_from<TestStep<Reassembler>> T>
   void execute( const T& test )
   {
@@ -75,6 +97,13 @@ struct ExpectAckno : public ExpectNumber<TCPReceiver, std::optional<Wrap32>>
   std::optional<Wrap32> value( TCPReceiver& rs ) const override { return rs.send().ackno; }
 };
 
+struct ExpectTimestampEcho : public ExpectNumber<TCPReceiver, std::optional<uint32_t>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "timestamp_echo"; }
+  std::optional<uint32_t> value( TCPReceiver& rs ) const override { return rs.send().timestamp_echo; }
+};
+
 struct ExpectReset : public ExpectBool<TCPReceiver>
 {
   using ExpectBool::ExpectBool;
@@ -111,6 +140,35 @@ struct ExpectAcknoBetween : public Expectation<TCPReceiver>
   }
 };
 
+struct ExpectSACK : public Expectation<TCPReceiver>
+{
+  std::vector<std::pair<Wrap32, Wrap32>> blocks_;
+
+  explicit ExpectSACK( std::vector<std::pair<Wrap32, Wrap32>> blocks ) : blocks_( std::move( blocks ) ) {}
+
+  static std::string to_string( const std::vector<std::pair<Wrap32, Wrap32>>& blocks )
+  {
+    std::ostringstream ss;
+    ss << "{";
+    for ( const auto& [begin, end] : blocks ) {
+      ss << " [" << begin << ", " << end << ")";
+    }
+    ss << " }";
+    return ss.str();
+  }
+
+  std::string description() const override { return "SACK blocks are " + to_string( blocks_ ); }
+
+  void execute( TCPReceiver& rs ) const override
+  {
+    const auto blocks = rs.send().sack;
+    if ( blocks != blocks_ ) {
+      throw ExpectationViolation( "SACK blocks were " + to_string( blocks ) + ", but expected "
+                                  + to_string( blocks_ ) );
+    }
+  }
+};
+
 struct HasAckno : public ExpectBool<TCPReceiver>
 {
   using ExpectBool::ExpectBool;
@@ -118,6 +176,18 @@ struct HasAckno : public ExpectBool<TCPReceiver>
   bool value( TCPReceiver& rs ) const override { return rs.send().ackno.has_value(); }
 };
 
+struct SynSent : public Action<TCPReceiver>
+{
+  std::string description() const override { return "our own SYN is sent"; }
+  void execute( TCPReceiver& rs ) const override { rs.syn_sent(); }
+};
+
+struct AckSent : public Action<TCPReceiver>
+{
+  std::string description() const override { return "our ack is sent"; }
+  void execute( TCPReceiver& rs ) const override { rs.ack_sent( rs.send() ); }
+};
+
 struct SegmentArrives : public Action<TCPReceiver>
 {
   TCPSenderMessage msg_ {};
@@ -135,6 +205,24 @@ struct SegmentArrives : public Action<TCPReceiver>
     return *this;
   }
 
+  SegmentArrives& with_sack_permitted()
+  {
+    msg_.SACK_permitted = true;
+    return *this;
+  }
+
+  SegmentArrives& with_window_scale( uint8_t shift )
+  {
+    msg_.window_scale = shift;
+    return *this;
+  }
+
+  SegmentArrives& with_timestamp( uint32_t timestamp )
+  {
+    msg_.timestamp = timestamp;
+    return *this;
+  }
+
   SegmentArrives& with_rst()
   {
     msg_.RST = true;
@@ -181,6 +269,9 @@ struct SegmentArrives : public Action<TCPReceiver>
     if ( msg_.FIN ) {
       ss << " +FIN";
     }
+    if ( msg_.timestamp.has_value() ) {
+      ss << " timestamp=" << msg_.timestamp.value();
+    }
     ss << ")";
 
     if ( ackno_expected_.value_ ) {
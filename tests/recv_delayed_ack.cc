@@ -0,0 +1,145 @@
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+// a peer and the messages it has sent
+struct Endpoint
+{
+  TCPPeer peer;
+  queue<TCPMessage> sent {};
+  TCPPeer::TransmitFunction transmit = [this]( TCPMessage msg ) { sent.push( move( msg ) ); };
+
+  explicit Endpoint( const TCPConfig& cfg ) : peer( cfg ) {}
+
+  TCPMessage take()
+  {
+    if ( sent.empty() ) {
+      throw runtime_error( "expected a message, but there was none" );
+    }
+    TCPMessage msg = move( sent.front() );
+    sent.pop();
+    return msg;
+  }
+};
+
+// open the connection from `a` to `b`
+static void connect( Endpoint& a, Endpoint& b )
+{
+  a.peer.push( a.transmit );
+  b.peer.receive( a.take(), b.transmit ); // SYN
+  a.peer.receive( b.take(), a.transmit ); // SYN/ACK: the ack of a SYN is never delayed
+  b.peer.receive( a.take(), b.transmit );
+  test_should_be( a.sent.size() + b.sent.size(), size_t { 0 } );
+}
+
+int main()
+{
+  try {
+    TCPConfig cfg;
+
+    {
+      // every second full segment is acknowledged at once (with a link that fits 1000 bytes and the timestamps)
+      TCPConfig small = cfg;
+      small.mtu = TCPConfig::MAX_PAYLOAD_SIZE + TCPConfig::HEADERS_SIZE + 12;
+      Endpoint a { small };
+      Endpoint b { small };
+      connect( a, b );
+      a.peer.outbound_writer().push( string( 4000, 'x' ) );
+      a.peer.push( a.transmit );
+      test_should_be( a.sent.size(), size_t { 4 } );
+      for ( unsigned i = 0; i < 4; ++i ) {
+        b.peer.receive( a.take(), b.transmit );
+        test_should_be( b.sent.size(), size_t { i % 2 } );
+        if ( i % 2 ) {
+          const auto ack = b.take();
+          test_should_be( ack.sender.sequence_length(), uint64_t { 0 } );
+          const bool acks_both = ack.receiver.ackno == cfg.isn + 1 + 1000 * ( i + 1 );
+          test_should_be( acks_both, true );
+        }
+      }
+    }
+
+    {
+      // a lone segment waits for the delayed-ack timeout
+      Endpoint a { cfg };
+      Endpoint b { cfg };
+      connect( a, b );
+      a.peer.outbound_writer().push( "hello" );
+      a.peer.push( a.transmit );
+      b.peer.receive( a.take(), b.transmit );
+      b.peer.tick( cfg.ack_delay - 1, b.transmit );
+      test_should_be( b.sent.size(), size_t { 0 } );
+      b.peer.tick( 1, b.transmit );
+      test_should_be( b.sent.size(), size_t { 1 } );
+      const bool acks_hello = b.take().receiver.ackno == cfg.isn + 6;
+      test_should_be( acks_hello, true );
+    }
+
+    {
+      // out-of-order data, the segment that fills the hole, and the FIN are all acknowledged at once
+      Endpoint a { cfg };
+      Endpoint b { cfg };
+      connect( a, b );
+      a.peer.outbound_writer().push( string( 2000, 'x' ) );
+      a.peer.outbound_writer().close();
+      a.peer.push( a.transmit );
+      const TCPMessage first = a.take();
+      b.peer.receive( a.take(), b.transmit );
+      test_should_be( b.sent.size(), size_t { 1 } );
+      const bool duplicate = b.take().receiver.ackno == cfg.isn + 1;
+      test_should_be( duplicate, true );
+      b.peer.receive( first, b.transmit );
+      test_should_be( b.sent.size(), size_t { 1 } );
+      const bool fills_hole = b.take().receiver.ackno == cfg.isn + 2002;
+      test_should_be( fills_hole, true );
+    }
+
+    {
+      // the ack rides on data going the other way
+      Endpoint a { cfg };
+      Endpoint b { cfg };
+      connect( a, b );
+      a.peer.outbound_writer().push( "ping" );
+      a.peer.push( a.transmit );
+      b.peer.outbound_writer().push( "pong" );
+      b.peer.receive( a.take(), b.transmit );
+      test_should_be( b.sent.size(), size_t { 1 } );
+      const TCPMessage reply = b.take();
+      test_should_be( reply.sender.payload.size(), size_t { 4 } );
+      const bool acks_ping = reply.receiver.ackno == cfg.isn + 5;
+      test_should_be( acks_ping, true );
+      b.peer.tick( cfg.ack_delay, b.transmit );
+      test_should_be( b.sent.size(), size_t { 0 } );
+    }
+
+    {
+      // without a delay, every segment is acknowledged at once
+      TCPConfig immediate = cfg;
+      immediate.ack_delay = 0;
+      Endpoint a { immediate };
+      Endpoint b { immediate };
+      connect( a, b );
+      a.peer.outbound_writer().push( string( 4000, 'x' ) );
+      a.peer.push( a.transmit );
+      for ( unsigned i = 0; i < 4; ++i ) {
+        b.peer.receive( a.take(), b.transmit );
+      }
+      test_should_be( b.sent.size(), size_t { 4 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+#include "test_should_be.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static void sack_test( Reassembler::Mode mode )
+{
+  auto rd = get_random_engine();
+
+  {
+    const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+    TCPReceiverTestHarness test { "SACK blocks", 4000, mode, true };
+    test.execute( SegmentArrives {}.with_syn().with_sack_permitted().with_seqno( isn ) );
+    test.execute( ExpectSACK { {} } );
+    test.execute( SegmentArrives {}.with_seqno( isn + 3 ).with_data( "cd" ) );
+    test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+    test.execute( ExpectSACK { { { Wrap32 { isn + 3 }, Wrap32 { isn + 5 } } } } );
+
+    // the block with the segment that just arrived comes first
+    test.execute( SegmentArrives {}.with_seqno( isn + 7 ).with_data( "gh" ) );
+    test.execute( ExpectSACK { { { Wrap32 { isn + 7 }, Wrap32 { isn + 9 } },
+                                 { Wrap32 { isn + 3 }, Wrap32 { isn + 5 } } } } );
+    test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "ef" ) );
+    test.execute( ExpectSACK { { { Wrap32 { isn + 3 }, Wrap32 { isn + 9 } } } } );
+    test.execute( SegmentArrives {}.with_seqno( isn + 10 ).with_data( "j" ) );
+    test.execute( ExpectSACK { { { Wrap32 { isn + 10 }, Wrap32 { isn + 11 } },
+                                 { Wrap32 { isn + 3 }, Wrap32 { isn + 9 } } } } );
+
+    // an old segment: the blocks are in order
+    test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "d" ) );
+    test.execute( ExpectSACK { { { Wrap32 { isn + 3 }, Wrap32 { isn + 9 } },
+                                 { Wrap32 { isn + 10 }, Wrap32 { isn + 11 } } } } );
+
+    test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "ab" ) );
+    test.execute( ExpectAckno { Wrap32 { isn + 9 } } );
+    test.execute( ExpectSACK { { { Wrap32 { isn + 10 }, Wrap32 { isn + 11 } } } } );
+    test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "i" ) );
+    test.execute( ExpectAckno { Wrap32 { isn + 11 } } );
+    test.execute( ExpectSACK { {} } );
+  }
+
+  {
+    const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+    TCPReceiverTestHarness test { "At most four SACK blocks", 4000, mode, true };
+    test.execute( SegmentArrives {}.with_syn().with_sack_permitted().with_seqno( isn ) );
+    for ( uint32_t i = 1; i <= 6; ++i ) {
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 + 10 * i ).with_data( "x" ) );
+    }
+    test.execute( SegmentArrives {}.with_seqno( isn + 31 ).with_data( "x" ) );
+    test.execute( ExpectSACK { { { Wrap32 { isn + 31 }, Wrap32 { isn + 32 } },
+                                 { Wrap32 { isn + 11 }, Wrap32 { isn + 12 } },
+                                 { Wrap32 { isn + 21 }, Wrap32 { isn + 22 } },
+                                 { Wrap32 { isn + 41 }, Wrap32 { isn + 42 } } } } );
+  }
+
+  {
+    const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+    TCPReceiverTestHarness test { "No SACK unless the sender permits it", 4000, mode, true };
+    test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+    test.execute( SegmentArrives {}.with_seqno( isn + 3 ).with_data( "cd" ) );
+    test.execute( ExpectSACK { {} } );
+  }
+
+  {
+    const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+    TCPReceiverTestHarness test { "No SACK unless the receiver offers it", 4000, mode, false };
+    test.execute( SegmentArrives {}.with_syn().with_sack_permitted().with_seqno( isn ) );
+    test.execute( SegmentArrives {}.with_seqno( isn + 3 ).with_data( "cd" ) );
+    test.execute( ExpectSACK { {} } );
+  }
+
+  // the ranges the Reassembler reports are the ones it holds, across the end of the stream's buffer too
+  for ( unsigned rep = 0; rep < 64; ++rep ) {
+    Reassembler r { ByteStream { 1000 }, mode };
+    set<uint64_t> held;
+    for ( unsigned i = 0; i < 200; ++i ) {
+      const uint64_t next = r.writer().bytes_pushed();
+      const uint64_t limit = r.reader().bytes_popped() + 1000;
+      const uint64_t first = next + rd() % 900;
+      const uint64_t size = 1 + rd() % 50;
+      r.insert( first, string( size, 'x' ), false );
+      for ( uint64_t index = first; index < min( first + size, limit ); ++index ) {
+        held.insert( index );
+      }
+      held.erase( held.begin(), held.lower_bound( r.writer().bytes_pushed() ) );
+      string out;
+      read( r.reader(), rd() % 200, out );
+
+      vector<pair<uint64_t, uint64_t>> expected;
+      for ( const uint64_t index : held ) {
+        if ( not expected.empty() and expected.back().second == index ) {
+          expected.back().second++;
+        } else {
+          expected.emplace_back( index, index + 1 );
+        }
+      }
+      test_should_be( r.pending_ranges() == expected, true );
+    }
+  }
+}
+
+int main()
+{
+  try {
+    sack_test( Reassembler::Mode::Intervals );
+    sack_test( Reassembler::Mode::InPlace );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    constexpr auto mode = Reassembler::Mode::Intervals;
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "Timestamps echoed", 4000, mode, false, true };
+      test.execute( SegmentArrives {}.with_syn().with_timestamp( 100 ).with_seqno( isn ) );
+      test.execute( ExpectTimestampEcho { 100 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ).with_timestamp( 200 ) );
+      test.execute( ExpectTimestampEcho { 200 } );
+
+      // out of order: not the segment that the ack acknowledges, so not the one to time
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "e" ).with_timestamp( 300 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 4 } } );
+      test.execute( ExpectTimestampEcho { 200 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "d" ).with_timestamp( 400 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 6 } } );
+      test.execute( ExpectTimestampEcho { 400 } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "PAWS drops old duplicates", 4000, mode, false, true };
+      test.execute( SegmentArrives {}.with_syn().with_timestamp( UINT32_MAX - 10 ).with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ).with_timestamp( 5 ) ); // wrapped
+      test.execute( ExpectAckno { Wrap32 { isn + 4 } } );
+      test.execute( ExpectTimestampEcho { 5 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "def" ).with_timestamp( UINT32_MAX ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 4 } } );
+      test.execute( ExpectTimestampEcho { 5 } );
+      test.execute( BytesPending { 0 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "def" ).with_timestamp( 5 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 7 } } );
+      test.execute( ReadAll { "abcdef" } );
+    }
+
+    {
+      // with the ack delayed, the echo is of the first segment it covers, so the sender times the delay too
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "Timestamps echoed with a delayed ack", 4000, mode, false, true };
+      test.execute( SegmentArrives {}.with_syn().with_timestamp( 100 ).with_seqno( isn ) );
+      test.execute( AckSent {} );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ).with_timestamp( 200 ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "def" ).with_timestamp( 300 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 7 } } );
+      test.execute( ExpectTimestampEcho { 200 } );
+      test.execute( AckSent {} );
+      test.execute( SegmentArrives {}.with_seqno( isn + 7 ).with_data( "ghi" ).with_timestamp( 400 ) );
+      test.execute( ExpectTimestampEcho { 400 } );
+    }
+
+    {
+      // RFC 7323: an RST is taken whatever its timestamp
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "PAWS lets an RST through", 4000, mode, false, true };
+      test.execute( SegmentArrives {}.with_syn().with_timestamp( 100 ).with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ).with_timestamp( 200 ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_rst().with_timestamp( 50 ) );
+      test.execute( HasError { true } );
+      test.execute( ExpectReset { true } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "No timestamp from the sender", 4000, mode, false, true };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectTimestampEcho { nullopt } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ).with_timestamp( 200 ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "def" ).with_timestamp( 100 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 7 } } );
+      test.execute( ExpectTimestampEcho { nullopt } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "Timestamps off", 4000, mode, false, false };
+      test.execute( SegmentArrives {}.with_syn().with_timestamp( 100 ).with_seqno( isn ) );
+      test.execute( ExpectTimestampEcho { nullopt } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ).with_timestamp( 50 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 4 } } );
+    }
+
+    {
+      // the timestamps option leaves room for three SACK blocks only
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "Three SACK blocks with timestamps", 4000, mode, true, true };
+      test.execute( SegmentArrives {}.with_syn().with_sack_permitted().with_timestamp( 100 ).with_seqno( isn ) );
+      for ( uint32_t i = 0; i < 4; ++i ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 3 + 2 * i ).with_data( "x" ).with_timestamp( 100 + i ) );
+      }
+      test.execute( ExpectSACK { { { Wrap32 { isn + 9 }, Wrap32 { isn + 10 } },
+                                   { Wrap32 { isn + 3 }, Wrap32 { isn + 4 } },
+                                   { Wrap32 { isn + 5 }, Wrap32 { isn + 6 } } } } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "Scaled window", 1000000, 4 };
+      test.execute( SegmentArrives {}.with_syn().with_window_scale( 7 ).with_seqno( isn ) );
+      test.execute( ExpectWindow { UINT16_MAX } ); // on our SYN/ACK: never scaled
+      test.execute( SynSent {} );
+      test.execute( ExpectWindow { 62500 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( string( 1000, 'x' ) ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1001 } } );
+      test.execute( ExpectWindow { 62437 } ); // rounded down: never more than there is room for
+      test.execute( ReadAll { string( 1000, 'x' ) } );
+      test.execute( ExpectWindow { 62500 } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "No window scale from the sender", 1000000, 4 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SynSent {} );
+      test.execute( ExpectWindow { UINT16_MAX } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "No window scale offered", 1000000, nullopt };
+      test.execute( SegmentArrives {}.with_syn().with_window_scale( 7 ).with_seqno( isn ) );
+      test.execute( SynSent {} );
+      test.execute( ExpectWindow { UINT16_MAX } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "Window scale 0", 4000, 0 };
+      test.execute( SegmentArrives {}.with_syn().with_window_scale( 7 ).with_seqno( isn ) );
+      test.execute( SynSent {} );
+      test.execute( ExpectWindow { 4000 } );
+    }
+
+    {
+      // a passive opener's SYN/ACK (and a retransmission of it) has an unscaled window, the segments after it don't
+      TCPConfig cfg;
+      cfg.recv_capacity = 1000000;
+      cfg.timestamps = false;
+      TCPPeer a { cfg };
+      TCPPeer b { cfg };
+      queue<TCPMessage> to_a;
+      queue<TCPMessage> to_b;
+      const TCPPeer::TransmitFunction a_transmit = [&]( TCPMessage msg ) { to_b.push( move( msg ) ); };
+      const TCPPeer::TransmitFunction b_transmit = [&]( TCPMessage msg ) { to_a.push( move( msg ) ); };
+      const uint16_t scaled = cfg.recv_capacity >> cfg.window_shift().value();
+
+      a.push( a_transmit );
+      test_should_be( to_b.front().receiver.window_size, uint16_t { UINT16_MAX } ); // a's SYN
+      b.receive( move( to_b.front() ), b_transmit );
+      to_b.pop();
+      test_should_be( to_a.size(), size_t { 1 } );
+      test_should_be( to_a.front().sender.SYN, true );
+      test_should_be( to_a.front().receiver.window_size, uint16_t { UINT16_MAX } );
+      to_a.pop();
+
+      b.tick( cfg.rt_timeout, b_transmit );
+      test_should_be( to_a.size(), size_t { 1 } );
+      test_should_be( to_a.front().sender.SYN, true );
+      test_should_be( to_a.front().receiver.window_size, uint16_t { UINT16_MAX } );
+      a.receive( move( to_a.front() ), a_transmit );
+      to_a.pop();
+      test_should_be( to_b.front().receiver.window_size, scaled ); // a's ack of the SYN/ACK
+      b.receive( move( to_b.front() ), b_transmit );
+      to_b.pop();
+
+      b.outbound_writer().push( "hello" );
+      b.push( b_transmit );
+      test_should_be( to_a.front().receiver.window_size, scaled );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
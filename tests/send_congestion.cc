@@ -0,0 +1,164 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+using Algorithm = CongestionControl::Algorithm;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "NewReno slow start, timeout, congestion avoidance", cfg, Algorithm::NewReno };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 4000 } );
+      test.execute( ExpectSsthresh { CongestionControl::kUnlimited } );
+
+      // the initial window holds back most of what the receiver would take
+      test.execute( Push { string( 10000, 'x' ) } );
+      for ( unsigned i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + 1000 * i ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 4000 } );
+
+      // slow start: one more segment per segment acknowledged
+      test.execute( AckReceived { Wrap32 { isn + 1001 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 5000 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 4001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 5001 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 5000 } );
+
+      // a timeout halves ssthresh and starts over from one segment
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1001 ) );
+      test.execute( ExpectCongestionWindow { 1000 } );
+      test.execute( ExpectSsthresh { 2500 } );
+
+      test.execute( AckReceived { Wrap32 { isn + 6001 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 2000 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 6001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 7001 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // past ssthresh, the window grows by one segment per window acknowledged
+      test.execute( AckReceived { Wrap32 { isn + 8001 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 3000 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 8001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 9001 ) );
+      test.execute( AckReceived { Wrap32 { isn + 10001 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 3000 } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "CUBIC backs off by 30%", cfg, Algorithm::Cubic };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 10000, 'x' ) } );
+      for ( unsigned i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectCongestionWindow { 1000 } );
+      test.execute( ExpectSsthresh { 2800 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "no congestion control", cfg, Algorithm::None };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 10000, 'x' ) } );
+      for ( unsigned i = 0; i < 10; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      }
+      test.execute( ExpectSeqnosInFlight { 10000 } );
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectCongestionWindow { CongestionControl::kUnlimited } );
+    }
+
+    {
+      // NewReno after a fast retransmit: half of what was in flight
+      CongestionControl cc { Algorithm::NewReno, 1000 };
+      cc.on_loss( 8000 );
+      test_should_be( cc.cwnd(), uint64_t { 4000 } );
+      test_should_be( cc.ssthresh(), uint64_t { 4000 } );
+      cc.on_loss( 3000 );
+      test_should_be( cc.cwnd(), uint64_t { 2000 } );
+    }
+
+    {
+      // a partial ack after the MSS grew past the window in fast recovery
+      CongestionControl cc { Algorithm::NewReno, 536 };
+      cc.on_loss( 1000 );
+      test_should_be( cc.cwnd(), uint64_t { 1072 } );
+      cc.set_mss( 1460 );
+      test_should_be( cc.cwnd(), uint64_t { 1460 } );
+      cc.on_partial_ack( 1200 );
+      test_should_be( cc.cwnd(), uint64_t { 1460 } );
+      cc.on_partial_ack( 1460 );
+      test_should_be( cc.cwnd(), uint64_t { 2920 } );
+    }
+
+    {
+      // CUBIC grows slowly near the window it last lost at, then probes quickly past it
+      CongestionControl cc { Algorithm::Cubic, 1000 };
+      for ( unsigned i = 0; i < 96; ++i ) {
+        cc.on_ack( 1000 );
+      }
+      test_should_be( cc.cwnd(), uint64_t { 100000 } );
+      cc.on_loss( 100000 );
+      test_should_be( cc.cwnd(), uint64_t { 70000 } );
+      test_should_be( cc.in_slow_start(), false );
+
+      // one window acknowledged per 100 ms round trip; the plateau is about 4.2 s after the loss
+      uint64_t plateau_start = 0;
+      uint64_t plateau_end = 0;
+      for ( unsigned ms = 0; ms < 12000; ms += 100 ) {
+        if ( ms == 3000 ) {
+          plateau_start = cc.cwnd();
+        } else if ( ms == 5400 ) {
+          plateau_end = cc.cwnd();
+        }
+        cc.on_ack( cc.cwnd() );
+        cc.tick( 100 );
+      }
+      test_should_be( plateau_start >= 95000 and plateau_end <= 105000, true );
+      test_should_be( cc.cwnd() > 200000, true );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
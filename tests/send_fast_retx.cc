@@ -0,0 +1,113 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rack_tlp = false;
+
+      TCPSenderTestHarness test { "Fast retransmit and NewReno recovery", cfg, FromConfig {} };
+      start_transfer( test, cfg, { .stream_size = 10000, .ack_first_segment = true } );
+
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1001 ) );
+      test.execute( ExpectSsthresh { 2500 } );
+      test.execute( ExpectCongestionWindow { 5500 } ); // ssthresh + the three segments that left the network
+
+      // the inflated window keeps the pipe full
+      test.execute( ExpectMessage {}.with_payload_size( 500 ).with_seqno( isn + 6001 ) );
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 6500 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 6501 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectConsecutiveRetransmissions { 0 } );
+
+      // a partial ack: the next segment was lost as well
+      test.execute( AckReceived { isn + 3001 }.with_win( 60000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 3001 ) );
+      test.execute( ExpectCongestionWindow { 5500 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 7501 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // everything sent before recovery is acknowledged: deflate to ssthresh
+      test.execute( AckReceived { isn + 7501 }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 2500 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 8501 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 500 ).with_seqno( isn + 9501 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rack_tlp = false;
+
+      TCPSenderTestHarness test { "A changed window is no duplicate", cfg, FromConfig {} };
+      start_transfer( test, cfg, { .stream_size = 10000, .ack_first_segment = true } );
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( AckReceived { isn + 1001 }.with_win( 59000 ) );
+      test.execute( AckReceived { isn + 1001 }.with_win( 59000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 1001 }.with_win( 59000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1001 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rack_tlp = false;
+      cfg.rt_timeout_min = cfg.rt_timeout_max = cfg.rt_timeout;
+
+      TCPSenderTestHarness test { "No fast retransmit of what the timeout resent", cfg, FromConfig {} };
+      start_transfer( test, cfg, { .stream_size = 10000, .ack_first_segment = true } );
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1001 ) );
+      test.execute( ExpectCongestionWindow { 1000 } );
+      for ( unsigned i = 0; i < 4; ++i ) {
+        test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCongestionWindow { 1000 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rack_tlp = false;
+      cfg.fast_retransmit = false;
+
+      TCPSenderTestHarness test { "Fast retransmit disabled", cfg, FromConfig {} };
+      start_transfer( test, cfg, { .stream_size = 10000, .ack_first_segment = true } );
+      for ( unsigned i = 0; i < 4; ++i ) {
+        test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCongestionWindow { 5000 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,201 @@
+#include "parser.hh"
+#include "random.hh"
+#include "sender_test_harness.hh"
+#include "tcp_over_ip.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static string concat( const vector<string>& buffers )
+{
+  string ret;
+  for ( const auto& buffer : buffers ) {
+    ret.append( buffer );
+  }
+  return ret;
+}
+
+// the adapter cuts a segment up into the same datagrams as it would wrap the pieces one by one
+static void adapter_test( const TCPMessage& msg )
+{
+  TCPOverIPv4Adapter adapter;
+  adapter.config_mut().source = Address { "10.0.0.1", 1234 };
+  adapter.config_mut().destination = Address { "10.0.0.2", 80 };
+
+  vector<string> wire;
+  adapter.wrap_tcp_in_ip( msg, [&]( const TCPOverIPv4Adapter::WireDatagram& dgram ) {
+    wire.push_back( string( dgram[0] ) + string( dgram[1] ) + string( dgram[2] ) );
+  } );
+
+  const string payload { string_view( msg.sender.payload ) };
+  const size_t step = msg.sender.gso_size ? msg.sender.gso_size : payload.size();
+  size_t offset = 0;
+  size_t count = 0;
+  do {
+    TCPMessage piece = msg;
+    piece.sender.gso_size = 0;
+    piece.sender.seqno = msg.sender.seqno + offset;
+    piece.sender.payload = payload.substr( offset, step );
+    offset += piece.sender.payload.size();
+    piece.sender.FIN = msg.sender.FIN and offset == payload.size();
+
+    test_should_be( count < wire.size(), true );
+    test_should_be( wire[count] == concat( serialize( adapter.wrap_tcp_in_ip( piece ) ) ), true );
+
+    InternetDatagram dgram;
+    test_should_be( parse( dgram, vector<string> { wire[count] } ), true );
+    TCPSegment seg;
+    test_should_be( parse( seg, std::move( dgram.payload ), dgram.header.pseudo_checksum() ), true );
+    test_should_be( seg.message.sender.seqno == piece.sender.seqno, true );
+    test_should_be( seg.message.sender.FIN, piece.sender.FIN );
+    test_should_be( string_view( seg.message.sender.payload ) == string_view( piece.sender.payload ), true );
+    ++count;
+  } while ( offset < payload.size() );
+  test_should_be( wire.size(), count );
+
+  // and hands out the same datagrams unserialized, for a caller that routes them
+  vector<string> routed;
+  adapter.wrap_tcp_in_datagrams( msg, [&]( const InternetDatagram& dgram ) {
+    routed.push_back( concat( serialize( dgram ) ) );
+  } );
+  test_should_be( routed == wire, true );
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    TCPConfig cfg;
+    cfg.gso = true;
+    cfg.mtu_probing = false;
+    cfg.timestamps = false;
+    cfg.rack_tlp = false;
+    cfg.congestion_control = CongestionControl::Algorithm::None;
+
+    {
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "A run of full-sized segments goes out as one", cfg, FromConfig {} };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_gso_size( 0 ) );
+      test.execute( PeerMSS { 1000 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 20000 ) );
+      test.execute( Push { string( 5500, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 5500 ).with_gso_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 5500 } );
+
+      // one segment is no run
+      test.execute( Push { string( 1000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_gso_size( 0 ).with_seqno( isn + 5501 ) );
+
+      // the FIN goes on the last of them
+      test.execute( Push { string( 2500, 'x' ) }.with_close() );
+      test.execute( ExpectMessage {}.with_payload_size( 2500 ).with_gso_size( 1000 ).with_fin( true ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "The window ends a run", cfg, FromConfig {} };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( PeerMSS { 1000 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 3000 ) );
+      test.execute( Push { string( 5000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 3000 ).with_gso_size( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 2001 }.with_win( 3000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 2000 ).with_gso_size( 1000 ).with_seqno( isn + 3001 ) );
+    }
+
+    {
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.send_capacity = 100000;
+
+      TCPSenderTestHarness test { "Runs of up to GSO_MAX_SIZE bytes", cfg, FromConfig {} };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( PeerMSS { 1000 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 65535 ) );
+      test.execute( PeerWindowScale { 2 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 25000 ) );
+      test.execute( Push { string( 70000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 65000 ).with_gso_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 5000 ).with_gso_size( 1000 ).with_seqno( isn + 65001 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      const Wrap32 isn( rd() );
+      const uint16_t retx_timeout = uniform_int_distribution<uint16_t> { 10, 10000 }( rd );
+      cfg.isn = isn;
+      cfg.rt_timeout = retx_timeout;
+
+      // the sender keeps track of every segment of a run, so a loss costs just the one segment
+      TCPSenderTestHarness test { "Retransmitting a segment of a run", cfg, FromConfig {} };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( PeerMSS { 1000 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 20000 ) );
+      test.execute( Push { string( 4000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 4000 ).with_gso_size( 1000 ) );
+      test.execute( AckReceived { isn + 2001 }.with_win( 20000 ) );
+      test.execute( Tick( retx_timeout ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_gso_size( 0 ).with_seqno( isn + 2001 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      auto random_payload = [&]( size_t size ) {
+        string ret( size, 0 );
+        for ( auto& ch : ret ) {
+          ch = static_cast<char>( rd() );
+        }
+        return ret;
+      };
+
+      TCPMessage msg;
+      msg.sender.seqno = Wrap32( rd() );
+      msg.sender.payload = random_payload( 1000 );
+      adapter_test( msg ); // no GSO
+
+      msg.sender.gso_size = 1000;
+      msg.sender.payload = random_payload( 5000 );
+      adapter_test( msg );
+
+      // the last datagram is shorter (and odd), has the FIN, and the seqno wraps around
+      msg.sender.seqno = Wrap32( UINT32_MAX - 2500 );
+      msg.sender.payload = random_payload( 4321 );
+      msg.sender.FIN = true;
+      msg.receiver.ackno = Wrap32( rd() );
+      msg.receiver.window_size = 4567;
+      adapter_test( msg );
+
+      // options in the header
+      msg.sender.timestamp = rd();
+      msg.receiver.timestamp_echo = rd();
+      msg.receiver.sack = { { Wrap32( 100 ), Wrap32( 200 ) }, { Wrap32( 300 ), Wrap32( 400 ) } };
+      msg.sender.gso_size = 997;
+      msg.sender.payload = random_payload( 9999 );
+      adapter_test( msg );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
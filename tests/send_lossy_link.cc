@@ -0,0 +1,227 @@
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+// one direction of a link with a fixed delay that drops each message with the same probability
+// (and with a bandwidth, if given, queues the messages behind one another, dropping those that find the queue
+// full; with an MTU, drops larger datagrams)
+class LossyLink
+{
+public:
+  LossyLink( uint64_t delay_ms,
+             double loss_rate,
+             uint32_t seed,
+             uint64_t bytes_per_ms = 0,
+             size_t mtu = 0,
+             uint64_t queue_limit = 0 )
+    : delay_ms_( delay_ms )
+    , bytes_per_ms_( bytes_per_ms )
+    , mtu_( mtu )
+    , queue_limit_( queue_limit )
+    , loss_ { loss_rate }
+    , rng_ { seed }
+  {}
+
+  void send( TCPMessage msg, uint64_t now )
+  {
+    const size_t size = msg.sender.payload.size() + TCPConfig::HEADERS_SIZE + ( msg.sender.timestamp ? 12 : 0 );
+    uint64_t sent = now;
+    if ( queue_limit_ and busy_until_ > now * bytes_per_ms_ + queue_limit_ ) {
+      return; // the router's queue is full
+    }
+    if ( bytes_per_ms_ ) {
+      busy_until_ = max( busy_until_, now * bytes_per_ms_ ) + size; // in bytes sent
+      sent = ( busy_until_ + bytes_per_ms_ - 1 ) / bytes_per_ms_;
+    }
+    if ( mtu_ and size > mtu_ ) {
+      return;
+    }
+    if ( not loss_( rng_ ) ) {
+      in_flight_.emplace( sent + delay_ms_, move( msg ) );
+    }
+  }
+
+  // hand the messages due by `now` to `peer`
+  void deliver( TCPPeer& peer, uint64_t now, const TCPPeer::TransmitFunction& reply )
+  {
+    while ( not in_flight_.empty() and in_flight_.front().first <= now ) {
+      peer.receive( move( in_flight_.front().second ), reply );
+      in_flight_.pop();
+    }
+  }
+
+private:
+  uint64_t delay_ms_;
+  uint64_t bytes_per_ms_;
+  size_t mtu_;
+  uint64_t queue_limit_; // in bytes
+  uint64_t busy_until_ {};
+  bernoulli_distribution loss_;
+  minstd_rand rng_;
+  queue<pair<uint64_t, TCPMessage>> in_flight_ {};
+};
+
+// how long it takes to move `size` bytes from one peer to the other, in milliseconds
+static uint64_t transfer_time( const TCPConfig& cfg,
+                               uint64_t size,
+                               double loss_rate,
+                               uint64_t delay_ms = 10,
+                               uint64_t bytes_per_ms = 0,
+                               size_t path_mtu = 0,
+                               uint64_t queue_limit = 0 )
+{
+  TCPPeer sender { cfg };
+  TCPPeer receiver { cfg };
+  LossyLink uplink { delay_ms, loss_rate, 144, bytes_per_ms, path_mtu, queue_limit };
+  LossyLink downlink { delay_ms, 0, 0 };
+
+  uint64_t now = 0;
+  const TCPPeer::TransmitFunction send = [&]( TCPMessage msg ) { uplink.send( move( msg ), now ); };
+  const TCPPeer::TransmitFunction reply = [&]( TCPMessage msg ) { downlink.send( move( msg ), now ); };
+
+  const string chunk( 1000, 'x' );
+  uint64_t pushed = 0;
+  uint64_t received = 0;
+  while ( received < size ) {
+    if ( now > 600000 ) {
+      throw runtime_error( "transfer did not finish in 10 minutes" );
+    }
+    while ( pushed < size and sender.outbound_writer().available_capacity() >= chunk.size() ) {
+      sender.outbound_writer().push( chunk );
+      pushed += chunk.size();
+    }
+    sender.push( send );
+    uplink.deliver( receiver, now, reply );
+    downlink.deliver( sender, now, send );
+    received += receiver.inbound_reader().bytes_buffered();
+    receiver.inbound_reader().pop( receiver.inbound_reader().bytes_buffered() );
+
+    ++now;
+    sender.tick( 1, send );
+    receiver.tick( 1, reply );
+  }
+  return now;
+}
+
+int main()
+{
+  try {
+    constexpr uint64_t size = 2'000'000;
+    constexpr double loss_rate = 0.01;
+    constexpr double heavy_loss_rate = 0.05;
+
+    TCPConfig cfg;
+    cfg.send_capacity = 2 * TCPConfig::DEFAULT_CAPACITY; // room for a full window in flight, and the next one
+    const uint64_t lossless = transfer_time( cfg, size, 0 );
+    const uint64_t rack = transfer_time( cfg, size, loss_rate );
+    const uint64_t rack_heavy = transfer_time( cfg, size, heavy_loss_rate );
+    cfg.rack_tlp = false;
+    cfg.mtu_probing = false; // segments of one size from the start: each run loses the same ones
+    const uint64_t timestamped_heavy = transfer_time( cfg, size, heavy_loss_rate );
+    cfg.timestamps = false;
+    const uint64_t sack = transfer_time( cfg, size, loss_rate );
+    const uint64_t sack_heavy = transfer_time( cfg, size, heavy_loss_rate );
+    cfg.sack = false;
+    const uint64_t fast_retransmit = transfer_time( cfg, size, loss_rate );
+    const uint64_t fast_retransmit_heavy = transfer_time( cfg, size, heavy_loss_rate );
+    cfg.fast_retransmit = false;
+    const uint64_t timeout_only = transfer_time( cfg, size, loss_rate );
+
+    cout << "2 MB over a 20 ms round trip: " << lossless << " ms without loss\n"
+         << "  with 1% loss: " << rack << " ms with RACK-TLP, " << sack << " ms with SACK, " << fast_retransmit
+         << " ms with fast retransmit alone, " << timeout_only << " ms with retransmission timeouts only\n"
+         << "  with 5% loss: " << rack_heavy << " ms with RACK-TLP, " << sack_heavy << " ms with SACK, "
+         << fast_retransmit_heavy << " ms with fast retransmit alone, " << timestamped_heavy
+         << " ms with SACK and timestamps\n";
+
+    // each loss costs about one round trip instead of a 200+ ms timeout and a restart from slow start
+    test_should_be( fast_retransmit < lossless * 4, true );
+    test_should_be( fast_retransmit * 2 < timeout_only, true );
+
+    // with several losses per window, SACK finds them all in the same round trip
+    test_should_be( sack <= fast_retransmit, true );
+    test_should_be( sack_heavy * 5 < fast_retransmit_heavy * 4, true );
+
+    // and RACK-TLP finds the lost retransmissions and tails that leave SACK waiting for the timeout
+    test_should_be( rack < lossless * 4, true );
+    test_should_be( rack_heavy * 2 < sack_heavy, true );
+
+    // and with timestamps, the acks of retransmissions are timed too: the RTO comes back down after a back-off
+    test_should_be( timestamped_heavy * 2 < sack_heavy, true );
+
+    // a path with a 100 ms round trip and 10 MB/s of bandwidth: it takes a window of 1 MB to keep it full
+    constexpr uint64_t rate = 10'000;
+    TCPConfig big;
+    big.send_capacity = big.recv_capacity = 4'000'000;
+    const uint64_t scaled_short = transfer_time( big, 8'000'000, 0, 50, rate );
+    const uint64_t scaled_long = transfer_time( big, 16'000'000, 0, 50, rate );
+    big.window_scaling = false;
+    const uint64_t unscaled = transfer_time( big, 4'000'000, 0, 50, rate );
+    const uint64_t scaled_rate = 8'000'000 / ( scaled_long - scaled_short ); // past slow start
+    const uint64_t unscaled_rate = 4'000'000 / unscaled;
+    cout << "100 ms round trip at 10 MB/s, with 4 MB buffers: " << scaled_rate << " kB/s with window scaling, "
+         << unscaled_rate << " kB/s without\n";
+
+    // without scaling, 64 KiB per round trip; with it, the whole bandwidth
+    test_should_be( unscaled_rate < 700, true );
+    test_should_be( scaled_rate * 10 >= rate * 9, true );
+
+    // past slow start, on a 20 ms round trip at 10 MB/s, with segments of MAX_PAYLOAD_SIZE, of a standard
+    // Ethernet MSS, and of a jumbo-frame MSS: the larger the segments, the less of the link goes to headers
+    TCPConfig bulk = big;
+    bulk.window_scaling = true;
+    const auto bulk_rate = [&]( size_t path_mtu = 0 ) {
+      return 4'000'000 / ( transfer_time( bulk, 8'000'000, 0, 10, rate, path_mtu )
+                           - transfer_time( bulk, 4'000'000, 0, 10, rate, path_mtu ) );
+    };
+    bulk.mtu_probing = false;
+    bulk.mtu = TCPConfig::MAX_PAYLOAD_SIZE + TCPConfig::HEADERS_SIZE;
+    const uint64_t small_rate = bulk_rate();
+    bulk.mtu = EthernetHeader::MTU;
+    const uint64_t ethernet_rate = bulk_rate();
+    bulk.mtu = EthernetHeader::JUMBO_MTU;
+    const uint64_t jumbo_rate = bulk_rate();
+    bulk.mtu_probing = true;
+    const uint64_t probed_jumbo_rate = bulk_rate();
+    const uint64_t probed_ethernet_rate = bulk_rate( EthernetHeader::MTU );
+    cout << "20 ms round trip at 10 MB/s: " << small_rate << " kB/s with 1000-byte segments, " << ethernet_rate
+         << " kB/s with an Ethernet MSS, " << jumbo_rate << " kB/s with jumbo frames; probing up to jumbo frames, "
+         << probed_jumbo_rate << " kB/s, or " << probed_ethernet_rate
+         << " kB/s over a path that carries only standard frames\n";
+
+    test_should_be( ethernet_rate > small_rate, true );
+    test_should_be( jumbo_rate > ethernet_rate, true );
+
+    // probing finds the largest segments the path carries, even where that is less than both ends' MSS
+    test_should_be( probed_jumbo_rate >= jumbo_rate, true );
+    test_should_be( probed_ethernet_rate > small_rate, true );
+
+    // the same path, but a router queue that holds 1.5 ms of traffic: bursts behind each ack overflow it
+    TCPConfig shallow = big;
+    shallow.mtu_probing = false;
+    const uint64_t bursty = transfer_time( shallow, 4'000'000, 0, 10, rate, 0, 15'000 );
+    shallow.pacing = true;
+    const uint64_t paced = transfer_time( shallow, 4'000'000, 0, 10, rate, 0, 15'000 );
+    cout << "4 MB over a 20 ms round trip at 10 MB/s, with a 15 kB queue: " << bursty << " ms, or " << paced
+         << " ms with pacing\n";
+
+    // spread over the round trip, the same windows fit the queue, and lose less to overflows
+    test_should_be( paced * 10 < bursty * 9, true );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+// without probing, segments are as large as the peer's MSS allows at once
+static void segment_size_test( const string& name,
+                               size_t mtu,
+                               bool timestamps,
+                               optional<uint16_t> peer_mss,
+                               uint64_t segment_size )
+{
+  TCPConfig cfg;
+  const Wrap32 isn( get_random_engine()() );
+  cfg.isn = isn;
+  cfg.mtu = mtu;
+  cfg.mtu_probing = false;
+  cfg.timestamps = timestamps;
+  cfg.congestion_control = CongestionControl::Algorithm::None;
+
+  TCPSenderTestHarness test { name, cfg, FromConfig {} };
+  test.execute( Push {} );
+  test.execute( ExpectMessage {}.with_syn( true ) );
+  test.execute( PeerMSS { peer_mss } );
+  test.execute( AckReceived { isn + 1 }.with_win( 20000 ) );
+  test.execute( ExpectMSS { segment_size } );
+  test.execute( Push { string( segment_size + 1, 'x' ) } );
+  test.execute( ExpectMessage {}.with_payload_size( segment_size ).with_seqno( isn + 1 ) );
+  test.execute( ExpectMessage {}.with_payload_size( 1 ) );
+  test.execute( ExpectNoSegment {} );
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "MSS offered on the SYN", cfg, FromConfig {} };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_mss( 1460 ) );
+
+      cfg.mtu = EthernetHeader::JUMBO_MTU;
+      TCPSenderTestHarness jumbo { "MSS of a link with jumbo frames", cfg, FromConfig {} };
+      jumbo.execute( Push {} );
+      jumbo.execute( ExpectMessage {}.with_syn( true ).with_mss( 8960 ) );
+    }
+
+    segment_size_test( "Segments of the peer's MSS", EthernetHeader::MTU, false, 1460, 1460 );
+    segment_size_test( "Room for the timestamps option", EthernetHeader::MTU, true, 1460, 1448 );
+    segment_size_test( "No MSS from the peer", EthernetHeader::MTU, false, nullopt, 536 );
+    segment_size_test( "Our own MTU is smaller", 1200, false, 1460, 1160 );
+    segment_size_test( "A tiny MSS from the peer", EthernetHeader::MTU, true, 10, TCPConfig::MIN_MSS - 12 );
+    segment_size_test( "An MSS of 0 from the peer", EthernetHeader::MTU, false, 0, TCPConfig::MIN_MSS );
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.timestamps = false;
+      cfg.congestion_control = CongestionControl::Algorithm::None;
+
+      TCPSenderTestHarness test { "A delivered probe raises the MSS", cfg, FromConfig {} };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( PeerMSS { 1460 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 20000 ) );
+      test.execute( ExpectMSS { TCPConfig::MAX_PAYLOAD_SIZE } );
+      test.execute( Push { string( 3000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1460 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 540 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 1461 }.with_win( 20000 ) );
+      test.execute( ExpectMSS { 1460 } );
+      test.execute( Push { string( 3000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1460 ).with_seqno( isn + 3001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1460 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 80 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.mtu = EthernetHeader::JUMBO_MTU;
+      cfg.timestamps = false;
+      cfg.rack_tlp = false;
+      cfg.congestion_control = CongestionControl::Algorithm::None;
+
+      // jumbo frames at both ends, but a standard Ethernet link between them
+      TCPSenderTestHarness test { "Lost probes narrow the search", cfg, FromConfig {} };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_mss( 8960 ) );
+      test.execute( PeerMSS { 8960 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 60000 ) );
+
+      uint64_t acked = 1;
+      for ( unsigned probe = 0; probe < TCPConfig::MAX_MTU_PROBES; ++probe ) {
+        test.execute( Push { string( 9960, 'x' ) } );
+        test.execute( ExpectMessage {}.with_payload_size( 8960 ).with_seqno( isn + acked ) );
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+        test.execute( ExpectNoSegment {} );
+
+        // three duplicate acks: the probe is sent again in pieces that fit
+        test.execute( AckReceived { isn + acked }.with_win( 60000 ) );
+        test.execute( AckReceived { isn + acked }.with_win( 60000 ) );
+        test.execute( ExpectNoSegment {} );
+        test.execute( AckReceived { isn + acked }.with_win( 60000 ) );
+        for ( unsigned piece = 0; piece < 8; ++piece ) {
+          test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + acked + piece * 1000 ) );
+        }
+        test.execute( ExpectMessage {}.with_payload_size( 960 ) );
+        test.execute( ExpectNoSegment {} );
+
+        acked += 9960;
+        test.execute( AckReceived { isn + acked }.with_win( 60000 ) );
+        test.execute( ExpectMSS { TCPConfig::MAX_PAYLOAD_SIZE } );
+      }
+
+      // the search gives up on 8960 bytes, and tries halfway between what works and what did not
+      test.execute( Push { string( 5980, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 4980 ).with_seqno( isn + acked ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+    }
+
+    {
+      // the option survives serialization: MSS (4 bytes) fills a word of its own
+      TCPSegment syn;
+      syn.message.sender.SYN = true;
+      syn.message.sender.mss = 1460;
+      syn.compute_checksum( 0 );
+      test_should_be( serialize( syn ).front().size(), size_t { 24 } );
+      TCPSegment parsed;
+      test_should_be( parse( parsed, serialize( syn ), 0 ), true );
+      test_should_be( parsed.message.sender.mss.value_or( 0 ), uint16_t { 1460 } );
+
+      // only a SYN carries it
+      TCPSegment plain;
+      plain.message.sender.mss = 1460;
+      test_should_be( serialize( plain ).front().size(), size_t { 20 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.pacing = true;
+      cfg.pacing_rate = 1'000'000; // a segment per millisecond
+      cfg.mtu_probing = false;
+      cfg.timestamps = false;
+      cfg.congestion_control = CongestionControl::Algorithm::None;
+
+      TCPSenderTestHarness test { "A burst of two segments, then one per tick", cfg, FromConfig {} };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( PeerMSS { 1000 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 20000 ) );
+      test.execute( ExpectPacingRate { 1'000'000 } );
+      test.execute( Push { string( 5000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Push {} );
+      test.execute( ExpectNoSegment {} );
+      for ( unsigned i = 2; i < 5; ++i ) {
+        test.execute( Tick( 1 ) );
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + i * 1000 ) );
+        test.execute( ExpectNoSegment {} );
+      }
+      test.execute( Tick( 5 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // after an idle spell, the bucket holds no more than a burst
+      test.execute( Push { string( 3000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 5001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.pacing = true;
+      cfg.pacing_rate = 400'000; // a segment every 2.5 ms
+      cfg.mtu_probing = false;
+      cfg.timestamps = false;
+      cfg.congestion_control = CongestionControl::Algorithm::None;
+
+      TCPSenderTestHarness test { "A rate of a fraction of a segment per tick", cfg, FromConfig {} };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( PeerMSS { 1000 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 20000 ) );
+      test.execute( Push { string( 10000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectPacingWait { 3 } ); // the bucket owes the SYN's byte: 3 us to pay it back
+
+      // segments after 1, 3, 6, 8 and 11 ms: not rounded to one every 2 or 3 ticks
+      uint64_t sent = 2;
+      for ( unsigned ms = 1; ms <= 11; ++ms ) {
+        test.execute( Tick( 1 ) );
+        if ( ms == 1 || ms == 3 || ms == 6 || ms == 8 || ms == 11 ) {
+          test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + sent * 1000 ) );
+          ++sent;
+        }
+        test.execute( ExpectNoSegment {} );
+      }
+      test.execute( ExpectPacingWait { 1503 } ); // 601 bytes owed, at 0.4 bytes per microsecond
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.pacing = true;
+      cfg.mtu_probing = false;
+      cfg.timestamps = false;
+
+      TCPSenderTestHarness test { "The rate follows cwnd / SRTT", cfg, FromConfig {} };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( PeerMSS { 1000 } );
+      test.execute( ExpectPacingRate { 0 } ); // nothing is paced before a round trip is measured
+      test.execute( Tick( 100 ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 20000 ) );
+      test.execute( ExpectCongestionWindow { 4000 } );
+      test.execute( Push { "x" } );
+      test.execute( ExpectPacingRate { 80'000 } ); // twice 4000 bytes per 100 ms, in slow start
+      test.execute( ExpectMessage {}.with_payload_size( 1 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.mtu_probing = false;
+      cfg.timestamps = false;
+      cfg.congestion_control = CongestionControl::Algorithm::None;
+
+      TCPSenderTestHarness test { "Without pacing, all that the window allows at once", cfg, FromConfig {} };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( PeerMSS { 1000 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 20000 ) );
+      test.execute( Push { string( 5000, 'x' ) } );
+      for ( unsigned i = 0; i < 5; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      }
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
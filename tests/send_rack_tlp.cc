@@ -0,0 +1,104 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      // the last two segments are lost: no duplicate ack comes back to tell
+      TCPSenderTestHarness test { "Tail loss probe", cfg, FromConfig {} };
+      start_transfer( test, cfg, { .stream_size = 4000, .rtt_ms = 20 } );
+      test.execute( ExpectRTO { 200 } ); // the minimum, for a 20 ms round trip
+      test.execute( AckReceived { isn + 2001 }.with_win( 60000 ) );
+      test.execute( Tick { 39 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } ); // two round trips: the last segment again, long before the timeout
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 3001 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // the probe's SACK shows that the segment before it is lost
+      test.execute( Tick { 20 } );
+      test.execute( AckReceived { isn + 2001 }.with_win( 60000 ).with_sack( isn + 3001, isn + 4001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 2001 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSsthresh { 2000 } );
+      test.execute( Tick { 20 } );
+      test.execute( AckReceived { isn + 4001 }.with_win( 60000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectCongestionWindow { 2000 } );
+      test.execute( ExpectConsecutiveRetransmissions { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      // the second segment is lost, and only one segment after it is SACKed
+      TCPSenderTestHarness test { "RACK finds a loss without three duplicate acks", cfg, FromConfig {} };
+      start_transfer( test, cfg, { .stream_size = 4000, .rtt_ms = 20 } );
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ).with_sack( isn + 2001, isn + 3001 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 4 } ); // a quarter of the round trip, in case it was only reordered
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1001 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSsthresh { 2000 } );
+      test.execute( ExpectCongestionWindow { 3000 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Reordering within the window is no loss", cfg, FromConfig {} };
+      start_transfer( test, cfg, { .stream_size = 4000, .rtt_ms = 20 } );
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ).with_sack( isn + 2001, isn + 3001 ) );
+      test.execute( Tick { 2 } );
+      test.execute( AckReceived { isn + 3001 }.with_win( 60000 ) );
+      test.execute( Tick { 10 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSsthresh { CongestionControl::kUnlimited } );
+      test.execute( AckReceived { isn + 4001 }.with_win( 60000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rack_tlp = false;
+
+      TCPSenderTestHarness test { "RACK-TLP disabled: the tail waits for the timeout", cfg, FromConfig {} };
+      start_transfer( test, cfg, { .stream_size = 4000, .rtt_ms = 20 } );
+      test.execute( AckReceived { isn + 2001 }.with_win( 60000 ) );
+      test.execute( Tick { 40 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 159 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 2001 ) );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -200,6 +200,32 @@ int main()
       test.execute( ExpectSeqnosInFlight { 0 } );
       test.execute( HasError { false } );
     }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint16_t retx_timeout = uniform_int_distribution<uint16_t> { 10, 10000 }( rd );
+      cfg.isn = isn;
+      cfg.rt_timeout = retx_timeout;
+      cfg.send_capacity = 10;
+
+      TCPSenderTestHarness test { "Unacknowledged bytes stay in the stream", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( Push { "abcdefghij" } );
+      test.execute( ExpectMessage {}.with_data( "abcdefghij" ) );
+      test.execute( ExpectAvailableCapacity { 0 } );
+      test.execute( Push { "klm" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick( retx_timeout ) );
+      test.execute( ExpectMessage {}.with_data( "abcdefghij" ).with_seqno( isn + 1 ) );
+      test.execute( AckReceived { Wrap32 { isn + 11 } }.with_win( 1000 ) );
+      test.execute( ExpectAvailableCapacity { 10 } );
+      test.execute( Push { "klm" } );
+      test.execute( ExpectMessage {}.with_data( "klm" ).with_seqno( isn + 11 ) );
+      test.execute( ExpectAvailableCapacity { 7 } );
+    }
   } catch ( const exception& e ) {
     cerr << e.what() << endl;
     return 1;
@@ -0,0 +1,123 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rack_tlp = false;
+      cfg.rt_timeout_min = 10;
+
+      TCPSenderTestHarness test { "RTO follows the round-trip time", cfg, FromConfig {} };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( ExpectRTO { 1000 } );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectRTO { 300 } ); // SRTT = 100, RTTVAR = 50
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( Tick { 299 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ) );
+
+      // Karn's rule: the ack of a retransmitted segment is no sample
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+      test.execute( ExpectRTO { 300 } );
+
+      // the back-off is over, too
+      test.execute( Push { "def" } );
+      test.execute( ExpectMessage {}.with_data( "def" ).with_seqno( isn + 4 ) );
+      test.execute( Tick { 299 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "def" ).with_seqno( isn + 4 ) );
+      test.execute( AckReceived { Wrap32 { isn + 7 } } );
+
+      // a second sample as long as the first: RTTVAR shrinks
+      test.execute( Push { "ghi" } );
+      test.execute( ExpectMessage {}.with_data( "ghi" ).with_seqno( isn + 7 ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { Wrap32 { isn + 10 } } );
+      test.execute( ExpectRTO { 250 } ); // SRTT = 100, RTTVAR = 37.5
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rack_tlp = false;
+      cfg.rt_timeout_min = 10;
+
+      // the latest segment that was never retransmitted gives the sample
+      TCPSenderTestHarness test { "RTT sample from a cumulative ack", cfg, FromConfig {} };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectRTO { 120 } );
+      test.execute( Push { "a" } );
+      test.execute( Tick { 20 } );
+      test.execute( Push { "b" } );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { Wrap32 { isn + 3 } } );
+      test.execute( ExpectMessage {}.with_data( "a" ) );
+      test.execute( ExpectMessage {}.with_data( "b" ) );
+      test.execute( ExpectRTO { 100 } ); // sample 40 from "b": SRTT = 40, RTTVAR = 15
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rack_tlp = false;
+
+      TCPSenderTestHarness test { "RTO stays fixed by default", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectRTO { cfg.rt_timeout } );
+    }
+
+    {
+      RTTEstimator rtt { 1000, 200, 60000 };
+      test_should_be( rtt.has_sample(), false );
+      for ( unsigned i = 0; i < 50; ++i ) {
+        rtt.sample( 1 );
+      }
+      test_should_be( rtt.srtt_ms() < 2, true );
+      test_should_be( rtt.rto_ms(), uint64_t { 200 } );
+      rtt.sample( 1000000 );
+      test_should_be( rtt.rto_ms(), uint64_t { 60000 } );
+
+      RTTEstimator fixed { 500 };
+      fixed.sample( 10 );
+      test_should_be( fixed.has_sample(), true );
+      test_should_be( fixed.srtt_ms() == 10, true );
+      test_should_be( fixed.rto_ms(), uint64_t { 500 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,164 @@
+#include "checksum.hh"
+#include "random.hh"
+#include "sender_test_harness.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rack_tlp = false;
+
+      // the segments at 1001 and 3001 are lost
+      TCPSenderTestHarness test { "SACK: two holes recovered in one round trip", cfg, FromConfig {} };
+      start_transfer( test, cfg, { .stream_size = 10000, .ack_first_segment = true } );
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ).with_sack( isn + 2001, isn + 3001 ) );
+      test.execute( AckReceived { isn + 1001 }
+                      .with_win( 60000 )
+                      .with_sack( isn + 4001, isn + 5001 )
+                      .with_sack( isn + 2001, isn + 3001 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 1001 }
+                      .with_win( 60000 )
+                      .with_sack( isn + 4001, isn + 6001 )
+                      .with_sack( isn + 2001, isn + 3001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 500 ).with_seqno( isn + 6001 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // the next duplicate sends the second hole rather than new data
+      test.execute( AckReceived { isn + 1001 }
+                      .with_win( 60000 )
+                      .with_sack( isn + 4001, isn + 6501 )
+                      .with_sack( isn + 2001, isn + 3001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 3001 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCongestionWindow { 5500 } );
+
+      // the partial ack finds no hole left to fill: everything past it is SACKed or retransmitted
+      test.execute( AckReceived { isn + 3001 }.with_win( 60000 ).with_sack( isn + 4001, isn + 6501 ) );
+      test.execute( ExpectCongestionWindow { 4500 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 6501 ) );
+      test.execute( ExpectNoSegment {} );
+
+      test.execute( AckReceived { isn + 6501 }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 2500 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 7501 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 500 ).with_seqno( isn + 8501 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rack_tlp = false;
+
+      TCPSenderTestHarness test { "SACK blocks outside what is outstanding are ignored", cfg, FromConfig {} };
+      start_transfer( test, cfg, { .stream_size = 10000, .ack_first_segment = true } );
+      for ( unsigned i = 0; i < 3; ++i ) {
+        test.execute( AckReceived { isn + 1001 }
+                        .with_win( 60000 )
+                        .with_sack( isn + 1, isn + 1001 )
+                        .with_sack( isn + 5001, isn + 7001 )
+                        .with_sack( isn + 3001, isn + 2001 ) );
+      }
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 500 ).with_seqno( isn + 6001 ) );
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) ); // no SACK: NewReno inflation
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 6501 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rack_tlp = false;
+      cfg.sack = false;
+
+      TCPSenderTestHarness test { "SACK disabled", cfg, FromConfig {} };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_sack_permitted( false ).with_seqno( isn ) );
+    }
+
+    {
+      // the options survive serialization: SACK-permitted and four blocks (2 + 34 bytes) fill nine words
+      TCPSegment seg;
+      seg.message.sender.SYN = true;
+      seg.message.sender.SACK_permitted = true;
+      seg.message.sender.payload = string( "hello" );
+      seg.message.receiver.ackno = Wrap32 { 17 };
+      for ( uint32_t i = 0; i < 5; ++i ) {
+        seg.message.receiver.sack.emplace_back( Wrap32 { 100 * i }, Wrap32 { 100 * i + 50 } );
+      }
+      seg.compute_checksum( 0 );
+      vector<string> wire = serialize( seg );
+      string bytes;
+      for ( const auto& part : wire ) {
+        bytes += part;
+      }
+      test_should_be( bytes.size(), size_t { 20 + 36 + 5 } );
+      test_should_be( static_cast<uint8_t>( bytes[12] ) >> 4, 14 );
+
+      TCPSegment parsed;
+      test_should_be( parse( parsed, std::move( wire ), 0 ), true );
+      test_should_be( parsed.message.sender.SACK_permitted, true );
+      test_should_be( parsed.message.receiver.sack.size(), size_t { 4 } );
+      const pair<Wrap32, Wrap32> fourth { Wrap32 { 300 }, Wrap32 { 350 } };
+      test_should_be( parsed.message.receiver.sack[3] == fourth, true );
+      test_should_be( parsed.message.sender.payload.view() == "hello", true );
+
+      // padded with NOPs to a whole word
+      TCPSegment syn;
+      syn.message.sender.SYN = syn.message.sender.SACK_permitted = true;
+      syn.compute_checksum( 0 );
+      test_should_be( serialize( syn ).front().size(), size_t { 24 } );
+      TCPSegment parsed_syn;
+      test_should_be( parse( parsed_syn, serialize( syn ), 0 ), true );
+      test_should_be( parsed_syn.message.sender.SACK_permitted, true );
+
+      // options this implementation doesn't know are skipped: MSS and a NOP, then the end of the list and padding
+      TCPSegment plain;
+      plain.message.sender.payload = string( "hi" );
+      string raw;
+      for ( const auto& part : serialize( plain ) ) {
+        raw += part;
+      }
+      raw.insert( 20, string( { 2, 4, 5, static_cast<char>( 0xb4 ), 1, 0, 0, 0 } ) );
+      raw[12] = static_cast<char>( 7 << 4 );
+      InternetChecksum check;
+      check.add( raw );
+      const uint16_t cksum = check.value();
+      raw[16] = static_cast<char>( cksum >> 8 );
+      raw[17] = static_cast<char>( cksum & 0xff );
+
+      TCPSegment skipped;
+      test_should_be( parse( skipped, vector<string> { raw }, 0 ), true );
+      test_should_be( skipped.message.sender.SACK_permitted, false );
+      test_should_be( skipped.message.receiver.sack.empty(), true );
+      test_should_be( skipped.message.sender.payload.view() == "hi", true );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
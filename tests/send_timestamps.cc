@@ -0,0 +1,131 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+// a segment is retransmitted after a 100 ms round trip (RTO = 300 ms), and acknowledged 50 ms later
+static void retransmission_sample_test( const string& name, bool timestamps, uint64_t rto )
+{
+  TCPConfig cfg;
+  const Wrap32 isn( get_random_engine()() );
+  cfg.isn = isn;
+  cfg.rt_timeout_min = 10;
+  cfg.rack_tlp = false;
+  cfg.timestamps = timestamps;
+
+  TCPSenderTestHarness test { name, cfg, FromConfig {} };
+  test.execute( Push {} );
+  test.execute( ExpectMessage {}.with_syn( true ) );
+  test.execute( Tick { 100 } );
+  test.execute( AckReceived { isn + 1 }.with_timestamp_echo( 0 ) );
+  test.execute( ExpectRTO { 300 } );
+  test.execute( Push { "abc" } );
+  test.execute( ExpectMessage {}.with_data( "abc" ) );
+  test.execute( Tick { 300 } );
+  test.execute( ExpectMessage {}.with_data( "abc" ) );
+  test.execute( Tick { 50 } );
+  test.execute( AckReceived { isn + 4 }.with_timestamp_echo( 400 ) );
+  test.execute( ExpectRTO { rto } );
+}
+
+// a segment is sent after a 100 ms round trip (RTO = 300 ms), and acknowledged 50 ms later with the echo given
+static void echo_sample_test( const string& name, uint32_t echo, uint64_t rto )
+{
+  TCPConfig cfg;
+  const Wrap32 isn( get_random_engine()() );
+  cfg.isn = isn;
+  cfg.rt_timeout_min = 10;
+  cfg.rack_tlp = false;
+
+  TCPSenderTestHarness test { name, cfg, FromConfig {} };
+  test.execute( Push {} );
+  test.execute( ExpectMessage {}.with_syn( true ) );
+  test.execute( Tick { 100 } );
+  test.execute( AckReceived { isn + 1 }.with_timestamp_echo( 0 ) );
+  test.execute( ExpectRTO { 300 } );
+  test.execute( Tick { 1000 } );
+  test.execute( Push { "abc" } );
+  test.execute( ExpectMessage {}.with_data( "abc" ).with_timestamp( 1100 ) );
+  test.execute( Tick { 50 } );
+  test.execute( AckReceived { isn + 4 }.with_timestamp_echo( echo ) );
+  test.execute( ExpectRTO { rto } );
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Every segment stamped, retransmissions anew", cfg, FromConfig {} };
+      test.execute( Tick { 7 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_timestamp( 7 ) );
+      test.execute( Tick { 13 } );
+      test.execute( AckReceived { isn + 1 }.with_timestamp_echo( 7 ) );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_timestamp( 20 ) );
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_timestamp( 1020 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "No timestamps once the peer's SYN had none", cfg, FromConfig {} };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_timestamp( 0 ) );
+      test.execute( PeerTimestamps { false } );
+      test.execute( AckReceived { isn + 1 } );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_timestamp( nullopt ) );
+
+      cfg.timestamps = false;
+      TCPSenderTestHarness off { "Timestamps off", cfg, FromConfig {} };
+      off.execute( Push {} );
+      off.execute( ExpectMessage {}.with_syn( true ).with_timestamp( nullopt ) );
+    }
+
+    // the echo times the retransmission, which Karn's rule leaves untimed
+    retransmission_sample_test( "Round trip of a retransmission", true, 294 );
+    retransmission_sample_test( "Karn's rule without timestamps", false, 300 );
+
+    // an echo that no segment in flight could have carried gives no sample: the segment itself is timed instead
+    echo_sample_test( "Echo from the future", 1200, 294 );
+    echo_sample_test( "Echo from before the segment was sent", 1000, 294 );
+
+    {
+      // the option survives serialization: two bytes of padding and ten of TSval and TSecr fill three words
+      TCPSegment seg;
+      seg.message.sender.timestamp = 123456789;
+      seg.message.receiver.ackno = Wrap32 { 1 };
+      seg.message.receiver.timestamp_echo = 987654321;
+      seg.compute_checksum( 0 );
+      test_should_be( serialize( seg ).front().size(), size_t { 32 } );
+      TCPSegment parsed;
+      test_should_be( parse( parsed, serialize( seg ), 0 ), true );
+      test_should_be( parsed.message.sender.timestamp.value_or( 0 ), uint32_t { 123456789 } );
+      test_should_be( parsed.message.receiver.timestamp_echo.value_or( 0 ), uint32_t { 987654321 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
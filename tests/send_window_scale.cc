@@ -0,0 +1,95 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static void scaled_window_test( const string& name,
+                                bool window_scaling,
+                                optional<uint8_t> peer_shift,
+                                uint16_t window,
+                                uint64_t in_flight )
+{
+  TCPConfig cfg;
+  const Wrap32 isn( get_random_engine()() );
+  cfg.isn = isn;
+  cfg.window_scaling = window_scaling;
+  cfg.congestion_control = CongestionControl::Algorithm::None;
+
+  TCPSenderTestHarness test { name, cfg, FromConfig {} };
+  test.execute( Push {} );
+  test.execute( ExpectMessage {}.with_syn( true ) );
+  test.execute( AckReceived { isn + 1 }.with_win( 137 ).without_push() ); // the window of a SYN is never scaled
+  test.execute( PeerWindowScale { peer_shift } );
+  test.execute( AckReceived { isn + 1 }.with_win( window ) );
+  test.execute( Push { string( 64000, 'x' ) } );
+  test.execute( ExpectSeqnosInFlight { in_flight } );
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.recv_capacity = 1000000;
+
+      TCPSenderTestHarness test { "Window scale offered on the SYN", cfg, FromConfig {} };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_window_scale( 4 ).with_seqno( isn ) );
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectMessage {}.with_syn( true ).with_window_scale( 4 ).with_seqno( isn ) );
+
+      cfg.recv_capacity = TCPConfig::DEFAULT_CAPACITY;
+      TCPSenderTestHarness small { "Window scale 0 for a small receive buffer", cfg, FromConfig {} };
+      small.execute( Push {} );
+      small.execute( ExpectMessage {}.with_syn( true ).with_window_scale( 0 ) );
+
+      cfg.window_scaling = false;
+      TCPSenderTestHarness off { "No window scale", cfg, FromConfig {} };
+      off.execute( Push {} );
+      off.execute( ExpectMessage {}.with_syn( true ).with_window_scale( nullopt ) );
+    }
+
+    // the window that the peer advertises is shifted left by its scale, if both SYNs offered one
+    scaled_window_test( "Window shifted by the peer's scale", true, 3, 1000, 8000 );
+    scaled_window_test( "No window scale from the peer", true, nullopt, 1000, 1000 );
+    scaled_window_test( "No window scale offered", false, 3, 1000, 1000 );
+    scaled_window_test( "Window scale beyond 14", true, 20, 1, 16384 );
+
+    {
+      // the option survives serialization: window scale (3 bytes) and SACK-permitted (2 bytes) fill two words
+      TCPSegment syn;
+      syn.message.sender.SYN = syn.message.sender.SACK_permitted = true;
+      syn.message.sender.window_scale = 7;
+      syn.compute_checksum( 0 );
+      test_should_be( serialize( syn ).front().size(), size_t { 28 } );
+      TCPSegment parsed;
+      test_should_be( parse( parsed, serialize( syn ), 0 ), true );
+      test_should_be( parsed.message.sender.SACK_permitted, true );
+      test_should_be( parsed.message.sender.window_scale.value_or( 0 ), uint8_t { 7 } );
+
+      // only a SYN carries it
+      TCPSegment plain;
+      plain.message.sender.window_scale = 7;
+      test_should_be( serialize( plain ).front().size(), size_t { 20 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
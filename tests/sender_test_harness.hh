@@ -10,6 +10,7 @@
 #include <optional>
 #include <queue>
 #include <sstream>
+#include <string>
 #include <utility>
 
 const unsigned int DEFAULT_TEST_WINDOW = 137;
@@ -80,6 +81,55 @@ struct ExpectConsecutiveRetransmissions : public ExpectNumber<SenderAndOutput, u
   uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.consecutive_retransmissions(); }
 };
 
+struct ExpectCongestionWindow : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "congestion_control().cwnd"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.congestion_control().cwnd(); }
+};
+
+struct ExpectSsthresh : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "congestion_control().ssthresh"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.congestion_control().ssthresh(); }
+};
+
+struct ExpectRTO : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "rtt().rto_ms"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.rtt().rto_ms(); }
+};
+
+struct ExpectMSS : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "mss"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.mss(); }
+};
+
+struct ExpectPacingRate : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "pacer().rate"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.pacer().rate(); }
+};
+
+struct ExpectPacingWait : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "pacer().wait_us"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.pacer().wait_us(); }
+};
+
+struct ExpectAvailableCapacity : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "writer().available_capacity"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.writer().available_capacity(); }
+};
+
 struct ExpectNoSegment : public Expectation<SenderAndOutput>
 {
   std::string description() const override { return "nothing to send"; }
@@ -192,7 +242,14 @@ struct Receive : public Action<SenderAndOutput>
   std::string description() const override
   {
     std::ostringstream desc;
-    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size << ")";
+    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size;
+    for ( const auto& [begin, end] : msg_.sack ) {
+      desc << ", sack=[" << begin << ", " << end << ")";
+    }
+    if ( msg_.timestamp_echo.has_value() ) {
+      desc << ", echo=" << msg_.timestamp_echo.value();
+    }
+    desc << ")";
     if ( push_ ) {
       desc << ", then push stream to TCPSender";
     }
@@ -213,6 +270,18 @@ struct Receive : public Action<SenderAndOutput>
     }
   }
 
+  Receive& with_sack( Wrap32 begin, Wrap32 end )
+  {
+    msg_.sack.emplace_back( begin, end );
+    return *this;
+  }
+
+  Receive& with_timestamp_echo( uint32_t echo )
+  {
+    msg_.timestamp_echo = echo;
+    return *this;
+  }
+
   Receive& without_push()
   {
     push_ = false;
@@ -220,6 +289,50 @@ struct Receive : public Action<SenderAndOutput>
   }
 };
 
+struct PeerWindowScale : public Action<SenderAndOutput>
+{
+  std::optional<uint8_t> shift_;
+
+  explicit PeerWindowScale( std::optional<uint8_t> shift ) : shift_( shift ) {}
+
+  std::string description() const override
+  {
+    return "the peer's SYN offers window scale "
+           + ( shift_.has_value() ? std::to_string( shift_.value() ) : std::string( "none" ) );
+  }
+
+  void execute( SenderAndOutput& ss ) const override { ss.sender.set_peer_window_scale( shift_ ); }
+};
+
+struct PeerTimestamps : public Action<SenderAndOutput>
+{
+  bool timestamps_;
+
+  explicit PeerTimestamps( bool timestamps ) : timestamps_( timestamps ) {}
+
+  std::string description() const override
+  {
+    return std::string( "the peer's SYN " ) + ( timestamps_ ? "has" : "has no" ) + " timestamp";
+  }
+
+  void execute( SenderAndOutput& ss ) const override { ss.sender.set_peer_timestamps( timestamps_ ); }
+};
+
+struct PeerMSS : public Action<SenderAndOutput>
+{
+  std::optional<uint16_t> mss_;
+
+  explicit PeerMSS( std::optional<uint16_t> mss ) : mss_( mss ) {}
+
+  std::string description() const override
+  {
+    return "the peer's SYN offers MSS "
+           + ( mss_.has_value() ? std::to_string( mss_.value() ) : std::string( "none" ) );
+  }
+
+  void execute( SenderAndOutput& ss ) const override { ss.sender.set_peer_mss( mss_ ); }
+};
+
 struct AckReceived : public Receive
 {
   explicit AckReceived( Wrap32 ackno ) : Receive( { ackno, DEFAULT_TEST_WINDOW } ) {}
@@ -235,9 +348,14 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
   std::optional<bool> syn {};
   std::optional<bool> fin {};
   std::optional<bool> rst {};
+  std::optional<bool> sack_permitted {};
+  std::optional<std::optional<uint8_t>> window_scale {};
+  std::optional<std::optional<uint32_t>> timestamp {};
+  std::optional<std::optional<uint16_t>> mss {};
   std::optional<Wrap32> seqno {};
   std::optional<std::string> data {};
   std::optional<size_t> payload_size {};
+  std::optional<uint16_t> gso_size {};
 
   ExpectMessage& with_syn( bool syn_ )
   {
@@ -263,6 +381,30 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
     return *this;
   }
 
+  ExpectMessage& with_sack_permitted( bool sack_permitted_ )
+  {
+    sack_permitted = sack_permitted_;
+    return *this;
+  }
+
+  ExpectMessage& with_window_scale( std::optional<uint8_t> window_scale_ )
+  {
+    window_scale = window_scale_;
+    return *this;
+  }
+
+  ExpectMessage& with_timestamp( std::optional<uint32_t> timestamp_ )
+  {
+    timestamp = timestamp_;
+    return *this;
+  }
+
+  ExpectMessage& with_mss( std::optional<uint16_t> mss_ )
+  {
+    mss = mss_;
+    return *this;
+  }
+
   ExpectMessage& with_seqno( Wrap32 seqno_ )
   {
     seqno = seqno_;
@@ -277,6 +419,12 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
     return *this;
   }
 
+  ExpectMessage& with_gso_size( uint16_t gso_size_ )
+  {
+    gso_size = gso_size_;
+    return *this;
+  }
+
   ExpectMessage& with_data( std::string data_ )
   {
     data = std::move( data_ );
@@ -308,6 +456,23 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
     if ( rst.has_value() ) {
       o << ( rst.value() ? " +RST" : " (no RST)" );
     }
+    if ( sack_permitted.has_value() ) {
+      o << ( sack_permitted.value() ? " +SACK-permitted" : " (no SACK-permitted)" );
+    }
+    if ( window_scale.has_value() ) {
+      o << ( window_scale->has_value() ? " window_scale=" + std::to_string( window_scale->value() )
+                                       : std::string( " (no window scale)" ) );
+    }
+    if ( timestamp.has_value() ) {
+      o << ( timestamp->has_value() ? " timestamp=" + std::to_string( timestamp->value() )
+                                    : std::string( " (no timestamp)" ) );
+    }
+    if ( mss.has_value() ) {
+      o << ( mss->has_value() ? " mss=" + std::to_string( mss->value() ) : std::string( " (no MSS)" ) );
+    }
+    if ( gso_size.has_value() ) {
+      o << ( gso_size.value() ? " gso_size=" + std::to_string( gso_size.value() ) : std::string( " (no GSO)" ) );
+    }
     return o.str();
   }
 
@@ -334,14 +499,35 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
     if ( rst.has_value() and seg.RST != rst.value() ) {
       throw ExpectationViolation( "RST flag", rst.value(), seg.RST );
     }
+    if ( sack_permitted.has_value() and seg.SACK_permitted != sack_permitted.value() ) {
+      throw ExpectationViolation( "SACK-permitted flag", sack_permitted.value(), seg.SACK_permitted );
+    }
+    if ( window_scale.has_value() and seg.window_scale != window_scale.value() ) {
+      const auto str = []( std::optional<uint8_t> shift ) {
+        return shift.has_value() ? std::to_string( shift.value() ) : std::string( "none" );
+      };
+      throw ExpectationViolation( "window scale option was " + str( seg.window_scale ) + ", but expected "
+                                  + str( window_scale.value() ) );
+    }
+    if ( timestamp.has_value() and seg.timestamp != timestamp.value() ) {
+      throw ExpectationViolation( "timestamp", timestamp.value(), seg.timestamp );
+    }
+    if ( mss.has_value() and seg.mss != mss.value() ) {
+      throw ExpectationViolation( "MSS", mss.value(), seg.mss );
+    }
     if ( seqno.has_value() and seg.seqno != seqno.value() ) {
       throw ExpectationViolation( "sequence number", seqno.value(), seg.seqno );
     }
     if ( payload_size.has_value() and seg.payload.size() != payload_size.value() ) {
       throw ExpectationViolation( "payload_size", payload_size.value(), seg.payload.size() );
     }
-    if ( seg.payload.size() > TCPConfig::MAX_PAYLOAD_SIZE ) {
-      throw ExpectationViolation( "payload has length (" + std::to_string( seg.payload.size() )
+    if ( gso_size.has_value() and seg.gso_size != gso_size.value() ) {
+      throw ExpectationViolation( "gso_size", gso_size.value(), seg.gso_size );
+    }
+    // with GSO, the segments that go on the wire are those the adapter cuts the payload into
+    const size_t wire_payload_size = seg.gso_size ? seg.gso_size : seg.payload.size();
+    if ( wire_payload_size > ss.sender.peer_mss() ) {
+      throw ExpectationViolation( "payload has length (" + std::to_string( wire_payload_size )
                                   + ") greater than the maximum" );
     }
     if ( data.has_value() and data.value() != static_cast<std::string>( seg.payload ) ) {
@@ -353,6 +539,9 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
   }
 };
 
+struct FromConfig
+{};
+
 class TCPSenderTestHarness : public TestHarness<SenderAndOutput>
 {
 public:
@@ -361,4 +550,53 @@ public:
                    "initial_RTO_ms=" + to_string( config.rt_timeout ),
                    { TCPSender { ByteStream { config.send_capacity }, config.isn, config.rt_timeout } } )
   {}
+
+  TCPSenderTestHarness( std::string name, TCPConfig config, CongestionControl::Algorithm congestion_control )
+    : TestHarness(
+      move( name ),
+      "initial_RTO_ms=" + to_string( config.rt_timeout ),
+      { TCPSender { ByteStream { config.send_capacity }, config.isn, config.rt_timeout, congestion_control } } )
+  {}
+
+  // with the sender built from the whole config: adaptive RTO, congestion control, fast retransmit...
+  TCPSenderTestHarness( std::string name, TCPConfig config, FromConfig /* tag */ )
+    : TestHarness( move( name ),
+                   "initial_RTO_ms=" + to_string( config.rt_timeout ),
+                   { TCPSender { ByteStream { config.send_capacity }, config } } )
+  {}
+};
+
+// How start_transfer() opens a connection
+struct TransferStart
+{
+  size_t stream_size;             // bytes pushed once the SYN is acknowledged
+  uint64_t rtt_ms = 0;            // the round trip of the SYN, and then of the first window, if not 0
+  bool ack_first_segment = false; // then have the first segment acknowledged, which lets slow start send two more
 };
+
+// Open the connection and send the initial window of four 1000-byte segments: [1, 4001) in stream indices. With
+// `ack_first_segment`, [1001, 6001) is then in flight, with cwnd = 5000. With `rtt_ms`, the sender has measured
+// that round trip on the SYN, and the window has been in flight for as long.
+inline void start_transfer( TCPSenderTestHarness& test, const TCPConfig& cfg, const TransferStart& start )
+{
+  test.execute( Push {} );
+  test.execute( ExpectMessage {}.with_syn( true ).with_sack_permitted( cfg.sack ).with_seqno( cfg.isn ) );
+  if ( start.rtt_ms ) {
+    test.execute( Tick { start.rtt_ms } );
+  }
+  test.execute( AckReceived { cfg.isn + 1 }.with_win( 60000 ) );
+  test.execute( Push { std::string( start.stream_size, 'x' ) } );
+  for ( unsigned i = 0; i < 4; ++i ) {
+    test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( cfg.isn + 1 + 1000 * i ) );
+  }
+  if ( start.ack_first_segment ) {
+    test.execute( AckReceived { cfg.isn + 1001 }.with_win( 60000 ) );
+    test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( cfg.isn + 4001 ) );
+    test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( cfg.isn + 5001 ) );
+    test.execute( ExpectSeqnosInFlight { 5000 } );
+  }
+  test.execute( ExpectNoSegment {} );
+  if ( start.rtt_ms ) {
+    test.execute( Tick { start.rtt_ms } );
+  }
+}
@@ -0,0 +1,113 @@
+#include "spsc_byte_stream.hh"
+
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "SPSCByteStream: " + what );
+  }
+}
+
+void single_thread()
+{
+  SPSCByteStream bs { 4 };
+
+  expect( bs.push( "abc" ) == 3, "push into empty stream" );
+  bs.pop( 2 );
+  expect( bs.push( "defg" ) == 3, "push is limited by available capacity" );
+  expect( bs.available_capacity() == 0 and bs.bytes_buffered() == 4, "accounting after wrap" );
+
+  const auto spans = bs.peek_spans();
+  expect( spans[0] == "cd" and spans[1] == "ef", "peek_spans after wrap" );
+  expect( bs.peek() == "cd", "peek stops at the wrap point" );
+
+  bs.pop( 10 );
+  expect( bs.bytes_popped() == 6 and bs.bytes_buffered() == 0, "over-pop" );
+
+  bs.close();
+  expect( bs.push( "x" ) == 0, "push after close" );
+  expect( bs.is_finished(), "finished after close" );
+
+  // arming while the reader can already make progress signals the wakeup immediately
+  bs.arm_reader_wakeup();
+  bs.wait_until_readable();
+  bs.clear_reader_wakeup();
+}
+
+void zero_capacity()
+{
+  SPSCByteStream bs { 0 };
+
+  expect( bs.push( "abc" ) == 0 and bs.available_capacity() == 0, "push into a stream of capacity 0" );
+  const auto spans = bs.peek_spans();
+  expect( spans[0].empty() and spans[1].empty() and bs.peek().empty(), "peek a stream of capacity 0" );
+  bs.pop( 1 );
+  bs.close();
+  expect( bs.is_finished() and bs.bytes_popped() == 0, "finished after close" );
+}
+
+void two_threads( const size_t input_len, const size_t capacity, const size_t random_seed )
+{
+  default_random_engine rd { random_seed };
+  const string data = [&] {
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  SPSCByteStream bs { capacity };
+
+  thread writer { [&] {
+    default_random_engine wrd { random_seed + 1 };
+    uniform_int_distribution<size_t> sizes { 1, 2 * capacity };
+    size_t pushed = 0;
+    while ( pushed < data.size() ) {
+      bs.wait_until_writable();
+      pushed += bs.push( string_view( data ).substr( pushed, sizes( wrd ) ) );
+    }
+    bs.close();
+  } };
+
+  string out;
+  uniform_int_distribution<size_t> sizes { 1, 2 * capacity };
+  while ( true ) {
+    bs.wait_until_readable();
+    if ( bs.is_finished() ) {
+      break;
+    }
+    const auto peeked = bs.peek().substr( 0, sizes( rd ) );
+    out += peeked;
+    bs.pop( peeked.size() );
+  }
+  writer.join();
+
+  expect( out == data, "bytes were lost or reordered between threads" );
+  expect( bs.bytes_pushed() == input_len and bs.bytes_popped() == input_len, "counters after transfer" );
+}
+
+int main()
+{
+  try {
+    single_thread();
+    zero_capacity();
+    two_threads( 1000, 1, 1234 );
+    two_threads( 100000, 17, 5678 );
+    two_threads( 1000000, 4096, 9012 );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
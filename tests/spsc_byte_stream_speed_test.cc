@@ -0,0 +1,138 @@
+#include "exception.hh"
+#include "socket.hh"
+#include "spsc_byte_stream.hh"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sys/socket.h>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+static string make_data( const size_t input_len, const size_t random_seed )
+{
+  default_random_engine rd { random_seed };
+  uniform_int_distribution<char> ud;
+  string ret;
+  for ( size_t i = 0; i < input_len; ++i ) {
+    ret += ud( rd );
+  }
+  return ret;
+}
+
+static void report( const string& path, const size_t input_len, duration<double> test_duration )
+{
+  const double gigabits_per_second = 8 * static_cast<double>( input_len ) / test_duration.count() / 1e9;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << path << " reached " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
+  debug_output << "             " << path << " throughput: " << fixed << setprecision( 2 ) << gigabits_per_second
+               << " Gbit/s\n";
+
+  if ( gigabits_per_second < 0.1 ) {
+    throw runtime_error( path + " did not meet minimum speed of 0.1 Gbit/s." );
+  }
+}
+
+// the owner thread writes `write_size` chunks, the other thread reads them, as TCPMinnowSocket does
+void spsc_speed_test( const string& data, const size_t capacity, const size_t write_size )
+{
+  SPSCByteStream bs { capacity };
+  string output_data;
+  output_data.reserve( data.size() );
+
+  const auto start_time = steady_clock::now();
+  thread reader { [&] {
+    while ( true ) {
+      bs.wait_until_readable();
+      if ( bs.is_finished() ) {
+        break;
+      }
+      for ( const auto span : bs.peek_spans() ) {
+        output_data += span;
+      }
+      bs.pop( bs.bytes_buffered() );
+    }
+  } };
+
+  for ( size_t pushed = 0; pushed < data.size(); ) {
+    bs.wait_until_writable();
+    pushed += bs.push( string_view( data ).substr( pushed, write_size ) );
+  }
+  bs.close();
+  reader.join();
+  const auto stop_time = steady_clock::now();
+
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read through SPSCByteStream" );
+  }
+
+  report( "SPSCByteStream handoff with capacity=" + to_string( capacity )
+            + ", write_size=" + to_string( write_size ),
+          data.size(),
+          duration_cast<duration<double>>( stop_time - start_time ) );
+}
+
+void socketpair_speed_test( const string& data, const size_t write_size )
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "socketpair", ::socketpair( AF_UNIX, SOCK_STREAM, 0, fds.data() ) );
+  LocalStreamSocket owner_end { FileDescriptor { fds[0] } };
+  LocalStreamSocket thread_end { FileDescriptor { fds[1] } };
+  string output_data;
+  output_data.reserve( data.size() );
+
+  const auto start_time = steady_clock::now();
+  thread reader { [&] {
+    string buffer;
+    while ( not thread_end.eof() ) {
+      buffer.resize( 65536 );
+      thread_end.read( buffer );
+      output_data += buffer;
+    }
+  } };
+
+  for ( size_t pushed = 0; pushed < data.size(); ) {
+    pushed += owner_end.write( string_view( data ).substr( pushed, write_size ) );
+  }
+  owner_end.shutdown( SHUT_WR );
+  reader.join();
+  const auto stop_time = steady_clock::now();
+
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read through socketpair" );
+  }
+
+  report( "socketpair handoff with write_size=" + to_string( write_size ),
+          data.size(),
+          duration_cast<duration<double>>( stop_time - start_time ) );
+}
+
+void program_body()
+{
+  const string data = make_data( 2e8, 1370 );
+  for ( const size_t write_size : { 1500, 16384 } ) {
+    socketpair_speed_test( data, write_size );
+    spsc_speed_test( data, 65536, write_size );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,171 @@
+#include "exception.hh"
+#include "parser.hh"
+#include "random.hh"
+#include "tcp_minnow_socket_impl.hh"
+#include "tcp_over_ip.hh"
+
+#include <array>
+#include <exception>
+#include <iostream>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Carries the IPv4 datagrams of a TCP connection over one end of an AF_UNIX datagram socketpair
+class LocalDatagramAdapter : public TCPOverIPv4Adapter
+{
+  FileDescriptor socket_;
+  vector<string_view> datagram_ {};
+
+public:
+  explicit LocalDatagramAdapter( FileDescriptor&& socket ) : socket_( move( socket ) ) {}
+
+  optional<TCPMessage> read()
+  {
+    vector<string> strs( 2 );
+    strs.front().resize( IPv4Header::LENGTH );
+    socket_.read( strs );
+
+    InternetDatagram ip_dgram;
+    if ( parse( ip_dgram, move( strs ) ) ) {
+      return unwrap_tcp_in_ip( move( ip_dgram ) );
+    }
+    return {};
+  }
+
+  void write( const TCPMessage& msg )
+  {
+    wrap_tcp_in_ip( msg, [&]( const WireDatagram& dgram ) {
+      datagram_.assign( dgram.begin(), dgram.end() );
+      socket_.write( datagram_ );
+    } );
+  }
+
+  FileDescriptor& fd() { return socket_; }
+};
+
+static_assert( TCPDatagramAdapter<LocalDatagramAdapter> );
+
+using LocalMinnowSocket = TCPMinnowSocket<LocalDatagramAdapter>;
+
+// Push `data` to the outbound stream and pop the inbound stream until both are finished, sleeping on the
+// streams' wakeups whenever neither side can make progress
+static string send_and_receive( LocalMinnowSocket& socket, string_view data )
+{
+  SPSCByteStream& outbound = socket.outbound_stream();
+  SPSCByteStream& inbound = socket.inbound_stream();
+  string received;
+
+  while ( not inbound.is_finished() or not data.empty() ) {
+    if ( inbound.has_error() or outbound.has_error() ) {
+      throw runtime_error( "stream error" );
+    }
+
+    bool progress = false;
+    if ( not data.empty() ) {
+      const uint64_t pushed = outbound.push( data );
+      data.remove_prefix( pushed );
+      progress |= pushed > 0;
+    }
+    if ( data.empty() and not outbound.is_closed() ) {
+      outbound.close();
+    }
+    for ( const auto span : inbound.peek_spans() ) {
+      received.append( span );
+      progress |= not span.empty();
+    }
+    inbound.pop( inbound.bytes_buffered() );
+    if ( progress ) {
+      continue;
+    }
+
+    vector<pollfd> fds;
+    if ( not inbound.is_finished() ) {
+      inbound.arm_reader_wakeup();
+      fds.push_back( { inbound.reader_wakeup().fd_num(), POLLIN, 0 } );
+    }
+    if ( not data.empty() ) {
+      outbound.arm_writer_wakeup();
+      fds.push_back( { outbound.writer_wakeup().fd_num(), POLLIN, 0 } );
+    }
+    CheckSystemCall( "poll", ::poll( fds.data(), fds.size(), -1 ) );
+    if ( not inbound.is_finished() ) {
+      inbound.clear_reader_wakeup();
+    }
+    if ( not data.empty() ) {
+      outbound.clear_writer_wakeup();
+    }
+  }
+
+  return received;
+}
+
+static string random_string( size_t size )
+{
+  auto rd = get_random_engine();
+  string ret( size, 0 );
+  for ( auto& ch : ret ) {
+    ch = static_cast<char>( rd() );
+  }
+  return ret;
+}
+
+static void transfer_test( size_t client_bytes, size_t server_bytes, uint64_t handoff_capacity )
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "socketpair", ::socketpair( AF_UNIX, SOCK_DGRAM, 0, fds.data() ) );
+
+  LocalMinnowSocket client { LocalDatagramAdapter { FileDescriptor { fds[0] } } };
+  LocalMinnowSocket server { LocalDatagramAdapter { FileDescriptor { fds[1] } } };
+  client.use_spsc_handoff( handoff_capacity );
+  server.use_spsc_handoff( handoff_capacity );
+
+  TCPConfig cfg;
+  cfg.rt_timeout = 10; // the last one to finish lingers for 10 RTOs
+  FdAdapterConfig client_ad;
+  client_ad.source = Address { "10.0.0.1", 1234 };
+  client_ad.destination = Address { "10.0.0.2", 80 };
+  FdAdapterConfig server_ad;
+  server_ad.source = Address { "10.0.0.2", 80 };
+
+  const string client_data = random_string( client_bytes );
+  const string server_data = random_string( server_bytes );
+  string server_received;
+
+  thread server_thread { [&] {
+    server.listen_and_accept( cfg, server_ad );
+    server_received = send_and_receive( server, server_data );
+    server.wait_until_closed();
+  } };
+  client.connect( cfg, client_ad );
+  const string client_received = send_and_receive( client, client_data );
+  client.wait_until_closed();
+  server_thread.join();
+
+  if ( server_received != client_data ) {
+    throw runtime_error( "the server received " + to_string( server_received.size() ) + " bytes, expected "
+                         + to_string( client_data.size() ) );
+  }
+  if ( client_received != server_data ) {
+    throw runtime_error( "the client received " + to_string( client_received.size() ) + " bytes, expected "
+                         + to_string( server_data.size() ) );
+  }
+}
+
+int main()
+{
+  try {
+    transfer_test( 200000, 100000, TCPConfig::DEFAULT_CAPACITY );
+    transfer_test( 100000, 0, 1000 ); // the handoff streams wrap around many times
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
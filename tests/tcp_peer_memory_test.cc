@@ -0,0 +1,115 @@
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <malloc.h>
+#include <queue>
+#include <unistd.h>
+
+using namespace std;
+
+// resident memory of this process, after giving freed heap memory back to the kernel
+static size_t resident_bytes()
+{
+  malloc_trim( 0 );
+  size_t total_pages {};
+  size_t resident_pages {};
+  ifstream statm { "/proc/self/statm" };
+  statm >> total_pages >> resident_pages;
+  if ( not statm ) {
+    throw runtime_error( "could not read /proc/self/statm" );
+  }
+  return resident_pages * static_cast<size_t>( sysconf( _SC_PAGESIZE ) );
+}
+
+// deliver messages between two peers until neither has anything more to send
+static void exchange( TCPPeer& a, TCPPeer& b )
+{
+  queue<TCPMessage> to_a;
+  queue<TCPMessage> to_b;
+  const TCPPeer::TransmitFunction a_transmit = [&]( TCPMessage msg ) { to_b.push( move( msg ) ); };
+  const TCPPeer::TransmitFunction b_transmit = [&]( TCPMessage msg ) { to_a.push( move( msg ) ); };
+
+  a.push( a_transmit );
+  b.push( b_transmit );
+  while ( not to_a.empty() or not to_b.empty() ) {
+    while ( not to_b.empty() ) {
+      b.receive( move( to_b.front() ), b_transmit );
+      to_b.pop();
+    }
+    while ( not to_a.empty() ) {
+      a.receive( move( to_a.front() ), a_transmit );
+      to_a.pop();
+    }
+  }
+}
+
+void memory_test( const size_t num_pairs, const ByteStream::Storage storage, const string& storage_name )
+{
+  TCPConfig cfg;
+  cfg.stream_storage = storage;
+
+  const size_t baseline = resident_bytes();
+  deque<TCPPeer> peers;
+  for ( size_t i = 0; i < 2 * num_pairs; ++i ) {
+    peers.emplace_back( cfg );
+  }
+  const size_t after_construction = resident_bytes();
+
+  // each pair opens the connection and moves a full window one way, then goes idle
+  const string data( TCPConfig::DEFAULT_CAPACITY, 'x' );
+  for ( size_t i = 0; i < num_pairs; ++i ) {
+    TCPPeer& a = peers[2 * i];
+    TCPPeer& b = peers[2 * i + 1];
+    exchange( a, b );
+    a.outbound_writer().push( data );
+    exchange( a, b );
+    string received;
+    read( b.inbound_reader(), data.size(), received );
+    exchange( a, b );
+    if ( received != data ) {
+      throw runtime_error( "peer did not receive the data that was sent" );
+    }
+  }
+  const size_t after_traffic = resident_bytes();
+
+  for ( auto& peer : peers ) {
+    peer.tick( 1, [&]( const TCPMessage& ) {} ); // the peer notices that the streams stopped moving
+    peer.tick( cfg.idle_release_time, [&]( const TCPMessage& ) {} );
+  }
+  const size_t after_idle = resident_bytes();
+
+  const auto per_peer = [&]( size_t bytes ) {
+    return static_cast<double>( bytes > baseline ? bytes - baseline : 0 ) / static_cast<double>( peers.size() );
+  };
+
+  ofstream debug_output { "/dev/tty" };
+  for ( ostream* out : { static_cast<ostream*>( &cout ), static_cast<ostream*>( &debug_output ) } ) {
+    *out << "             " << storage_name << " storage, resident bytes per TCPPeer: " << fixed << setprecision( 0 )
+         << per_peer( after_construction ) << " new, " << per_peer( after_traffic ) << " after traffic, "
+         << per_peer( after_idle ) << " after " << cfg.idle_release_time << " ms idle\n";
+  }
+}
+
+void program_body()
+{
+  memory_test( 1000, ByteStream::Storage::Ring, "Ring" );
+  memory_test( 1000, ByteStream::Storage::Chunked, "Chunked" );
+  memory_test( 1000, ByteStream::Storage::Pooled, "Pooled" );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// A read-only slice of a reference-counted string. Copies and slices share the string instead of copying its bytes,
+// so a payload can be parsed out of a datagram, trimmed, retransmitted and queued in a ByteStream without being
+// copied. The string is freed with the last slice that refers to it.
+class Buffer
+{
+public:
+  Buffer() = default;
+
+  // Adopt `str` (implicitly, so a string can be passed wherever a Buffer is expected)
+  Buffer( std::string str ) // NOLINT(*-explicit-*)
+    : storage_( std::make_shared<std::string>( std::move( str ) ) ), size_( storage_->size() )
+  {}
+
+  const char* data() const { return storage_ ? storage_->data() + offset_ : nullptr; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  std::string_view view() const { return { data(), size_ }; }
+  operator std::string_view() const { return view(); } // NOLINT(*-explicit-*)
+  explicit operator std::string() const { return std::string( view() ); }
+
+  // A slice of this slice, sharing the same string
+  Buffer substr( size_t pos, size_t len = std::string::npos ) const
+  {
+    Buffer ret { *this };
+    ret.remove_prefix( std::min( pos, size_ ) );
+    ret.size_ = std::min( ret.size_, len );
+    return ret;
+  }
+
+  void remove_prefix( size_t len )
+  {
+    len = std::min( len, size_ );
+    offset_ += len;
+    size_ -= len;
+  }
+
+  void remove_suffix( size_t len ) { size_ -= std::min( len, size_ ); }
+
+  void clear() { *this = {}; }
+
+  // Bytes kept alive by this slice, whether it refers to them or not
+  size_t footprint() const { return storage_ ? storage_->capacity() : 0; }
+
+  // The bytes as a string of their own: moved out if this slice is all of a string that nothing else refers to,
+  // copied otherwise
+  std::string release() &&
+  {
+    if ( storage_ and storage_.use_count() == 1 and offset_ == 0 and size_ == storage_->size() ) {
+      std::string ret = std::move( *storage_ );
+      clear();
+      return ret;
+    }
+    std::string ret { view() };
+    clear();
+    return ret;
+  }
+
+  // Append `data` in place, if nothing else refers to the string, this slice runs to its end, and it has room for
+  // `data` without reallocating. Returns whether it did.
+  bool append_in_place( std::string_view data )
+  {
+    if ( not storage_ or storage_.use_count() != 1 or offset_ + size_ != storage_->size()
+         or data.size() > storage_->capacity() - storage_->size() ) {
+      return false;
+    }
+    storage_->append( data );
+    size_ += data.size();
+    return true;
+  }
+
+private:
+  std::shared_ptr<std::string> storage_ {};
+  size_t offset_ {};
+  size_t size_ {};
+};
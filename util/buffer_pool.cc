@@ -0,0 +1,158 @@
+#include "buffer_pool.hh"
+
+#include "exception.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sys/mman.h>
+#include <utility>
+
+using namespace std;
+
+BufferPool::BufferPool( size_t page_size ) : BufferPool( page_size, Options {} ) {}
+
+BufferPool::BufferPool( size_t page_size, Options options )
+  : page_size_( page_size )
+  , options_( options )
+  , slab_size_( ( max( page_size, kSlabSize ) + kSlabSize - 1 ) / kSlabSize * kSlabSize )
+{
+  if ( page_size_ == 0 ) {
+    throw runtime_error( "BufferPool: page size must be positive" );
+  }
+  stats_.page_size = page_size_;
+}
+
+BufferPool& BufferPool::global( size_t page_size )
+{
+  return global( page_size, Options {} );
+}
+
+BufferPool& BufferPool::global( size_t page_size, Options options )
+{
+  static mutex pools_mutex;
+  // never destroyed, so streams with static storage duration can still return their pages at exit
+  static auto* pools = new map<size_t, BufferPool*>; // NOLINT(*-owning-memory)
+
+  const lock_guard lock { pools_mutex };
+  auto& pool = ( *pools )[page_size];
+  if ( not pool ) {
+    pool = new BufferPool( page_size, options ); // NOLINT(*-owning-memory)
+  }
+  return *pool;
+}
+
+bool BufferPool::add_slab()
+{
+  void* slab = MAP_FAILED; // NOLINT(*-cstyle-cast, *-int-to-ptr)
+  if ( options_.huge_pages ) {
+    slab = ::mmap( nullptr, slab_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+  }
+  if ( slab == MAP_FAILED ) { // NOLINT(*-cstyle-cast, *-int-to-ptr)
+    slab = ::mmap( nullptr, slab_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if ( slab == MAP_FAILED ) { // NOLINT(*-cstyle-cast, *-int-to-ptr)
+      return false;
+    }
+    if ( options_.huge_pages ) {
+      ::madvise( slab, slab_size_, MADV_HUGEPAGE ); // only a hint: fine if transparent huge pages are disabled
+    }
+  }
+
+  slabs_.push_back( static_cast<char*>( slab ) );
+  const size_t num_pages = slab_size_ / page_size_;
+  free_pages_.reserve( stats_.pages_reserved + num_pages ); // so put() never allocates
+  // hand out the lowest addresses first
+  for ( size_t i = num_pages; i > 0; --i ) {
+    free_pages_.push_back( slabs_.back() + ( i - 1 ) * page_size_ );
+  }
+  stats_.pages_reserved += num_pages;
+  return true;
+}
+
+BufferPool::Page BufferPool::get()
+{
+  {
+    const lock_guard lock { mutex_ };
+    if ( stats_.pages_in_use < options_.max_pages and ( not free_pages_.empty() or add_slab() ) ) {
+      char* const data = free_pages_.back();
+      free_pages_.pop_back();
+      ++stats_.pages_in_use;
+      stats_.high_water_mark = max( stats_.high_water_mark, stats_.pages_in_use );
+      return { this, data, false };
+    }
+    ++stats_.allocation_failures;
+  }
+
+  return { this, new char[page_size_], true }; // NOLINT(*-owning-memory)
+}
+
+void BufferPool::put( Page& page )
+{
+  if ( page.from_heap_ ) {
+    delete[] page.data_; // NOLINT(*-owning-memory)
+    return;
+  }
+
+  const lock_guard lock { mutex_ };
+  free_pages_.push_back( page.data_ );
+  --stats_.pages_in_use;
+}
+
+BufferPool::Stats BufferPool::stats() const
+{
+  const lock_guard lock { mutex_ };
+  return stats_;
+}
+
+BufferPool::~BufferPool()
+{
+  if ( stats_.pages_in_use ) {
+    cerr << "Exception destructing BufferPool: " << stats_.pages_in_use << " pages still in use" << endl;
+  }
+  for ( char* slab : slabs_ ) {
+    ::munmap( slab, slab_size_ );
+  }
+}
+
+BufferPool::Page::Page( const Page& other )
+{
+  if ( other.pool_ ) {
+    *this = other.pool_->get();
+    memcpy( data_, other.data_, size() );
+  }
+}
+
+BufferPool::Page& BufferPool::Page::operator=( const Page& other )
+{
+  if ( this != &other ) {
+    *this = Page( other );
+  }
+  return *this;
+}
+
+BufferPool::Page::Page( Page&& other ) noexcept
+  : pool_( exchange( other.pool_, nullptr ) )
+  , data_( exchange( other.data_, nullptr ) )
+  , from_heap_( exchange( other.from_heap_, false ) )
+{}
+
+BufferPool::Page& BufferPool::Page::operator=( Page&& other ) noexcept
+{
+  if ( this != &other ) {
+    if ( pool_ ) {
+      pool_->put( *this );
+    }
+    pool_ = exchange( other.pool_, nullptr );
+    data_ = exchange( other.data_, nullptr );
+    from_heap_ = exchange( other.from_heap_, false );
+  }
+  return *this;
+}
+
+BufferPool::Page::~Page()
+{
+  if ( pool_ ) {
+    pool_->put( *this );
+  }
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+// A thread-safe pool of fixed-size pages, carved out of large slabs that are never given back to the allocator.
+// Buffers of many connections share the pool, so their memory stays in a few contiguous regions and freed pages
+// are reused right away instead of fragmenting the heap.
+class BufferPool
+{
+public:
+  static constexpr size_t kDefaultPageSize = 4096;
+  static constexpr size_t kSlabSize = 2 * 1024 * 1024; // pages are allocated from the system this much at a time
+
+  struct Options
+  {
+    size_t max_pages = std::numeric_limits<size_t>::max(); // limit on the pages in use at the same time
+    bool huge_pages = false;                                // back the slabs with huge pages if possible
+  };
+
+  struct Stats
+  {
+    size_t page_size {};
+    size_t pages_in_use {};        // pages handed out and not returned yet
+    size_t high_water_mark {};     // the most pages ever in use at the same time
+    size_t pages_reserved {};      // pages in all the slabs, whether in use or not
+    size_t allocation_failures {}; // pages that were handed out from the heap instead, see get()
+  };
+
+  // A page borrowed from a pool, given back when destroyed. Copying borrows a new page with the same contents.
+  class Page
+  {
+  public:
+    Page() = default;
+
+    char* data() { return data_; }
+    const char* data() const { return data_; }
+    size_t size() const { return pool_ ? pool_->page_size_ : 0; }
+
+    Page( const Page& other );
+    Page& operator=( const Page& other );
+    Page( Page&& other ) noexcept;
+    Page& operator=( Page&& other ) noexcept;
+    ~Page();
+
+  private:
+    friend class BufferPool;
+    Page( BufferPool* pool, char* data, bool from_heap ) : pool_( pool ), data_( data ), from_heap_( from_heap ) {}
+
+    BufferPool* pool_ {};
+    char* data_ {};
+    bool from_heap_ {};
+  };
+
+  explicit BufferPool( size_t page_size = kDefaultPageSize );
+  BufferPool( size_t page_size, Options options );
+
+  // The process-wide pool of pages of `page_size` bytes, created (with `options`) on first use
+  static BufferPool& global( size_t page_size = kDefaultPageSize );
+  static BufferPool& global( size_t page_size, Options options );
+
+  // Borrow a page. If the pool is at its limit or out of memory, the page comes from the heap instead (and the
+  // failure is counted), so this never fails short of the heap itself.
+  Page get();
+
+  size_t page_size() const { return page_size_; }
+  Stats stats() const;
+
+  // A pool owns its slabs in place, and all its pages must be returned before it is destroyed
+  BufferPool( const BufferPool& other ) = delete;
+  BufferPool& operator=( const BufferPool& other ) = delete;
+  BufferPool( BufferPool&& other ) = delete;
+  BufferPool& operator=( BufferPool&& other ) = delete;
+  ~BufferPool();
+
+private:
+  void put( Page& page );
+  bool add_slab(); // with `mutex_` held
+
+  const size_t page_size_;
+  const Options options_;
+  const size_t slab_size_;
+
+  mutable std::mutex mutex_ {};
+  std::vector<char*> slabs_ {};
+  std::vector<char*> free_pages_ {};
+  Stats stats_ {};
+};
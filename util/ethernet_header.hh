@@ -22,6 +22,8 @@ struct EthernetHeader
   static constexpr size_t LENGTH = 14;         //!< Ethernet header length in bytes
   static constexpr uint16_t TYPE_IPv4 = 0x800; //!< Type number for [IPv4](\ref rfc::rfc791)
   static constexpr uint16_t TYPE_ARP = 0x806;  //!< Type number for [ARP](\ref rfc::rfc826)
+  static constexpr size_t MTU = 1500;          //!< Largest payload of a standard frame
+  static constexpr size_t JUMBO_MTU = 9000;    //!< Largest payload of a jumbo frame, on links that carry them
 
   EthernetAddress dst;
   EthernetAddress src;
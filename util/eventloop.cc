@@ -78,6 +78,14 @@ void EventLoop::RuleHandle::cancel()
   }
 }
 
+void EventLoop::RuleHandle::set_armed( bool armed )
+{
+  const shared_ptr<BasicRule> rule_shared_ptr = rule_weak_ptr_.lock();
+  if ( rule_shared_ptr ) {
+    rule_shared_ptr->armed = armed;
+  }
+}
+
 // NOLINTBEGIN(*-cognitive-complexity)
 // NOLINTBEGIN(*-signed-bitwise)
 EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
@@ -94,7 +102,7 @@ EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
       }
 
       uint8_t iterations = 0;
-      while ( this_rule.interest() ) {
+      while ( this_rule.interested() ) {
         if ( iterations++ >= 128 ) {
           throw runtime_error( "EventLoop: busy wait detected: rule \""
                                + _rule_categories.at( this_rule.category_id ).name + "\" is still interested after "
@@ -143,7 +151,7 @@ EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
       continue;
     }
 
-    if ( this_rule.interest() ) {
+    if ( this_rule.interested() ) {
       pollfds.push_back( { this_rule.fd.fd_num(), static_cast<int16_t>( this_rule.direction ), 0 } );
       something_to_poll = true;
     } else {
@@ -208,7 +216,7 @@ EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
       const auto count_before = this_rule.service_count();
       this_rule.callback();
 
-      if ( count_before == this_rule.service_count() and ( not this_rule.fd.closed() ) and this_rule.interest() ) {
+      if ( count_before == this_rule.service_count() and ( not this_rule.fd.closed() ) and this_rule.interested() ) {
         throw runtime_error( "EventLoop: busy wait detected: rule \""
                              + _rule_categories.at( this_rule.category_id ).name
                              + "\" did not read/write fd and is still interested" );
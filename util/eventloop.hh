@@ -35,8 +35,11 @@ private:
     InterestT interest;
     CallbackT callback;
     bool cancel_requested {};
+    bool armed { true }; //!< Whether a rule without an interest function is interested, see RuleHandle::set_armed
 
     BasicRule( size_t s_category_id, InterestT s_interest, CallbackT s_callback );
+
+    bool interested() const { return interest ? interest() : armed; }
   };
 
   struct FDRule : public BasicRule
@@ -81,6 +84,11 @@ public:
     {}
 
     void cancel();
+
+    //! For a rule added without an interest function (`nullptr`): set whether it is interested. Such a rule is
+    //! armed and disarmed when its state changes (e.g. from ByteStream watermark callbacks), rather than having its
+    //! interest re-evaluated on every EventLoop::wait_next_event.
+    void set_armed( bool armed );
   };
 
   RuleHandle add_rule(
@@ -3,6 +3,7 @@
 #include "exception.hh"
 
 #include <algorithm>
+#include <array>
 #include <fcntl.h>
 #include <iostream>
 #include <stdexcept>
@@ -82,7 +83,8 @@ FileDescriptor FileDescriptor::duplicate() const
 // buffer is the string to be read into
 void FileDescriptor::read( string& buffer )
 {
-  if ( buffer.empty() ) {
+  const bool sized_here = buffer.empty();
+  if ( sized_here ) {
     buffer.resize( kReadBufferSize );
   }
 
@@ -106,6 +108,9 @@ void FileDescriptor::read( string& buffer )
   }
 
   buffer.resize( bytes_read );
+  if ( sized_here and buffer.capacity() / 2 > buffer.size() ) {
+    buffer.shrink_to_fit(); // slices of a short read would otherwise keep the whole read buffer alive
+  }
 }
 
 void FileDescriptor::read( vector<string>& buffers )
@@ -149,6 +154,38 @@ void FileDescriptor::read( vector<string>& buffers )
       remaining_size = 0;
     }
   }
+  if ( buffers.back().capacity() / 2 > buffers.back().size() ) {
+    buffers.back().shrink_to_fit(); // as in read( string& )
+  }
+}
+
+size_t FileDescriptor::read( span<char> first, span<char> second )
+{
+  const size_t total_size = first.size() + second.size();
+  if ( total_size == 0 ) {
+    return 0; // a zero-length read would look like EOF
+  }
+
+  array<iovec, 2> iovecs { iovec { first.data(), first.size() }, iovec { second.data(), second.size() } };
+  const ssize_t bytes_read = ::readv( fd_num(), iovecs.data(), second.empty() ? 1 : 2 );
+  if ( bytes_read < 0 ) {
+    if ( internal_fd_->non_blocking_ and ( errno == EAGAIN or errno == EINPROGRESS ) ) {
+      return 0;
+    }
+    throw unix_error { "readv" };
+  }
+
+  register_read();
+
+  if ( bytes_read == 0 ) {
+    internal_fd_->eof_ = true;
+  }
+
+  if ( bytes_read > static_cast<ssize_t>( total_size ) ) {
+    throw runtime_error( "read() read more than requested" );
+  }
+
+  return bytes_read;
 }
 
 size_t FileDescriptor::write( string_view buffer )
@@ -191,6 +228,27 @@ size_t FileDescriptor::write( const vector<string_view>& buffers )
   return bytes_written;
 }
 
+size_t FileDescriptor::write( string_view first, string_view second )
+{
+  const size_t total_size = first.size() + second.size();
+  array<iovec, 2> iovecs { iovec { const_cast<char*>( first.data() ), first.size() },   // NOLINT(*-const-cast)
+                           iovec { const_cast<char*>( second.data() ), second.size() } }; // NOLINT(*-const-cast)
+
+  const ssize_t bytes_written
+    = CheckSystemCall( "writev", ::writev( fd_num(), iovecs.data(), second.empty() ? 1 : 2 ) );
+  register_write();
+
+  if ( bytes_written == 0 and total_size != 0 ) {
+    throw runtime_error( "write returned 0 given non-empty input buffer" );
+  }
+
+  if ( bytes_written > static_cast<ssize_t>( total_size ) ) {
+    throw runtime_error( "write wrote more than length of input buffer" );
+  }
+
+  return bytes_written;
+}
+
 void FileDescriptor::set_blocking( bool blocking )
 {
   int flags = CheckSystemCall( "fcntl", fcntl( fd_num(), F_GETFL ) ); // NOLINT(*-vararg)
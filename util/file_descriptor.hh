@@ -3,6 +3,8 @@
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <span>
+#include <string_view>
 #include <vector>
 
 // A reference-counted handle to a file descriptor
@@ -65,11 +67,16 @@ public:
   void read( std::string& buffer );
   void read( std::vector<std::string>& buffers );
 
+  // Read into `first` and then `second` (e.g. the free space of a ring buffer) with one syscall
+  // returns number of bytes read
+  size_t read( std::span<char> first, std::span<char> second );
+
   // Attempt to write a buffer
   // returns number of bytes written
   size_t write( std::string_view buffer );
   size_t write( const std::vector<std::string_view>& buffers );
   size_t write( const std::vector<std::string>& buffers );
+  size_t write( std::string_view first, std::string_view second );
 
   // Close the underlying file descriptor
   void close() { internal_fd_->close(); }
@@ -0,0 +1,191 @@
+#include "mapped_file.hh"
+
+#include "exception.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <linux/magic.h>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+#include <utility>
+
+using namespace std;
+
+static size_t page_size()
+{
+  static const size_t size = CheckSystemCall( "sysconf", static_cast<int>( ::sysconf( _SC_PAGESIZE ) ) );
+  return size;
+}
+
+static string& configured_directory()
+{
+  static string dir;
+  return dir;
+}
+
+void MappedFile::set_directory( string dir )
+{
+  configured_directory() = move( dir );
+}
+
+string MappedFile::directory()
+{
+  if ( not configured_directory().empty() ) {
+    return configured_directory();
+  }
+  const char* env_dir = getenv( "MINNOW_SPILL_DIR" ); // NOLINT(*-mt-unsafe)
+  return env_dir ? env_dir : "/var/tmp";
+}
+
+static bool is_memory_fs( int fd )
+{
+  struct statfs fs {};
+  CheckSystemCall( "fstatfs", ::fstatfs( fd, &fs ) );
+  return fs.f_type == TMPFS_MAGIC or fs.f_type == RAMFS_MAGIC;
+}
+
+// open an unnamed file in `dir` that disappears when closed, or return -1
+static int open_temp_file_in( const string& dir )
+{
+  const int fd = ::open( dir.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600 ); // NOLINT(*-vararg, *-signed-bitwise)
+  if ( fd >= 0 ) {
+    return fd;
+  }
+
+  // file systems without O_TMPFILE: create a named file and unlink it right away
+  string name = dir + "/minnow-XXXXXX";
+  const int named_fd = ::mkostemp( name.data(), O_CLOEXEC );
+  if ( named_fd >= 0 ) {
+    CheckSystemCall( "unlink", ::unlink( name.c_str() ) );
+  }
+  return named_fd;
+}
+
+// open an unnamed file in the first of the directories that is not in memory
+static FileDescriptor open_temp_file()
+{
+  const char* tmpdir = getenv( "TMPDIR" ); // NOLINT(*-mt-unsafe)
+  const array<string, 4> dirs { MappedFile::directory(), "/var/tmp", tmpdir ? tmpdir : "", "/tmp" };
+
+  optional<FileDescriptor> in_memory;
+  string tried;
+  for ( auto dir = dirs.begin(); dir != dirs.end(); ++dir ) {
+    if ( dir->empty() or find( dirs.begin(), dir, *dir ) != dir ) {
+      continue; // not set, or already tried
+    }
+    tried += ( tried.empty() ? "" : ", " ) + *dir;
+    const int fd = open_temp_file_in( *dir );
+    if ( fd < 0 ) {
+      continue;
+    }
+    FileDescriptor file { fd };
+    if ( not is_memory_fs( fd ) ) {
+      return file;
+    }
+    if ( not in_memory ) {
+      in_memory = move( file );
+    }
+  }
+
+  if ( not in_memory ) {
+    throw runtime_error( "MappedFile: cannot create a file in any of " + tried );
+  }
+  static bool warned = false;
+  if ( not exchange( warned, true ) ) {
+    cerr << "Warning: MappedFile spills to a tmpfs, which saves no memory (set MINNOW_SPILL_DIR to a directory on "
+            "disk)\n";
+  }
+  return move( *in_memory );
+}
+
+MappedFile::MappedFile( size_t size )
+  : fd_( open_temp_file() )
+  , memory_backed_( is_memory_fs( fd_.fd_num() ) )
+  , size_( ( size + page_size() - 1 ) / page_size() * page_size() ), data_( nullptr )
+{
+  if ( size_ == 0 ) {
+    return;
+  }
+
+  CheckSystemCall( "ftruncate", ::ftruncate( fd_.fd_num(), static_cast<off_t>( size_ ) ) );
+  void* const mapping = ::mmap( nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_.fd_num(), 0 );
+  if ( mapping == MAP_FAILED ) { // NOLINT(*-cstyle-cast, *-int-to-ptr)
+    throw unix_error { "mmap" };
+  }
+  data_ = static_cast<char*>( mapping );
+}
+
+void MappedFile::page_out( size_t offset, size_t len )
+{
+  const size_t begin = ( offset + page_size() - 1 ) / page_size() * page_size();
+  const size_t end = ( offset + len ) / page_size() * page_size();
+  if ( begin >= end ) {
+    return;
+  }
+
+  // start writing the pages back, then unmap them: they stay in the page cache, and once clean the kernel can drop
+  // them at no cost (the next access reads them back from the file)
+  if ( not memory_backed_ ) {
+    CheckSystemCall( "sync_file_range",
+                     ::sync_file_range( fd_.fd_num(),
+                                        static_cast<off_t>( begin ),
+                                        static_cast<off_t>( end - begin ),
+                                        SYNC_FILE_RANGE_WRITE ) );
+  }
+  CheckSystemCall( "madvise", ::madvise( data_ + begin, end - begin, MADV_DONTNEED ) );
+}
+
+MappedFile::MappedFile( const MappedFile& other ) : MappedFile( other.size_ )
+{
+  if ( size_ ) {
+    memcpy( data_, other.data_, size_ );
+  }
+}
+
+MappedFile& MappedFile::operator=( const MappedFile& other )
+{
+  if ( this != &other ) {
+    *this = MappedFile( other );
+  }
+  return *this;
+}
+
+MappedFile::MappedFile( MappedFile&& other ) noexcept
+  : fd_( std::move( other.fd_ ) )
+  , memory_backed_( other.memory_backed_ )
+  , size_( exchange( other.size_, 0 ) )
+  , data_( exchange( other.data_, nullptr ) )
+{}
+
+MappedFile& MappedFile::operator=( MappedFile&& other ) noexcept
+{
+  if ( this != &other ) {
+    unmap();
+    fd_ = std::move( other.fd_ );
+    memory_backed_ = other.memory_backed_;
+    size_ = exchange( other.size_, 0 );
+    data_ = exchange( other.data_, nullptr );
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile()
+{
+  unmap();
+}
+
+void MappedFile::unmap()
+{
+  if ( data_ and ::munmap( data_, size_ ) < 0 ) {
+    cerr << "Exception destructing MappedFile: munmap failed" << endl;
+  }
+  data_ = nullptr;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "file_descriptor.hh"
+
+#include <cstddef>
+#include <string>
+
+// A temporary file (already unlinked) mapped shared into memory. Its pages are backed by the file rather than by
+// anonymous memory: the kernel can write them back and drop them under memory pressure, and page_out() does so
+// right away. Either way, touching them again transparently reads them back in.
+class MappedFile
+{
+public:
+  // Create a file of `size` bytes (rounded up to whole pages); it occupies no memory or disk until written
+  explicit MappedFile( size_t size );
+
+  char* data() { return data_; }
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  // Write back and drop from memory every whole page inside [offset, offset + len)
+  void page_out( size_t offset, size_t len );
+
+  // Where the files go: the directory set here, or else $MINNOW_SPILL_DIR, or else /var/tmp, which is on disk on
+  // most systems (unlike /tmp, often a tmpfs). A directory on a tmpfs or ramfs is passed over for the next one
+  // ($TMPDIR, then /tmp), since the pages of a file there are memory all the same; if they all are, the file goes
+  // in the first that works, with a warning. Set it before any MappedFile is created ("" restores the default).
+  static void set_directory( std::string dir );
+  static std::string directory();
+
+  // Is the file on a tmpfs or ramfs, so that paging it out saves no memory?
+  bool memory_backed() const { return memory_backed_; }
+
+  // Copying maps a new file with the same contents
+  MappedFile( const MappedFile& other );
+  MappedFile& operator=( const MappedFile& other );
+  MappedFile( MappedFile&& other ) noexcept;
+  MappedFile& operator=( MappedFile&& other ) noexcept;
+  ~MappedFile();
+
+private:
+  FileDescriptor fd_;
+  bool memory_backed_;
+  size_t size_;
+  char* data_;
+
+  void unmap();
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "buffer.hh"
+
 #include <algorithm>
 #include <concepts>
 #include <cstdint>
@@ -14,11 +16,12 @@
 
 class Parser
 {
+  // The input, as slices of the strings it was parsed from: removing a prefix moves the start of a slice instead
+  // of copying what is left
   class BufferList
   {
     uint64_t size_ {};
-    std::deque<std::string> buffer_ {};
-    uint64_t skip_ {};
+    std::deque<Buffer> buffer_ {};
 
   public:
     explicit BufferList( const std::vector<std::string>& buffers )
@@ -28,6 +31,13 @@ class Parser
       }
     }
 
+    explicit BufferList( std::vector<std::string>&& buffers )
+    {
+      for ( auto& x : buffers ) {
+        append( std::move( x ) );
+      }
+    }
+
     uint64_t size() const { return size_; }
     uint64_t serialized_length() const { return size(); }
     bool empty() const { return size_ == 0; }
@@ -37,74 +47,73 @@ class Parser
       if ( buffer_.empty() ) {
         throw std::runtime_error( "peek on empty BufferList" );
       }
-      return std::string_view { buffer_.front() }.substr( skip_ );
+      return buffer_.front();
     }
 
     void remove_prefix( uint64_t len )
     {
       while ( len and not buffer_.empty() ) {
-        const uint64_t to_pop_now = std::min( len, peek().size() );
-        skip_ += to_pop_now;
+        const uint64_t to_pop_now = std::min( len, static_cast<uint64_t>( buffer_.front().size() ) );
+        buffer_.front().remove_prefix( to_pop_now );
         len -= to_pop_now;
         size_ -= to_pop_now;
-        if ( skip_ == buffer_.front().size() ) {
+        if ( buffer_.front().empty() ) {
           buffer_.pop_front();
-          skip_ = 0;
         }
       }
     }
 
+    void dump_all( std::vector<Buffer>& out )
+    {
+      out.assign( std::make_move_iterator( buffer_.begin() ), std::make_move_iterator( buffer_.end() ) );
+      buffer_.clear();
+      size_ = 0;
+    }
+
     void dump_all( std::vector<std::string>& out )
     {
+      std::vector<Buffer> slices;
+      dump_all( slices );
       out.clear();
-      if ( empty() ) {
-        return;
-      }
-      std::string first_str = std::move( buffer_.front() );
-      if ( skip_ ) {
-        first_str = first_str.substr( skip_ );
-      }
-      out.emplace_back( std::move( first_str ) );
-      buffer_.pop_front();
-      for ( auto&& x : buffer_ ) {
-        out.emplace_back( std::move( x ) );
+      for ( auto&& x : slices ) {
+        out.emplace_back( std::move( x ).release() );
       }
     }
 
-    void dump_all( std::string& out )
+    void dump_all( Buffer& out )
     {
-      std::vector<std::string> concat;
-      dump_all( concat );
-      if ( concat.size() == 1 ) {
-        out = std::move( concat.front() );
+      std::vector<Buffer> slices;
+      dump_all( slices );
+      if ( slices.size() == 1 ) {
+        out = std::move( slices.front() );
         return;
       }
 
-      out.clear();
-      for ( const auto& s : concat ) {
-        out.append( s );
+      std::string concat;
+      for ( const auto& s : slices ) {
+        concat.append( s );
       }
+      out = std::move( concat );
+    }
+
+    void dump_all( std::string& out )
+    {
+      Buffer all;
+      dump_all( all );
+      out = std::move( all ).release();
     }
 
     std::vector<std::string_view> buffer() const
     {
-      if ( empty() ) {
-        return {};
-      }
-      std::vector<std::string_view> ret;
-      ret.reserve( buffer_.size() );
-      auto tmp_skip = skip_;
-      for ( const auto& x : buffer_ ) {
-        ret.push_back( std::string_view { x }.substr( tmp_skip ) );
-        tmp_skip = 0;
-      }
-      return ret;
+      return { buffer_.begin(), buffer_.end() };
     }
 
-    void append( std::string str )
+    void append( Buffer str )
     {
       size_ += str.size();
-      buffer_.push_back( std::move( str ) );
+      if ( not str.empty() ) {
+        buffer_.push_back( std::move( str ) );
+      }
     }
   };
 
@@ -120,6 +129,7 @@ class Parser
 
 public:
   explicit Parser( const std::vector<std::string>& input ) : input_( input ) {}
+  explicit Parser( std::vector<std::string>&& input ) : input_( std::move( input ) ) {} // adopts the strings
 
   const BufferList& input() const { return input_; }
 
@@ -166,6 +176,7 @@ public:
 
   void all_remaining( std::vector<std::string>& out ) { input_.dump_all( out ); }
   void all_remaining( std::string& out ) { input_.dump_all( out ); }
+  void all_remaining( Buffer& out ) { input_.dump_all( out ); } // shares the input's strings
   std::vector<std::string_view> buffer() const { return input_.buffer(); }
 };
 
@@ -197,6 +208,8 @@ public:
     }
   }
 
+  void buffer( const Buffer& buf ) { buffer( std::string( buf ) ); }
+
   void buffer( const std::vector<std::string>& bufs )
   {
     for ( const auto& b : bufs ) {
@@ -236,3 +249,12 @@ bool parse( T& obj, const std::vector<std::string>& buffers, Targs&&... Fargs )
   obj.parse( p, std::forward<Targs>( Fargs )... );
   return not p.has_error();
 }
+
+// Same, adopting the strings rather than copying them, so whatever is parsed out of them can share them
+template<class T, typename... Targs>
+bool parse( T& obj, std::vector<std::string>&& buffers, Targs&&... Fargs )
+{
+  Parser p { std::move( buffers ) };
+  obj.parse( p, std::forward<Targs>( Fargs )... );
+  return not p.has_error();
+}
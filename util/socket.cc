@@ -136,6 +136,9 @@ void DatagramSocket::recv( Address& source_address, string& payload )
   register_read();
   source_address = { datagram_source_address, fromlen };
   payload.resize( recv_len );
+  if ( payload.capacity() / 2 > payload.size() ) {
+    payload.shrink_to_fit(); // slices of a small datagram would otherwise keep the whole receive buffer alive
+  }
 }
 
 void DatagramSocket::sendto( const Address& destination, const string_view payload )
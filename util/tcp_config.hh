@@ -1,8 +1,12 @@
 #pragma once
 
 #include "address.hh"
+#include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "ethernet_header.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <optional>
@@ -11,15 +15,99 @@
 class TCPConfig
 {
 public:
-  static constexpr size_t DEFAULT_CAPACITY = 64000; //!< Default capacity
-  static constexpr size_t MAX_PAYLOAD_SIZE = 1000;  //!< Conservative max payload size for real Internet
-  static constexpr uint16_t TIMEOUT_DFLT = 1000;    //!< Default re-transmit timeout is 1 second
-  static constexpr unsigned MAX_RETX_ATTEMPTS = 8;  //!< Maximum re-transmit attempts before giving up
-
-  uint16_t rt_timeout = TIMEOUT_DFLT;      //!< Initial value of the retransmission timeout, in milliseconds
-  size_t recv_capacity = DEFAULT_CAPACITY; //!< Receive capacity, in bytes
-  size_t send_capacity = DEFAULT_CAPACITY; //!< Sender capacity, in bytes
-  Wrap32 isn { 137 };                      //!< Default initial sequence number
+  static constexpr size_t DEFAULT_CAPACITY = 64000;   //!< Default capacity
+  static constexpr size_t MAX_PAYLOAD_SIZE = 1000;    //!< Conservative max payload size for real Internet
+  static constexpr uint16_t DEFAULT_MSS = 536;        //!< MSS to assume if the peer's SYN has none (RFC 9293)
+  static constexpr uint16_t MIN_MSS = 88;            //!< Smallest MSS taken from the peer's SYN (as Linux has it)
+  static constexpr size_t HEADERS_SIZE = 40;          //!< IPv4 and TCP headers, without options
+  static constexpr uint64_t MTU_PROBE_STEP = 32;      //!< Path MTU search stops once it is narrower than this
+  static constexpr unsigned MAX_MTU_PROBES = 3;       //!< Probes of a size lost before the search gives it up
+  static constexpr uint16_t TIMEOUT_DFLT = 1000;      //!< Default re-transmit timeout is 1 second
+  static constexpr uint64_t TIMEOUT_MIN_DFLT = 200;   //!< Default lower bound of the measured timeout
+  static constexpr uint64_t TIMEOUT_MAX_DFLT = 60000; //!< Default upper bound of the measured timeout is 1 minute
+  static constexpr unsigned MAX_RETX_ATTEMPTS = 8;    //!< Maximum re-transmit attempts before giving up
+  static constexpr unsigned DUP_ACK_THRESHOLD = 3;    //!< Duplicate acks that tell a segment was lost
+  static constexpr uint64_t MAX_ACK_DELAY = 200;      //!< Longest a receiver may hold back an ack (RFC 1122)
+  static constexpr uint64_t ACK_DELAY_DFLT = 40;      //!< Default delay of the ack of in-order data
+  static constexpr uint8_t MAX_WINDOW_SHIFT = 14;     //!< Largest window scale (RFC 7323): windows up to 1 GiB
+  static constexpr uint64_t IDLE_RELEASE_DFLT = 5000; //!< Default idle time before freeing buffers is 5 seconds
+  static constexpr size_t GSO_MAX_SIZE = 65536;       //!< Largest payload left to the adapter to cut up
+
+  uint16_t rt_timeout = TIMEOUT_DFLT;         //!< Initial value of the retransmission timeout, in milliseconds
+  uint64_t rt_timeout_min = TIMEOUT_MIN_DFLT; //!< The timeout follows the round-trip time, within these bounds
+  uint64_t rt_timeout_max = TIMEOUT_MAX_DFLT; //!< (equal bounds keep it fixed, besides exponential back-off)
+  size_t recv_capacity = DEFAULT_CAPACITY;    //!< Receive capacity, in bytes
+  size_t send_capacity = DEFAULT_CAPACITY;    //!< Sender capacity, in bytes
+  uint64_t ack_delay = ACK_DELAY_DFLT;        //!< Hold back the ack of in-order data this long, 0 to ack at once
+  Wrap32 isn { 137 };                         //!< Default initial sequence number
+
+  //! How the sender limits what it has in flight besides the receiver's window
+  CongestionControl::Algorithm congestion_control = CongestionControl::Algorithm::NewReno;
+
+  //! Retransmit a segment after three duplicate acks for it, without waiting for the timeout
+  bool fast_retransmit = true;
+
+  //! Offer SACK on the SYN; if the peer does too, report and make use of the ranges that arrived out of order
+  bool sack = true;
+
+  //! Also find losses by when segments were sent (RACK), and probe for a lost tail before the timeout (TLP)
+  bool rack_tlp = true;
+
+  //! Offer window scaling on the SYN, so that windows can reach recv_capacity if the peer's SYN offers it too
+  bool window_scaling = true;
+
+  //! The MTU of the link (EthernetHeader::JUMBO_MTU with jumbo frames): the SYN offers it, less the headers, as MSS
+  size_t mtu = EthernetHeader::MTU;
+
+  //! Send MAX_PAYLOAD_SIZE at first, and probe for larger segments up to the peer's MSS (RFC 4821 PLPMTUD);
+  //! without, send segments as large as the peer's MSS and hope they fit the path
+  bool mtu_probing = true;
+
+  //! Put a timestamp on every segment, and echo the peer's, if both SYNs have one: round trips are measured
+  //! on every ack, retransmissions included, and old duplicates are told apart from new data (RFC 7323 PAWS)
+  bool timestamps = true;
+
+  //! Spread new segments over the round trip, rather than send all that the windows allow as soon as an ack
+  //! opens them: the sender keeps to `pacing_rate`, releasing segments as time passes
+  bool pacing = false;
+
+  //! The pacing rate, in bytes per second; 0 to follow the congestion window per smoothed round trip
+  //! (twice that in slow start, 1.2 times after)
+  uint64_t pacing_rate = 0;
+
+  //! Hand runs of full-sized segments to the adapter as one, of up to GSO_MAX_SIZE bytes, for it to cut up into
+  //! the segments that go on the wire (generic segmentation offload): the headers are built once for the run
+  bool gso = false;
+
+  //! The window scale to offer: the least shift that brings recv_capacity within 16 bits, if window_scaling is on
+  std::optional<uint8_t> window_shift() const
+  {
+    if ( not window_scaling ) {
+      return std::nullopt;
+    }
+    uint8_t shift = 0;
+    while ( shift < MAX_WINDOW_SHIFT and ( recv_capacity >> shift ) > UINT16_MAX ) {
+      ++shift;
+    }
+    return shift;
+  }
+
+  //! The MSS to offer
+  uint16_t mss() const { return static_cast<uint16_t>( std::min<size_t>( mtu - HEADERS_SIZE, UINT16_MAX ) ); }
+
+  //! Storage of the inbound and outbound streams. A Ring takes reads from the socket and the SPSC handoff in
+  //! place, with no allocation per read; Chunked adopts the strings handed over instead, which pays off only when
+  //! they are sized to their contents
+  ByteStream::Storage stream_storage = ByteStream::Storage::Ring;
+
+  //! With Ring or Mapped storage, reassemble out-of-order bytes straight into the inbound stream's buffer
+  bool reassemble_in_place = false;
+
+  //! With Pooled storage, the streams and the Reassembler borrow pages of this size from the global BufferPool
+  size_t pool_page_size = BufferPool::kDefaultPageSize;
+
+  //! Free the memory of an empty stream that has not been pushed to or popped from for this long, in milliseconds
+  uint64_t idle_release_time = IDLE_RELEASE_DFLT;
 };
 
 //! Config for classes derived from FdAdapter
@@ -4,12 +4,14 @@
 #include "eventloop.hh"
 #include "file_descriptor.hh"
 #include "socket.hh"
+#include "spsc_byte_stream.hh"
 #include "tcp_config.hh"
 #include "tcp_peer.hh"
 #include "tuntap_adapter.hh"
 
 #include <atomic>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <thread>
 #include <vector>
@@ -58,6 +60,20 @@ public:
   // Return peer address from underlying datagram adapter
   const Address& peer_address() const { return _datagram_adapter.config().destination; }
 
+  //! Hand bytes to and from the TCPPeer thread through lock-free SPSCByteStreams instead of through this socket.
+  //! The owner then pushes to outbound_stream() and pops from inbound_stream() rather than calling write()
+  //! and read(), and closes outbound_stream() to end the outbound stream.
+  //! \note Must be called before connect() or listen_and_accept().
+  void use_spsc_handoff( uint64_t capacity = TCPConfig::DEFAULT_CAPACITY );
+
+  //! \name
+  //! Streams shared with the TCPPeer thread, only valid after use_spsc_handoff()
+
+  //!@{
+  SPSCByteStream& outbound_stream() { return *_spsc_outbound; } //!< owner pushes, TCPPeer thread pops
+  SPSCByteStream& inbound_stream() { return *_spsc_inbound; }   //!< TCPPeer thread pushes, owner pops
+  //!@}
+
 protected:
   //! Adapter to underlying datagram socket (e.g., UDP or IP)
   AdaptT _datagram_adapter;
@@ -66,6 +82,13 @@ private:
   //! Stream socket for reads and writes between owner and TCP thread
   LocalStreamSocket _thread_data;
 
+  //! Replace _thread_data when the owner asked for use_spsc_handoff()
+  std::unique_ptr<SPSCByteStream> _spsc_outbound {};
+  std::unique_ptr<SPSCByteStream> _spsc_inbound {};
+
+  //! Move bytes between the SPSCByteStreams and the TCPPeer
+  void _spsc_handoff();
+
   //! Set up the TCPPeer and the event loop
   void _initialize_TCP( const TCPConfig& config );
 
@@ -4,6 +4,7 @@
 #include "parser.hh"
 #include "tun.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <exception>
 #include <iostream>
@@ -39,6 +40,10 @@ void TCPMinnowSocket<AdaptT>::_tcp_loop( const std::function<bool()>& condition
       throw std::runtime_error( "_tcp_loop entered before TCPPeer initialized" );
     }
 
+    if ( _spsc_outbound ) {
+      _spsc_handoff();
+    }
+
     if ( _tcp.value().active() ) {
       const auto next_time = timestamp_ms();
       _tcp.value().tick( next_time - base_time, [&]( auto x ) { _datagram_adapter.write( x ); } );
@@ -91,7 +96,8 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
       }
 
       // debugging output:
-      if ( _thread_data.eof() and _tcp.value().sender().sequence_numbers_in_flight() == 0 and not _fully_acked ) {
+      const bool owner_finished = _spsc_outbound ? _spsc_outbound->is_finished() : _thread_data.eof();
+      if ( owner_finished and _tcp.value().sender().sequence_numbers_in_flight() == 0 and not _fully_acked ) {
         std::cerr << "DEBUG: minnow outbound stream to " << _datagram_adapter.config().destination.to_string()
                   << " has been fully acknowledged.\n";
         _fully_acked = true;
@@ -99,16 +105,46 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     },
     [&] { return _tcp->active(); } );
 
+  if ( _spsc_outbound ) {
+    // rules 2 and 3 with SPSCByteStreams: _tcp_loop moves the bytes after every event, these rules only
+    // wake the thread up when the owner pushed or popped something that lets it make progress
+
+    _eventloop.add_rule(
+      "wake up for outbound bytes",
+      _spsc_outbound->reader_wakeup(),
+      Direction::In,
+      [&] { _spsc_outbound->clear_reader_wakeup(); },
+      [&] {
+        if ( not _tcp->active() or _outbound_shutdown or _tcp->outbound_writer().available_capacity() == 0 ) {
+          return false;
+        }
+        _spsc_outbound->arm_reader_wakeup();
+        return true;
+      } );
+
+    _eventloop.add_rule(
+      "wake up for room to deliver inbound bytes",
+      _spsc_inbound->writer_wakeup(),
+      Direction::In,
+      [&] { _spsc_inbound->clear_writer_wakeup(); },
+      [&] {
+        if ( _inbound_shutdown or _tcp->inbound_reader().bytes_buffered() == 0 ) {
+          return false;
+        }
+        _spsc_inbound->arm_writer_wakeup();
+        return true;
+      } );
+
+    return;
+  }
+
   // rule 2: read from pipe into outbound buffer
   _eventloop.add_rule(
     "push bytes to TCPPeer",
     _thread_data,
     Direction::In,
     [&] {
-      std::string data;
-      data.resize( _tcp->outbound_writer().available_capacity() );
-      _thread_data.read( data );
-      _tcp->outbound_writer().push( move( data ) );
+      _tcp->outbound_writer().read_from( _thread_data );
 
       if ( _thread_data.eof() ) {
         _tcp->outbound_writer().close();
@@ -146,11 +182,7 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
       // Write from the inbound_stream into
       // the pipe, handling the possibility of a partial
       // write (i.e., only pop what was actually written).
-      if ( inbound.bytes_buffered() ) {
-        const std::string_view buffer = inbound.peek();
-        const auto bytes_written = _thread_data.write( buffer );
-        inbound.pop( bytes_written );
-      }
+      inbound.write_to( _thread_data );
 
       if ( inbound.is_finished() or inbound.has_error() ) {
         _thread_data.shutdown( SHUT_WR );
@@ -173,6 +205,74 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     } );
 }
 
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::_spsc_handoff()
+{
+  if ( not _outbound_shutdown ) {
+    Writer& outbound = _tcp->outbound_writer();
+    const uint64_t before = outbound.bytes_pushed();
+    while ( _spsc_outbound->bytes_buffered() and outbound.available_capacity() ) {
+      // copy into the outbound stream's free space: in place for a Ring or Mapped stream (the default), while
+      // a Chunked or Pooled one stages the chunk in a string of its own
+      const std::string_view buffer = _spsc_outbound->peek().substr( 0, outbound.available_capacity() );
+      const auto regions = outbound.reserve( buffer.size() );
+      std::copy( buffer.begin(), buffer.begin() + regions[0].size(), regions[0].begin() );
+      std::copy( buffer.begin() + regions[0].size(), buffer.end(), regions[1].begin() );
+      outbound.commit( buffer.size() );
+      _spsc_outbound->pop( buffer.size() );
+    }
+
+    if ( _spsc_outbound->has_error() ) {
+      std::cerr << "DEBUG: minnow outbound stream had error.\n";
+      outbound.set_error();
+    }
+
+    if ( _spsc_outbound->is_finished() ) {
+      outbound.close();
+      _outbound_shutdown = true;
+
+      // debugging output:
+      std::cerr << "DEBUG: minnow outbound stream to " << _datagram_adapter.config().destination.to_string()
+                << " finished (" << _tcp.value().sender().sequence_numbers_in_flight() << " seqno"
+                << ( _tcp.value().sender().sequence_numbers_in_flight() == 1 ? "" : "s" ) << " still in flight).\n";
+    }
+
+    if ( outbound.bytes_pushed() != before or _outbound_shutdown ) {
+      _tcp->push( [&]( auto x ) { _datagram_adapter.write( x ); } );
+    }
+  }
+
+  if ( not _inbound_shutdown ) {
+    Reader& inbound = _tcp->inbound_reader();
+    while ( inbound.bytes_buffered() and _spsc_inbound->available_capacity() ) {
+      inbound.pop( _spsc_inbound->push( inbound.peek() ) );
+    }
+
+    if ( inbound.is_finished() or inbound.has_error() ) {
+      if ( inbound.has_error() ) {
+        _spsc_inbound->set_error();
+      }
+      _spsc_inbound->close();
+      _inbound_shutdown = true;
+
+      // debugging output:
+      std::cerr << "DEBUG: minnow inbound stream from " << _datagram_adapter.config().destination.to_string()
+                << " finished " << ( inbound.has_error() ? "uncleanly.\n" : "cleanly.\n" );
+    }
+  }
+}
+
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::use_spsc_handoff( uint64_t capacity )
+{
+  if ( _tcp ) {
+    throw std::runtime_error( "use_spsc_handoff() with TCPConnection already initialized" );
+  }
+
+  _spsc_outbound = std::make_unique<SPSCByteStream>( capacity );
+  _spsc_inbound = std::make_unique<SPSCByteStream>( capacity );
+}
+
 //! \brief Call [socketpair](\ref man2::socketpair) and return connected Unix-domain sockets of specified type
 //! \param[in] type is the type of AF_UNIX sockets to create (e.g., SOCK_SEQPACKET)
 //! \returns a std::pair of connected sockets
@@ -210,6 +310,9 @@ template<TCPDatagramAdapter AdaptT>
 void TCPMinnowSocket<AdaptT>::wait_until_closed()
 {
   shutdown( SHUT_RDWR );
+  if ( _spsc_outbound ) {
+    _spsc_outbound->close();
+  }
   if ( _tcp_thread.joinable() ) {
     std::cerr << "DEBUG: minnow waiting for clean shutdown... ";
     _tcp_thread.join();
@@ -282,6 +385,13 @@ void TCPMinnowSocket<AdaptT>::_tcp_main()
     }
     _tcp_loop( [] { return true; } );
     shutdown( SHUT_RDWR );
+    if ( _spsc_inbound and not _inbound_shutdown ) {
+      _spsc_handoff();
+      if ( not _inbound_shutdown ) { // the TCPPeer never finished the inbound stream
+        _spsc_inbound->set_error();
+        _spsc_inbound->close();
+      }
+    }
     if ( not _tcp.value().active() ) {
       std::cerr << "DEBUG: minnow TCP connection finished "
                 << ( _tcp->inbound_reader().has_error() ? "uncleanly.\n" : "cleanly.\n" );
@@ -1,10 +1,13 @@
 #include "tcp_over_ip.hh"
 
+#include "checksum.hh"
 #include "ipv4_datagram.hh"
 #include "ipv4_header.hh"
 #include "parser.hh"
 
+#include <algorithm>
 #include <arpa/inet.h>
+#include <cstdint>
 #include <stdexcept>
 #include <unistd.h>
 #include <utility>
@@ -23,7 +26,7 @@ using namespace std;
 //! `_listen` flag and records the source and destination addresses and port numbers
 //! from the TCP header; it uses this information to filter future reads.
 //! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
-optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip( const InternetDatagram& ip_dgram )
+optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip( InternetDatagram ip_dgram )
 {
   // is the IPv4 datagram for us?
   // Note: it's valid to bind to address "0" (INADDR_ANY) and reply from actual address contacted
@@ -41,9 +44,9 @@ optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip( const InternetDatagra
     return {};
   }
 
-  // is the payload a valid TCP segment?
+  // is the payload a valid TCP segment? (its payload then shares the datagram's strings)
   TCPSegment tcp_seg;
-  if ( not parse( tcp_seg, ip_dgram.payload, ip_dgram.header.pseudo_checksum() ) ) {
+  if ( not parse( tcp_seg, std::move( ip_dgram.payload ), ip_dgram.header.pseudo_checksum() ) ) {
     return {};
   }
 
@@ -85,7 +88,7 @@ InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip( const TCPMessage& msg )
   InternetDatagram ip_dgram;
   ip_dgram.header.src = config().source.ipv4_numeric();
   ip_dgram.header.dst = config().destination.ipv4_numeric();
-  ip_dgram.header.len = ip_dgram.header.hlen * 4 + 20 /* tcp header len */ + seg.message.sender.payload.size();
+  ip_dgram.header.len = ip_dgram.header.hlen * 4 + seg.header_length() + seg.message.sender.payload.size();
 
   // set payload, calculating TCP checksum using information from IP header
   seg.compute_checksum( ip_dgram.header.pseudo_checksum() );
@@ -94,3 +97,105 @@ InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip( const TCPMessage& msg )
 
   return ip_dgram;
 }
+
+//! \details The headers are serialized once, into templates: every datagram but the last is the same size, so
+//! they share the IPv4 header, checksum included, and differ in the TCP header only by their seqno, FIN flag and
+//! checksum. The TCP checksum of the rest of the headers (and the pseudo-header) is computed once as well, so that
+//! each datagram only adds its seqno, flags and payload to it; the payload is not copied.
+void TCPOverIPv4Adapter::wrap_tcp_in_ip( const TCPMessage& msg,
+                                         const function<void( const WireDatagram& )>& output )
+{
+  static constexpr size_t SeqnoOffset = 4; // in the TCP header
+  static constexpr size_t FlagsOffset = 13;
+  static constexpr size_t ChecksumOffset = 16;
+  static constexpr uint8_t FlagFIN = 0b0000'0001;
+
+  const TCPSenderMessage& sender = msg.sender;
+  const string_view payload = sender.payload;
+  const size_t step = ( sender.gso_size == 0 or sender.SYN ) ? payload.size() : sender.gso_size;
+
+  // the TCP header, without FIN or checksum, and with its seqno taken out
+  TCPSegment seg { .message = msg };
+  seg.message.sender.payload.clear();
+  seg.message.sender.FIN = false;
+  seg.udinfo.src_port = config().source.port();
+  seg.udinfo.dst_port = config().destination.port();
+  seg.udinfo.cksum = 0;
+  tcp_header_.clear();
+  Serializer tcp_serializer { std::move( tcp_header_ ) };
+  seg.serialize( tcp_serializer );
+  tcp_header_ = std::move( tcp_serializer.output().front() );
+  uint32_t first_seqno = 0;
+  for ( size_t i = 0; i < 4; ++i ) {
+    first_seqno = ( first_seqno << 8 ) | static_cast<uint8_t>( tcp_header_[SeqnoOffset + i] );
+    tcp_header_[SeqnoOffset + i] = 0;
+  }
+
+  IPv4Header ip;
+  ip.src = config().source.ipv4_numeric();
+  ip.dst = config().destination.ipv4_numeric();
+  InternetChecksum headers_sum; // the TCP checksum of the pseudo-header and the TCP header template
+  size_t headers_for = SIZE_MAX; // the payload size that the IPv4 header template and `headers_sum` are for
+
+  size_t offset = 0;
+  do {
+    const size_t size = min( step, payload.size() - offset );
+    const bool last = offset + size == payload.size();
+    if ( size != headers_for ) {
+      ip.len = ip.hlen * 4 + tcp_header_.size() + size;
+      ip.compute_checksum();
+      ip_header_.clear();
+      Serializer ip_serializer { std::move( ip_header_ ) };
+      ip.serialize( ip_serializer );
+      ip_header_ = std::move( ip_serializer.output().front() );
+      fill_n( tcp_header_.begin() + SeqnoOffset, 4, 0 ); // the last datagram's share, if there was one
+      fill_n( tcp_header_.begin() + ChecksumOffset, 2, 0 );
+      headers_sum = InternetChecksum { ip.pseudo_checksum() };
+      headers_sum.add( tcp_header_ );
+      headers_for = size;
+    }
+
+    // this datagram's share: its seqno, its flags, and its payload
+    const uint32_t seqno = first_seqno + static_cast<uint32_t>( offset );
+    for ( size_t i = 0; i < 4; ++i ) {
+      tcp_header_[SeqnoOffset + i] = static_cast<char>( seqno >> ( 24 - 8 * i ) );
+    }
+    const bool FIN = sender.FIN and last;
+    tcp_header_[FlagsOffset] = static_cast<char>( static_cast<uint8_t>( tcp_header_[FlagsOffset] ) & ~FlagFIN );
+    tcp_header_[FlagsOffset] |= static_cast<char>( FIN ? FlagFIN : 0 );
+
+    InternetChecksum check = headers_sum;
+    check.add( string_view( tcp_header_ ).substr( SeqnoOffset, 4 ) );
+    if ( FIN ) {
+      check.add( string_view( "\0\1", 2 ) );
+    }
+    const string_view piece = payload.substr( offset, size );
+    check.add( piece );
+    const uint16_t cksum = check.value();
+    tcp_header_[ChecksumOffset] = static_cast<char>( cksum >> 8 );
+    tcp_header_[ChecksumOffset + 1] = static_cast<char>( cksum );
+
+    output( { ip_header_, tcp_header_, piece } );
+    offset += size;
+  } while ( offset < payload.size() );
+}
+
+//! \details Each datagram gets a TCP segment of its own, with its share of the payload, its seqno, and the FIN flag
+//! if it is the last, and is wrapped as wrap_tcp_in_ip() wraps a single segment.
+void TCPOverIPv4Adapter::wrap_tcp_in_datagrams( const TCPMessage& msg,
+                                                const function<void( const InternetDatagram& )>& output )
+{
+  const TCPSenderMessage& sender = msg.sender;
+  const size_t step = ( sender.gso_size == 0 or sender.SYN ) ? sender.payload.size() : sender.gso_size;
+
+  size_t offset = 0;
+  do {
+    TCPMessage segment = msg;
+    segment.sender.payload = sender.payload.substr( offset, step );
+    segment.sender.seqno = sender.seqno + static_cast<uint32_t>( offset );
+    segment.sender.FIN = sender.FIN and offset + segment.sender.payload.size() == sender.payload.size();
+    segment.sender.gso_size = 0;
+    output( wrap_tcp_in_ip( segment ) );
+    offset += segment.sender.payload.size();
+  } while ( offset < sender.payload.size() );
+}
@@ -4,13 +4,33 @@
 #include "ipv4_datagram.hh"
 #include "tcp_segment.hh"
 
+#include <array>
+#include <functional>
 #include <optional>
+#include <string>
+#include <string_view>
 
 //! \brief A converter from TCP segments to serialized IPv4 datagrams
 class TCPOverIPv4Adapter : public FdAdapterBase
 {
 public:
-  std::optional<TCPMessage> unwrap_tcp_in_ip( const InternetDatagram& ip_dgram );
+  std::optional<TCPMessage> unwrap_tcp_in_ip( InternetDatagram ip_dgram );
 
   InternetDatagram wrap_tcp_in_ip( const TCPMessage& msg );
+
+  //! A serialized datagram, in three parts: the IPv4 header, the TCP header and the payload
+  using WireDatagram = std::array<std::string_view, 3>;
+
+  //! Wraps a TCP segment in the datagrams that carry it, and hands each to `output` (the views last until it
+  //! returns): one datagram, or if the sender left it to the adapter to cut the payload up (gso_size), one per
+  //! gso_size bytes of payload
+  void wrap_tcp_in_ip( const TCPMessage& msg, const std::function<void( const WireDatagram& )>& output );
+
+  //! Wraps a TCP segment in the same datagrams, but hands each to `output` as an InternetDatagram, for a caller
+  //! that routes datagrams rather than writing their bytes (the payload is shared, not copied)
+  void wrap_tcp_in_datagrams( const TCPMessage& msg, const std::function<void( const InternetDatagram& )>& output );
+
+private:
+  std::string ip_header_ {};  //!< Templates for the datagrams wrap_tcp_in_ip() hands out, reused across calls
+  std::string tcp_header_ {};
 };
@@ -7,6 +7,7 @@
 #include "tcp_sender.hh"
 #include "tcp_sender_message.hh"
 
+#include <algorithm>
 #include <functional>
 #include <optional>
 
@@ -32,6 +33,11 @@ public:
   {
     cumulative_time_ += t;
     sender_.tick( t, make_send( transmit ) );
+    if ( ack_due_.has_value() and cumulative_time_ >= ack_due_.value() ) {
+      send( sender_.make_empty_message(), transmit );
+    }
+    release_idle_buffer( outbound_writer(), outbound_idle_ );
+    release_idle_buffer( inbound_reader(), inbound_idle_ );
   }
   bool has_ackno() const { return receiver_.send().ackno.has_value(); }
 
@@ -56,26 +62,54 @@ public:
     // Record time in case this peer has to linger after streams finish.
     time_of_last_receipt_ = cumulative_time_;
 
-    // If SenderMessage occupies a sequence number, make sure to reply.
-    need_send_ |= ( msg.sender.sequence_length() > 0 );
-
     // If SenderMessage is a "keep-alive" (with intentionally invalid seqno), make sure to reply.
     // (N.B. orthodox TCP rules require a reply on any unacceptable segment.)
     const auto our_ackno = receiver_.send().ackno;
     need_send_ |= ( our_ackno.has_value() and msg.sender.seqno + 1 == our_ackno.value() );
 
+    // If SenderMessage occupies a sequence number, make sure to reply: at once, unless it is in-order data
+    // that the ack can wait for (RFC 1122 and RFC 5681)
+    const bool in_order = our_ackno.has_value() and msg.sender.seqno == our_ackno.value()
+                          and not receiver_.reassembler().bytes_pending();
+    const bool delayable = cfg_.ack_delay > 0 and in_order and not msg.sender.SYN and not msg.sender.FIN;
+    const size_t payload_size = msg.sender.payload.size();
+    const bool occupies_seqno = msg.sender.sequence_length() > 0;
+    const bool syn = msg.sender.SYN;
+    const auto window_scale = msg.sender.window_scale;
+    const bool timestamp = msg.sender.timestamp.has_value();
+    const auto mss = msg.sender.mss;
+
     // Did the inbound stream finish before the outbound stream? If so, no need to linger after streams finish.
-    if ( receiver_.writer().is_closed() and not sender_.reader().is_finished() ) {
+    if ( receiver_.writer().is_closed() and not sender_.is_input_sent() ) {
       linger_after_streams_finish_ = false;
     }
 
     // Give incoming TCPSenderMessage to receiver.
     receiver_.receive( std::move( msg.sender ) );
 
+    if ( occupies_seqno and ( not delayable or receiver_.reassembler().bytes_pending() ) ) {
+      need_send_ = true;
+    } else if ( occupies_seqno ) {
+      // ack every second full segment, or the first one once it has waited long enough
+      unacked_bytes_ += payload_size;
+      rcv_mss_ = std::max( rcv_mss_, payload_size );
+      if ( unacked_bytes_ >= 2 * rcv_mss_ ) {
+        need_send_ = true;
+      } else if ( not ack_due_.has_value() ) {
+        ack_due_ = cumulative_time_ + cfg_.ack_delay;
+      }
+    }
+
     // Give incoming TCPReceiverMessage to sender.
+    // (The window that comes with a SYN is never scaled; the ones after it are, if both SYNs offered to.)
     sender_.receive( msg.receiver );
+    if ( syn ) {
+      sender_.set_peer_window_scale( window_scale );
+      sender_.set_peer_timestamps( timestamp );
+      sender_.set_peer_mss( mss );
+    }
 
-    // Send reply if needed.
+    // Send reply if needed (any segment pushed carries the ack).
     push( transmit );
     if ( need_send_ ) {
       send( sender_.make_empty_message(), transmit );
@@ -88,16 +122,64 @@ public:
 
 private:
   TCPConfig cfg_;
-  TCPSender sender_ { ByteStream { cfg_.send_capacity }, cfg_.isn, cfg_.rt_timeout };
-  TCPReceiver receiver_ { Reassembler { ByteStream { cfg_.recv_capacity } } };
+  TCPSender sender_ { ByteStream { cfg_.send_capacity, cfg_.stream_storage, pool( cfg_ ) }, cfg_ };
+  TCPReceiver receiver_ {
+    Reassembler { ByteStream { cfg_.recv_capacity, cfg_.stream_storage, pool( cfg_ ) },
+                  cfg_.reassemble_in_place ? Reassembler::Mode::InPlace : Reassembler::Mode::Intervals,
+                  pool( cfg_ ) },
+    cfg_.sack,
+    cfg_.window_shift(),
+    cfg_.timestamps };
+
+  // The pool that the streams and the Reassembler borrow from, if any
+  static BufferPool* pool( const TCPConfig& cfg )
+  {
+    return cfg.stream_storage == ByteStream::Storage::Pooled ? &BufferPool::global( cfg.pool_page_size ) : nullptr;
+  }
 
   bool need_send_ {};
 
+  // Delayed ack: in-order bytes not acknowledged yet, and when their ack is due at the latest
+  uint64_t unacked_bytes_ {};
+  std::optional<uint64_t> ack_due_ {};
+  size_t rcv_mss_ { TCPConfig::DEFAULT_MSS }; // the largest segment received: what "full" means
+
   void send( const TCPSenderMessage& sender_message, const TransmitFunction& transmit )
   {
-    TCPMessage msg { sender_message, receiver_.send() };
+    // the window that goes with our SYN is never scaled, the ones after it are (if both SYNs offered to)
+    TCPMessage msg { sender_message, receiver_.send( sender_message.SYN ) };
+    if ( sender_message.SYN ) {
+      receiver_.syn_sent();
+    }
+    receiver_.ack_sent( msg.receiver );
     transmit( std::move( msg ) );
     need_send_ = false;
+    unacked_bytes_ = 0;
+    ack_due_.reset();
+  }
+
+  // When a stream was last seen busy, judging by its byte counts, and whether its buffer was released since
+  struct IdleState
+  {
+    uint64_t pushed {};
+    uint64_t popped {};
+    uint64_t since {};
+    bool released {};
+  };
+  IdleState outbound_idle_ {};
+  IdleState inbound_idle_ {};
+
+  void release_idle_buffer( ByteStream& stream, IdleState& idle ) const
+  {
+    const uint64_t pushed = stream.writer().bytes_pushed();
+    const uint64_t popped = stream.reader().bytes_popped();
+    if ( pushed != idle.pushed or popped != idle.popped ) {
+      idle = { pushed, popped, cumulative_time_, false };
+    } else if ( not idle.released and pushed == popped
+                and cumulative_time_ - idle.since >= cfg_.idle_release_time ) {
+      stream.release_buffer();
+      idle.released = true;
+    }
   }
 
   bool linger_after_streams_finish_ { true }; // one peer may need to linger to make sure all closure conditions met
@@ -2,26 +2,40 @@
 
 #include "wrapping_integers.hh"
 
+#include <cstddef>
 #include <optional>
+#include <utility>
+#include <vector>
 
 /*
  * The TCPReceiverMessage structure contains the information sent from a TCP receiver to its sender.
  *
- * It contains three fields:
+ * It contains five fields:
  *
  * 1) The acknowledgment number (ackno): the *next* sequence number needed by the TCP Receiver.
  *    This is an optional field that is empty if the TCPReceiver hasn't yet received the Initial Sequence Number.
  *
  * 2) The window size. This is the number of sequence numbers that the TCP receiver is interested
  *    to receive, starting from the ackno if present. The maximum value is 65,535 (UINT16_MAX from
- *    the <cstdint> header).
+ *    the <cstdint> header), shifted left by the window scale if both SYNs offered one (RFC 7323).
  *
  * 3) The RST (reset) flag. If set, the stream has suffered an error and the connection should be aborted.
+ *
+ * 4) The SACK blocks (RFC 2018): ranges [begin, end) of sequence numbers past the ackno that the receiver
+ *    already holds, the one with the segment that prompted this message first. Empty unless both peers' SYNs
+ *    had the SACK-permitted option.
+ *
+ * 5) The timestamp echo (RFC 7323 TSecr): the timestamp of the latest segment that advanced the ackno (or
+ *    arrived in order). Present if both SYNs had a timestamp.
  */
 
 struct TCPReceiverMessage
 {
+  static constexpr size_t MAX_SACK_BLOCKS = 4; // as many as fit in the TCP header's options (3 with timestamps)
+
   std::optional<Wrap32> ackno {};
   uint16_t window_size {};
   bool RST {};
+  std::vector<std::pair<Wrap32, Wrap32>> sack {};
+  std::optional<uint32_t> timestamp_echo {};
 };
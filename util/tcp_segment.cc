@@ -2,12 +2,81 @@
 #include "checksum.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
 #include <cstddef>
 
 static constexpr uint32_t TCPHeaderMinLen = 5; // 32-bit words
 
+// option kinds
+static constexpr uint8_t TCPOptionEnd = 0;
+static constexpr uint8_t TCPOptionNOP = 1;
+static constexpr uint8_t TCPOptionMSS = 2;           // RFC 9293
+static constexpr uint8_t TCPOptionWindowScale = 3;   // RFC 7323
+static constexpr uint8_t TCPOptionSACKPermitted = 4; // RFC 2018
+static constexpr uint8_t TCPOptionSACK = 5;
+static constexpr uint8_t TCPOptionTimestamps = 8;    // RFC 7323
+
 using namespace std;
 
+// read the options that fill `size` bytes after the fixed part of the header
+static void parse_options( Parser& parser, uint64_t size, TCPMessage& message )
+{
+  while ( size > 0 and not parser.has_error() ) {
+    uint8_t kind {};
+    parser.integer( kind );
+    size--;
+    if ( kind == TCPOptionEnd ) {
+      parser.remove_prefix( size );
+      return;
+    }
+    if ( kind == TCPOptionNOP ) {
+      continue;
+    }
+
+    uint8_t len {};
+    if ( size > 0 ) {
+      parser.integer( len );
+      size--;
+    }
+    if ( len < 2 or len - 2U > size ) {
+      parser.set_error();
+      return;
+    }
+    size -= len - 2U;
+
+    if ( kind == TCPOptionWindowScale and len == 3 ) {
+      uint8_t shift {};
+      parser.integer( shift );
+      message.sender.window_scale = shift;
+    } else if ( kind == TCPOptionMSS and len == 4 ) {
+      uint16_t mss {};
+      parser.integer( mss );
+      message.sender.mss = mss;
+    } else if ( kind == TCPOptionTimestamps and len == 10 ) {
+      uint32_t value {};
+      uint32_t echo {};
+      parser.integer( value );
+      parser.integer( echo );
+      message.sender.timestamp = value;
+      if ( message.receiver.ackno.has_value() ) {
+        message.receiver.timestamp_echo = echo; // only meaningful with ACK
+      }
+    } else if ( kind == TCPOptionSACKPermitted and len == 2 ) {
+      message.sender.SACK_permitted = true;
+    } else if ( kind == TCPOptionSACK and ( len - 2 ) % 8 == 0 ) {
+      for ( unsigned i = 0; i < ( len - 2U ) / 8; ++i ) {
+        uint32_t begin {};
+        uint32_t end {};
+        parser.integer( begin );
+        parser.integer( end );
+        message.receiver.sack.emplace_back( Wrap32 { begin }, Wrap32 { end } );
+      }
+    } else {
+      parser.remove_prefix( len - 2U ); // an option this implementation doesn't know
+    }
+  }
+}
+
 void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum )
 {
   /* verify checksum */
@@ -47,11 +116,12 @@ void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum
   parser.integer( udinfo.cksum );
   parser.integer( raw16 ); // urgent pointer
 
-  // skip any options or anything extra in the header
+  // read the options this implementation knows, and skip the others
   if ( data_offset < TCPHeaderMinLen ) {
     parser.set_error();
+    return;
   }
-  parser.remove_prefix( data_offset * 4 - TCPHeaderMinLen * 4 );
+  parse_options( parser, data_offset * 4 - TCPHeaderMinLen * 4, message );
 
   parser.all_remaining( message.sender.payload );
 }
@@ -62,13 +132,50 @@ public:
   uint32_t raw_value() const { return raw_value_; }
 };
 
+// which options a message's segment carries, and how much room they take
+struct OptionsLayout
+{
+  bool mss;
+  bool window_scale;
+  bool sack_permitted;
+  bool timestamps;
+  size_t sack_blocks;
+  size_t size;    // in bytes
+  size_t padding; // NOPs that align them to 32 bits
+};
+
+static OptionsLayout options_layout( const TCPMessage& message )
+{
+  OptionsLayout layout {};
+  layout.mss = message.sender.SYN and message.sender.mss.has_value();
+  layout.window_scale = message.sender.SYN and message.sender.window_scale.has_value();
+  layout.sack_permitted = message.sender.SYN and message.sender.SACK_permitted;
+  layout.timestamps = message.sender.timestamp.has_value() or message.receiver.timestamp_echo.has_value();
+  layout.sack_blocks
+    = min( message.receiver.sack.size(), TCPReceiverMessage::MAX_SACK_BLOCKS - ( layout.timestamps ? 1 : 0 ) );
+  layout.size = ( layout.mss ? 4 : 0 ) + ( layout.window_scale ? 3 : 0 ) + ( layout.sack_permitted ? 2 : 0 )
+                + ( layout.timestamps ? 10 : 0 ) + ( layout.sack_blocks ? 2 + 8 * layout.sack_blocks : 0 );
+  layout.padding = ( 4 - layout.size % 4 ) % 4;
+  return layout;
+}
+
+size_t TCPSegment::header_length() const
+{
+  const OptionsLayout layout = options_layout( message );
+  return TCPHeaderMinLen * 4 + layout.size + layout.padding;
+}
+
 void TCPSegment::serialize( Serializer& serializer ) const
 {
+  const auto [mss, window_scale, sack_permitted, timestamps, sack_blocks, options_size, padding]
+    = options_layout( message );
+  const auto data_offset = static_cast<uint8_t>( TCPHeaderMinLen + ( options_size + padding ) / 4 );
+
   serializer.integer( udinfo.src_port );
   serializer.integer( udinfo.dst_port );
   serializer.integer( Wrap32Serializable { message.sender.seqno }.raw_value() );
   serializer.integer( Wrap32Serializable { message.receiver.ackno.value_or( Wrap32 { 0 } ) }.raw_value() );
-  serializer.integer( uint8_t { TCPHeaderMinLen << 4 } ); // data offset
+  serializer.integer( static_cast<uint8_t>( data_offset << 4 ) );
   const bool reset = message.sender.RST or message.receiver.RST;
   const uint8_t flags = ( message.receiver.ackno.has_value() ? 0b0001'0000U : 0 ) | ( reset ? 0b0000'0100U : 0 )
                         | ( message.sender.SYN ? 0b0000'0010U : 0 ) | ( message.sender.FIN ? 0b0000'0001U : 0 );
@@ -76,6 +183,40 @@ void TCPSegment::serialize( Serializer& serializer ) const
   serializer.integer( message.receiver.window_size );
   serializer.integer( udinfo.cksum );
   serializer.integer( uint16_t { 0 } ); // urgent pointer
+
+  // options, after NOPs that align them to 32 bits
+  for ( size_t i = 0; i < padding; ++i ) {
+    serializer.integer( TCPOptionNOP );
+  }
+  if ( mss ) {
+    serializer.integer( TCPOptionMSS );
+    serializer.integer( uint8_t { 4 } );
+    serializer.integer( message.sender.mss.value() );
+  }
+  if ( window_scale ) {
+    serializer.integer( TCPOptionWindowScale );
+    serializer.integer( uint8_t { 3 } );
+    serializer.integer( message.sender.window_scale.value() );
+  }
+  if ( sack_permitted ) {
+    serializer.integer( TCPOptionSACKPermitted );
+    serializer.integer( uint8_t { 2 } );
+  }
+  if ( timestamps ) {
+    serializer.integer( TCPOptionTimestamps );
+    serializer.integer( uint8_t { 10 } );
+    serializer.integer( message.sender.timestamp.value_or( 0 ) );
+    serializer.integer( message.receiver.timestamp_echo.value_or( 0 ) );
+  }
+  if ( sack_blocks ) {
+    serializer.integer( TCPOptionSACK );
+    serializer.integer( static_cast<uint8_t>( 2 + 8 * sack_blocks ) );
+    for ( size_t i = 0; i < sack_blocks; ++i ) {
+      serializer.integer( Wrap32Serializable { message.receiver.sack[i].first }.raw_value() );
+      serializer.integer( Wrap32Serializable { message.receiver.sack[i].second }.raw_value() );
+    }
+  }
+
   serializer.buffer( message.sender.payload );
 }
 
@@ -20,4 +20,7 @@ struct TCPSegment
   void serialize( Serializer& serializer ) const;
 
   void compute_checksum( uint32_t datagram_layer_pseudo_checksum );
+
+  // The length of the header, options included
+  size_t header_length() const;
 };
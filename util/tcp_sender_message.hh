@@ -1,13 +1,16 @@
 #pragma once
 
+#include "buffer.hh"
 #include "wrapping_integers.hh"
 
+#include <cstdint>
+#include <optional>
 #include <string>
 
 /*
  * The TCPSenderMessage structure contains the information sent from a TCP sender to its receiver.
  *
- * It contains five fields:
+ * It contains ten fields:
  *
  * 1) The sequence number (seqno) of the beginning of the segment. If the SYN flag is set, this is the
  *    sequence number of the SYN flag. Otherwise, it's the sequence number of the beginning of the payload.
@@ -15,11 +18,26 @@
  * 2) The SYN flag. If set, this segment is the beginning of the byte stream, and the seqno field
  *    contains the Initial Sequence Number (ISN) -- the zero point.
  *
- * 3) The payload: a substring (possibly empty) of the byte stream.
+ * 3) The payload: a substring (possibly empty) of the byte stream, shared by copies of the message.
  *
  * 4) The FIN flag. If set, the payload represents the ending of the byte stream.
  *
  * 5) The RST (reset) flag. If set, the stream has suffered an error and the connection should be aborted.
+ *
+ * 6) The SACK-permitted flag. Only meaningful with SYN: if set, the sender can make use of SACK blocks.
+ *
+ * 7) The window scale (RFC 7323). Only meaningful with SYN: if present, the sender's peer understands
+ *    scaled windows, and the windows it advertises itself will be shifted left by this many bits.
+ *
+ * 8) The timestamp (RFC 7323 TSval): the sender's clock when it sent the segment, in milliseconds. Present on
+ *    every segment if both SYNs had one; the receiver echoes it back for the sender to measure round trips.
+ *
+ * 9) The maximum segment size (MSS). Only meaningful with SYN: if present, how many bytes of payload and
+ *    options the sender's peer may put in a segment; 536 if absent (RFC 9293 and RFC 6691).
+ *
+ * 10) The GSO size. Not sent on the wire: if nonzero, the segment is larger than the path carries, and the
+ *     adapter that wraps it in datagrams cuts its payload up into segments of this many bytes (the last one may be
+ *     shorter), each with the same headers but its own seqno, and the FIN flag on the last.
  */
 
 struct TCPSenderMessage
@@ -27,17 +45,27 @@ struct TCPSenderMessage
   Wrap32 seqno { 0 };
 
   bool SYN { false };
-  std::string payload {};
+  Buffer payload {};
   bool FIN { false };
 
   bool RST { false };
 
+  bool SACK_permitted { false };
+  std::optional<uint8_t> window_scale {};
+  std::optional<uint32_t> timestamp {};
+  std::optional<uint16_t> mss {};
+  uint16_t gso_size { 0 };
+
   // How many sequence numbers does this segment use?
   size_t sequence_length() const { return SYN + payload.size() + FIN; }
 
   void reset()
   {
-    SYN = FIN = RST = false;
+    SYN = FIN = RST = SACK_permitted = false;
+    window_scale.reset();
+    timestamp.reset();
+    mss.reset();
+    gso_size = 0;
     payload.clear();
     return;
   }
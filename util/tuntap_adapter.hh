@@ -5,8 +5,10 @@
 #include "tun.hh"
 
 #include <optional>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 template<class T>
 concept TCPDatagramAdapter = requires( T a, TCPMessage seg ) {
@@ -24,6 +26,7 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter
 {
 private:
   TunFD _tun;
+  std::vector<std::string_view> _datagram {}; //!< The parts of the datagram being written
 
 public:
   //! Construct from a TunFD
@@ -32,8 +35,14 @@ public:
   //! Attempts to read and parse an IPv4 datagram containing a TCP segment related to the current connection
   std::optional<TCPMessage> read();
 
-  //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-  void write( const TCPMessage& seg ) { _tun.write( serialize( wrap_tcp_in_ip( seg ) ) ); }
+  //! Creates the IPv4 datagrams that carry a TCP segment and writes them to the TUN device, one by one
+  void write( const TCPMessage& seg )
+  {
+    wrap_tcp_in_ip( seg, [&]( const WireDatagram& dgram ) {
+      _datagram.assign( dgram.begin(), dgram.end() );
+      _tun.write( _datagram );
+    } );
+  }
 
   //! Access the underlying TUN device
   explicit operator TunFD&() { return _tun; }